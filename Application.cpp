@@ -1,5 +1,7 @@
 #include "Application.h"
 #include "TerritoryParser.h"
+#include "MapRegistry.h"
+#include "ZoneClipboard.h"
 #include "imgui.h"
 #include "imgui_internal.h"
 #include "imgui_impl_glfw.h"
@@ -10,9 +12,13 @@
 #include <iostream>
 #include <algorithm>
 #include <cstring>
+#include <cstdio>
 #include <cmath>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <chrono>
+#include <fstream>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -21,18 +27,11 @@
 
 Application::Application() {
     // Initialize available maps
-    MapInfo chernarus;
-    chernarus.name = "Chernarus";
-    chernarus.worldSizeX = 15360.0f;
-    chernarus.worldSizeZ = 15360.0f;
-    chernarus.imagePath = "Maps/chernarusplus_Map.png";
-    availableMaps_.push_back(chernarus);
+    if (!MapRegistry::LoadFromFile(MapRegistry::DefaultPath(), availableMaps_)) {
+        availableMaps_ = MapRegistry::GetBuiltInMaps();
+    }
     
-    MapInfo livonia;
-    livonia.name = "Livonia";
-    livonia.worldSizeX = 12800.0f;
-    livonia.worldSizeZ = 12800.0f;
-    availableMaps_.push_back(livonia);
+    SelectionRegionStore::LoadFromFile(SelectionRegionStore::DefaultPath(), savedRegions_);
 }
 
 Application::~Application() {
@@ -40,6 +39,9 @@ Application::~Application() {
 }
 
 bool Application::Initialize() {
+    // Workers first; loading, decoding and validation all run on them
+    JobSystem::Start();
+    
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW\n";
@@ -63,6 +65,7 @@ bool Application::Initialize() {
     
     // Initialize ImGui
     IMGUI_CHECKVERSION();
+    MemoryStats::InstallImGuiAllocator();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
@@ -75,22 +78,43 @@ bool Application::Initialize() {
     ImGui_ImplGlfw_InitForOpenGL(window_, true);
     ImGui_ImplOpenGL3_Init("#version 330");
     
-    // Load the default map image
+    // Select the default map; its imagery is decoded in the background on first draw
     if (!availableMaps_.empty()) {
         mapView_.SetMapInfo(availableMaps_[0]);
-        if (!availableMaps_[0].imagePath.empty()) {
-            mapView_.LoadMapImage(availableMaps_[0].imagePath);
-        }
+    }
+    
+    // Offer to recover the previous session before the journal gets overwritten
+    if (EditJournal::HasRecoverableSession(EditJournal::DefaultPath())) {
+        showRecoveryPrompt_ = true;
+    } else {
+        StartJournal(true);
     }
     
     return true;
 }
 
 void Application::Shutdown() {
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-    glfwTerminate();
+    CancelLoad();
+    fileWatcher_.Stop();
+    recorder_.Stop();
+    // Finishes queued jobs (a reload or simulation may still write into members) and frees
+    // decodes waiting for the main thread
+    JobSystem::Stop();
+    // Keep the journal around if there is anything worth recovering
+    journal_.Stop(documentModified_);
+    
+    // A headless replay has no window or backends, and shutting down twice must be harmless
+    if (window_) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+    }
+    if (ImGui::GetCurrentContext()) {
+        ImGui::DestroyContext();
+    }
+    if (window_) {
+        glfwTerminate();
+        window_ = nullptr;
+    }
 }
 
 void Application::Run() {
@@ -100,59 +124,13 @@ void Application::Run() {
         // Start ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
+        recorder_.CaptureFrame();
         ImGui::NewFrame();
         
-        // Enable docking
-        ImGuiID dockspace_id = ImGui::DockSpaceOverViewport();
-        
-        // Set up initial docking layout on first run
-        if (!dockingInitialized_) {
-            dockingInitialized_ = true;
-            ImGui::DockBuilderRemoveNode(dockspace_id); // Clear any existing layout
-            ImGui::DockBuilderAddNode(dockspace_id, ImGuiDockNodeFlags_DockSpace);
-            ImGui::DockBuilderSetNodeSize(dockspace_id, ImGui::GetMainViewport()->Size);
-            
-            // Split the dockspace
-            ImGuiID dock_id_left = ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Left, 0.2f, nullptr, &dockspace_id);
-            ImGuiID dock_id_right = ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Right, 0.25f, nullptr, &dockspace_id);
-            ImGuiID dock_id_center = dockspace_id; // The remaining center area
-            
-            // Dock the windows
-            ImGui::DockBuilderDockWindow("Territory Hierarchy", dock_id_left);
-            ImGui::DockBuilderDockWindow("Map View", dock_id_center);
-            ImGui::DockBuilderDockWindow("Inspector", dock_id_right);
-            
-            ImGui::DockBuilderFinish(dockspace_id);
-        }
-        
-        // Render menu bar
-        if (ImGui::BeginMainMenuBar()) {
-            if (ImGui::BeginMenu("File")) {
-                if (ImGui::MenuItem("Open...", "Ctrl+O")) {
-                    OpenFileDialog();
-                }
-                if (ImGui::MenuItem("Save", "Ctrl+S")) {
-                    if (!currentFilePath_.empty()) {
-                        TerritoryParser::SaveToFile(currentFilePath_, territoryData_);
-                    }
-                }
-                if (ImGui::MenuItem("Save As...", "Ctrl+Shift+S")) {
-                    // TODO: File dialog
-                }
-                ImGui::Separator();
-                if (ImGui::MenuItem("Exit")) {
-                    glfwSetWindowShouldClose(window_, true);
-                }
-                ImGui::EndMenu();
-            }
-            ImGui::EndMainMenuBar();
-        }
-        
-        HandleInput();
-        RenderUI();
+        FrameTimes times;
+        UpdateFrame(times);
         
         // Render
-        ImGui::Render();
         int displayW, displayH;
         glfwGetFramebufferSize(window_, &displayW, &displayH);
         glViewport(0, 0, displayW, displayH);
@@ -173,6 +151,251 @@ void Application::Run() {
     }
 }
 
+bool Application::LoadFileBlocking(const std::string& filePath) {
+    LoadFile(filePath);
+    loadFuture_.wait();
+    PollLoad();
+    return fileLoaded_ && currentFilePath_ == filePath;
+}
+
+bool Application::StartRecording(const std::string& path) {
+    if (!recorder_.Start(path)) {
+        std::cerr << "Failed to create recording: " << path << std::endl;
+        return false;
+    }
+    // Match the replay setup: the default layout (no imgui.ini), and no platform windows, so
+    // mouse positions are relative to the main window rather than the desktop
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+    std::cout << "Recording input to " << path << std::endl;
+    return true;
+}
+
+bool Application::InitializeHeadless(const std::string& filePath) {
+    // Same setup as Initialize, minus the window, the backends and imgui.ini (which would
+    // make the layout depend on whatever was last saved)
+    replaying_ = true;
+    MemoryStats::InstallImGuiAllocator();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+    ImGui::StyleColorsDark();
+    
+    // NewFrame needs a built font atlas; without a renderer the pixels are never uploaded
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    
+    // Same world as the default map, without imagery: there is no GL context to upload it to
+    MapInfo map = availableMaps_.empty() ? MapInfo() : availableMaps_[0];
+    map.imagePath.clear();
+    map.tilePattern.clear();
+    mapView_.SetMapInfo(map);
+    
+    return filePath.empty() || LoadFileBlocking(filePath);
+}
+
+void Application::ReplayFrames(const InputReplay& replay, FrameStats& stats) {
+    for (size_t frame = 0; frame < replay.GetFrameCount(); ++frame) {
+        replay.ApplyFrame(frame);
+        
+        FrameTimes times;
+        auto newFrameStart = std::chrono::steady_clock::now();
+        ImGui::NewFrame();
+        times.ms[static_cast<int>(FramePhase::NewFrame)] =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - newFrameStart).count();
+        UpdateFrame(times);
+        stats.Add(times);
+    }
+}
+
+int Application::RunReplay(const std::string& recordingPath, const std::string& filePath) {
+    InputReplay replay;
+    std::string error;
+    if (!replay.Load(recordingPath, error)) {
+        std::cerr << "Failed to load recording " << recordingPath << ": " << error << std::endl;
+        return 2;
+    }
+    if (!InitializeHeadless(filePath)) {
+        return 2;
+    }
+    
+    FrameStats stats;
+    auto start = std::chrono::steady_clock::now();
+    ReplayFrames(replay, stats);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    
+    std::cout << "Replayed " << recordingPath << " (" << elapsed.count() << " ms)" << std::endl;
+    stats.Print(std::cout);
+    JobSystem::PrintTaskStats(std::cout);
+    std::cout << "Peak memory: " << MemoryStats::FormatBytes(memoryStats_.GetPeakTotal()) << std::endl;
+    return 0;
+}
+
+int Application::RunMemoryReport(const std::string& filePath, const std::string& jsonPath, const std::string& recordingPath) {
+    InputReplay replay;
+    std::string error;
+    if (!recordingPath.empty() && !replay.Load(recordingPath, error)) {
+        std::cerr << "Failed to load recording " << recordingPath << ": " << error << std::endl;
+        return 2;
+    }
+    if (!InitializeHeadless(filePath)) {
+        return 2;
+    }
+    
+    FrameStats stats;
+    if (!recordingPath.empty()) {
+        ReplayFrames(replay, stats);
+    } else {
+        // Two frames: the dock layout is built in the first, so the map view only has its final size in the second
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+        io.DeltaTime = 1.0f / 60.0f;
+        for (int frame = 0; frame < 2; ++frame) {
+            FrameTimes times;
+            ImGui::NewFrame();
+            UpdateFrame(times);
+        }
+    }
+    
+    std::ofstream file(jsonPath);
+    file << memoryStats_.ToJson();
+    if (!file) {
+        std::cerr << "Failed to write " << jsonPath << std::endl;
+        return 2;
+    }
+    std::cout << "Memory: " << MemoryStats::FormatBytes(memoryStats_.GetTotal()) << " (peak "
+              << MemoryStats::FormatBytes(memoryStats_.GetPeakTotal()) << ") over "
+              << memoryStats_.GetSampleCount() << " frame(s), written to " << jsonPath << std::endl;
+    return 0;
+}
+
+void Application::UpdateFrame(FrameTimes& times) {
+    auto phaseStart = std::chrono::steady_clock::now();
+    auto endPhase = [&times, &phaseStart](FramePhase phase) {
+        auto now = std::chrono::steady_clock::now();
+        times.ms[static_cast<int>(phase)] = std::chrono::duration<double, std::milli>(now - phaseStart).count();
+        phaseStart = now;
+    };
+    
+    // Enable docking
+    ImGuiID dockspace_id = ImGui::DockSpaceOverViewport();
+    
+    // Set up initial docking layout on first run
+    if (!dockingInitialized_) {
+        dockingInitialized_ = true;
+        ImGui::DockBuilderRemoveNode(dockspace_id); // Clear any existing layout
+        ImGui::DockBuilderAddNode(dockspace_id, ImGuiDockNodeFlags_DockSpace);
+        ImGui::DockBuilderSetNodeSize(dockspace_id, ImGui::GetMainViewport()->Size);
+        
+        // Split the dockspace
+        ImGuiID dock_id_left = ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Left, 0.2f, nullptr, &dockspace_id);
+        ImGuiID dock_id_right = ImGui::DockBuilderSplitNode(dockspace_id, ImGuiDir_Right, 0.25f, nullptr, &dockspace_id);
+        ImGuiID dock_id_center = dockspace_id; // The remaining center area
+        
+        // Dock the windows
+        ImGui::DockBuilderDockWindow("Territory Hierarchy", dock_id_left);
+        ImGui::DockBuilderDockWindow("Map View", dock_id_center);
+        ImGui::DockBuilderDockWindow("Inspector", dock_id_right);
+        
+        ImGui::DockBuilderFinish(dockspace_id);
+    }
+    
+    // Render menu bar
+    if (ImGui::BeginMainMenuBar()) {
+        if (ImGui::BeginMenu("File")) {
+            if (ImGui::MenuItem("Open...", "Ctrl+O")) {
+                OpenFileDialog();
+            }
+            if (ImGui::MenuItem("Save", "Ctrl+S")) {
+                SaveCurrentFile();
+            }
+            if (ImGui::MenuItem("Save As...", "Ctrl+Shift+S")) {
+                // TODO: File dialog
+            }
+            ImGui::MenuItem("Preserve Formatting", nullptr, &preserveFormatting_);
+            ImGui::Separator();
+            if (ImGui::MenuItem("Compare With File...", nullptr, false, fileLoaded_)) {
+                showDiffWindow_ = true;
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Exit") && window_) {
+                glfwSetWindowShouldClose(window_, true);
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("Edit")) {
+            if (ImGui::MenuItem("Undo", "Ctrl+Z", false, !undoStack_.empty())) {
+                Undo();
+            }
+            ImGui::Separator();
+            if (ImGui::MenuItem("Cut", "Ctrl+X", false, !selectedZones_.empty())) {
+                CutSelectedZones();
+            }
+            if (ImGui::MenuItem("Copy", "Ctrl+C", false, !selectedZones_.empty())) {
+                CopySelectedZones();
+            }
+            if (ImGui::MenuItem("Paste", "Ctrl+V")) {
+                PasteZones(false);
+            }
+            if (ImGui::MenuItem("Delete", "Del", false, !selectedZones_.empty())) {
+                DeleteSelectedZones();
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("View")) {
+            ImGui::MenuItem("Regions", nullptr, &showRegionsWindow_);
+            std::string issuesLabel = "Issues (" + std::to_string(validator_.GetErrorCount()) + " errors, " +
+                                      std::to_string(validator_.GetWarningCount()) + " warnings)";
+            ImGui::MenuItem(issuesLabel.c_str(), nullptr, &showIssuesWindow_);
+            ImGui::MenuItem("Spawn Simulation", nullptr, &showSimulationWindow_);
+            ImGui::MenuItem("Generate Zones", nullptr, &showFillWindow_);
+            ImGui::MenuItem("Duplicate Zones", nullptr, &showDedupWindow_);
+            ImGui::MenuItem("Memory", nullptr, &showMemoryWindow_);
+            ImGui::MenuItem("Jobs", nullptr, &showJobsWindow_);
+            ImGui::Separator();
+            bool showLabels = mapView_.GetShowLabels();
+            if (ImGui::MenuItem("Labels", nullptr, &showLabels)) {
+                mapView_.SetShowLabels(showLabels);
+            }
+            ImGui::EndMenu();
+        }
+        ImGui::EndMainMenuBar();
+    }
+    
+    endPhase(FramePhase::Layout);
+    
+    JobSystem::RunMainThreadTasks();
+    PollLoad();
+    PollExternalChanges();
+    const MapInfo& currentMap = mapView_.GetCurrentMap();
+    validator_.SetWorldSize(currentMap.worldSizeX, currentMap.worldSizeZ);
+    validator_.Update(territoryData_);
+    stats_.Update(territoryData_, selectedZones_);
+    PollSimulation();
+    if (journal_.NeedsCompaction()) {
+        journal_.Reset(territoryData_, currentFilePath_, !documentModified_);
+    }
+    endPhase(FramePhase::Poll);
+    
+    HandleInput();
+    endPhase(FramePhase::Input);
+    RenderUI();
+    endPhase(FramePhase::UI);
+    
+    ImGui::Render();
+    endPhase(FramePhase::Render);
+    
+    // Outside the timed phases; a replay samples every frame so the peaks are exact per frame
+    if (showMemoryWindow_ || replaying_ || ++framesSinceMemorySample_ >= MEMORY_SAMPLE_INTERVAL) {
+        SampleMemory();
+    }
+}
+
 void Application::RenderUI() {
     // Left panel - Territory Hierarchy
     ImGui::Begin("Territory Hierarchy");
@@ -189,6 +412,37 @@ void Application::RenderUI() {
     RenderInspector();
     ImGui::End();
     
+    RenderExternalChangePrompt();
+    RenderRecoveryPrompt();
+    
+    if (showDiffWindow_) {
+        RenderDiffWindow();
+    }
+    if (showRegionsWindow_) {
+        RenderRegionsWindow();
+    }
+    if (showIssuesWindow_) {
+        RenderIssuesWindow();
+    }
+    if (showSimulationWindow_) {
+        RenderSimulationWindow();
+    }
+    if (showFillWindow_) {
+        RenderFillWindow();
+    } else if (!fillPreview_.empty()) {
+        fillPreview_.clear();
+        mapView_.ClearPreviewZones();
+    }
+    if (showDedupWindow_) {
+        RenderDedupWindow();
+    }
+    if (showMemoryWindow_) {
+        RenderMemoryWindow();
+    }
+    if (showJobsWindow_) {
+        RenderJobsWindow();
+    }
+    
     // Add Zone Dialog
     if (showAddZoneDialog_) {
         ImGui::OpenPopup("Add New Zone");
@@ -216,8 +470,9 @@ void Application::RenderUI() {
             if (!availableTerritoryTypes_.empty() && selectedTerritoryTypeIndex_ < availableTerritoryTypes_.size()) {
                 // Find or create territory with this name
                 Territory* targetTerritory = nullptr;
+                NameId typeName = NameTable::Intern(availableTerritoryTypes_[selectedTerritoryTypeIndex_]);
                 for (auto& territory : territoryData_.territories) {
-                    if (territory.name == availableTerritoryTypes_[selectedTerritoryTypeIndex_]) {
+                    if (territory.name == typeName) {
                         targetTerritory = &territory;
                         break;
                     }
@@ -226,10 +481,12 @@ void Application::RenderUI() {
                 // Create new territory if it doesn't exist
                 if (!targetTerritory) {
                     Territory newTerritory;
-                    newTerritory.name = availableTerritoryTypes_[selectedTerritoryTypeIndex_];
+                    newTerritory.name = typeName;
                     newTerritory.color = 0xFFFFFFFF; // Default white color
                     territoryData_.territories.push_back(newTerritory);
                     targetTerritory = &territoryData_.territories.back();
+                    journal_.RecordAddTerritory(newTerritory);
+                    InvalidateAllZones();
                 }
                 
                 // Create new zone
@@ -246,6 +503,8 @@ void Application::RenderUI() {
                 newZone.dmax = 3;
                 
                 targetTerritory->zones.push_back(newZone);
+                journal_.RecordAddZone(static_cast<uint32_t>(targetTerritory - territoryData_.territories.data()), newZone);
+                InvalidateAllZones();
             }
             
             ImGui::CloseCurrentPopup();
@@ -261,8 +520,27 @@ void Application::RenderUI() {
 }
 
 void Application::RenderTerritoryHierarchy() {
+    // Zone query
+    bool queryEdited = ImGui::InputTextWithHint("Query", "territory ~ \"Wolf\" and smax > 4", queryText_, sizeof(queryText_));
+    bool querySubmitted = ImGui::IsItemDeactivated() && ImGui::IsKeyPressed(ImGuiKey_Enter);
+    if (queryEdited) {
+        CompileQuery();
+    }
+    if ((queryEdited && queryLive_) || querySubmitted) {
+        ApplyQuery();
+    }
+    ImGui::Checkbox("Live", &queryLive_);
+    ImGui::SameLine();
+    if (!queryError_.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", queryError_.c_str());
+    } else if (!query_.IsEmpty()) {
+        ImGui::TextDisabled("%zu matching zone(s)", queryMatchCount_);
+    }
+    
     // Search filter
-    ImGui::InputText("Search", searchFilter_, sizeof(searchFilter_));
+    if (ImGui::InputText("Search", searchFilter_, sizeof(searchFilter_))) {
+        hierarchyRowsDirty_ = true;
+    }
     ImGui::Separator();
     
     // Map selector
@@ -272,26 +550,94 @@ void Application::RenderTerritoryHierarchy() {
         return true;
     }, &availableMaps_, availableMaps_.size())) {
         if (selectedMapIndex_ < availableMaps_.size()) {
+            // Imagery comes from the texture cache, so switching back to a map is instant
             mapView_.SetMapInfo(availableMaps_[selectedMapIndex_]);
-            // SetMapInfo will automatically load the image if path is set
         }
     }
     
     ImGui::Separator();
     
     // Territory list
-    ImGui::BeginChild("TerritoryList", ImVec2(0, 0), false);
+    const ZoneAggregate& total = stats_.GetTotal();
+    ImGui::TextDisabled("%zu territories, %zu zones, %.0f smax", territoryData_.territories.size(), total.count,
+                        total.GetSum(ZoneField::Smax));
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable |
+                                 ImGuiTableFlags_Sortable | ImGuiTableFlags_SortTristate;
+    if (!ImGui::BeginTable("TerritoryList", 4, tableFlags)) {
+        return;
+    }
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Territory", ImGuiTableColumnFlags_WidthStretch, 0.0f, static_cast<ImGuiID>(TerritorySortKey::Name));
+    ImGui::TableSetupColumn("Zones", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(TerritorySortKey::ZoneCount));
+    ImGui::TableSetupColumn("smax", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(TerritorySortKey::Smax));
+    ImGui::TableSetupColumn("Area km2", ImGuiTableColumnFlags_PreferSortDescending, 0.0f, static_cast<ImGuiID>(TerritorySortKey::Area));
+    ImGui::TableHeadersRow();
+    
+    ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+    if (sortSpecs && sortSpecs->SpecsDirty) {
+        // Sorting off (third click) falls back to document order
+        hierarchySortKey_ = sortSpecs->SpecsCount > 0 ? static_cast<int>(sortSpecs->Specs[0].ColumnUserID) : -1;
+        hierarchySortDescending_ = sortSpecs->SpecsCount > 0 && sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Descending;
+        sortSpecs->SpecsDirty = false;
+        hierarchyRowsDirty_ = true;
+    }
+    UpdateHierarchyRows();
+    
+    // Only the visible rows are submitted, so long lists cost the same as short ones
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(hierarchyRows_.size()));
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+            RenderHierarchyRow(hierarchyRows_[row]);
+        }
+    }
+    clipper.End();
+    
+    ImGui::EndTable();
+}
+
+void Application::UpdateHierarchyRows() {
+    // The order is re-sorted here at most once per change of its key, which bumps the revision
+    const std::vector<uint32_t>* order = nullptr;
+    if (hierarchySortKey_ >= 0) {
+        order = &stats_.GetOrder(static_cast<TerritorySortKey>(hierarchySortKey_));
+    }
+    if (!hierarchyRowsDirty_ && hierarchyRowsRevision_ == stats_.GetOrderRevision()) {
+        return;
+    }
+    hierarchyRowsDirty_ = false;
+    hierarchyRowsRevision_ = stats_.GetOrderRevision();
+    
+    // Match each distinct name against the filter once rather than once per zone
+    std::vector<int8_t> nameMatches;
+    auto nameMatchesFilter = [&](NameId name) {
+        if (name >= nameMatches.size()) {
+            nameMatches.resize(NameTable::Size(), -1);
+        }
+        if (nameMatches[name] < 0) {
+            nameMatches[name] = NameTable::Resolve(name).find(searchFilter_) != std::string::npos ? 1 : 0;
+        }
+        return nameMatches[name] == 1;
+    };
     
-    for (size_t i = 0; i < territoryData_.territories.size(); ++i) {
-        auto& territory = territoryData_.territories[i];
+    size_t count = stats_.GetTerritoryCount();
+    hierarchyRows_.clear();
+    hierarchyRows_.reserve(count);
+    for (size_t row = 0; row < count; ++row) {
+        size_t index = hierarchySortDescending_ ? count - 1 - row : row;
+        uint32_t i = order ? (*order)[index] : static_cast<uint32_t>(index);
+        if (i >= territoryData_.territories.size()) {
+            continue;
+        }
+        const auto& territory = territoryData_.territories[i];
         
         // Filter check
         bool show = true;
         if (searchFilter_[0] != '\0') {
-            show = territory.name.find(searchFilter_) != std::string::npos;
+            show = nameMatchesFilter(territory.name);
             if (!show) {
                 for (const auto& zone : territory.zones) {
-                    if (zone.name.find(searchFilter_) != std::string::npos) {
+                    if (zone.name != territory.name && nameMatchesFilter(zone.name)) {
                         show = true;
                         break;
                     }
@@ -299,34 +645,60 @@ void Application::RenderTerritoryHierarchy() {
             }
         }
         
-        if (!show) continue;
-        
-        // Push unique ID for this territory to avoid conflicts when names are the same
-        ImGui::PushID(static_cast<int>(i));
-        
-        // Territory visibility checkbox
-        ImGui::Checkbox("##vis", &territory.visible);
-        ImGui::SameLine();
-        
-        // Territory name (clickable)
-        bool isSelected = (selectedTerritory_ == &territory);
-        if (ImGui::Selectable(territory.name.c_str(), isSelected, 0, ImVec2(0, 0))) {
-            ClearSelection();
-            selectedTerritory_ = &territory;
-            // Select all zones in this territory
-            for (auto& zone : territory.zones) {
-                SelectZone(&zone, true);
-            }
+        if (show) {
+            hierarchyRows_.push_back(i);
         }
-        
-        // Zone count
-        ImGui::SameLine();
-        ImGui::TextDisabled("(%zu)", territory.zones.size());
-        
-        ImGui::PopID();
     }
+}
+
+void Application::RenderHierarchyRow(size_t i) {
+    // Rows lag structural edits by at most a frame; keep the row so the clipper's count holds
+    ImGui::TableNextRow();
+    if (i >= territoryData_.territories.size()) {
+        return;
+    }
+    auto& territory = territoryData_.territories[i];
     
-    ImGui::EndChild();
+    // Push unique ID for this territory to avoid conflicts when names are the same
+    ImGui::PushID(static_cast<int>(i));
+    ImGui::TableNextColumn();
+    
+    // Territory visibility checkbox
+    if (ImGui::Checkbox("##vis", &territory.visible)) {
+        mapView_.InvalidateZoneCache();
+    }
+    ImGui::SameLine();
+    
+    // Territory name (clickable)
+    bool isSelected = (selectedTerritory_ == &territory);
+    if (ImGui::Selectable(NameTable::CStr(territory.name), isSelected, 0, ImVec2(0, 0))) {
+        ClearSelection();
+        selectedTerritory_ = &territory;
+        // Select all zones in this territory
+        for (auto& zone : territory.zones) {
+            SelectZone(&zone, true);
+        }
+    }
+    
+    // Stats lag edits by at most a frame; skip territories added since the last update
+    bool hasStats = i < stats_.GetTerritoryCount();
+    if (hasStats && ImGui::IsItemHovered()) {
+        ImGui::BeginTooltip();
+        RenderZoneStats(stats_.GetTerritory(i));
+        ImGui::EndTooltip();
+    }
+    
+    ImGui::TableNextColumn();
+    ImGui::Text("%zu", territory.zones.size());
+    if (hasStats) {
+        const ZoneAggregate& stats = stats_.GetTerritory(i);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.0f", stats.GetSum(ZoneField::Smax));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", stats.GetBoundsArea() / 1.0e6f);
+    }
+    
+    ImGui::PopID();
 }
 
 void Application::RenderMapView() {
@@ -336,32 +708,22 @@ void Application::RenderMapView() {
     if (canvasSize.x < 50.0f) canvasSize.x = 50.0f;
     if (canvasSize.y < 50.0f) canvasSize.y = 50.0f;
     
-    // Helper function to find zone at world position
-    auto findZoneAt = [&](float worldX, float worldZ) -> Zone* {
-        Zone* closestZone = nullptr;
-        float closestDist = 1000.0f; // Max selection distance in world units
-        
-        for (auto& territory : territoryData_.territories) {
-            if (!territory.visible) continue;
-            for (auto& zone : territory.zones) {
-                if (!zone.visible) continue;
-                float dx = zone.x - worldX;
-                float dz = zone.z - worldZ;
-                float dist = std::sqrt(dx * dx + dz * dz);
-                
-                if (dist < zone.r && dist < closestDist) {
-                    closestDist = dist;
-                    closestZone = &zone;
-                }
-            }
-        }
-        return closestZone;
-    };
+    mapHovered_ = false;
+    if (IsLoading()) {
+        RenderLoadProgress(canvasPos, canvasSize);
+        return;
+    }
     
     // Draw canvas first (needed for ImGui to capture mouse input)
     ImGui::InvisibleButton("canvas", canvasSize, ImGuiButtonFlags_MouseButtonLeft | ImGuiButtonFlags_MouseButtonRight | ImGuiButtonFlags_MouseButtonMiddle);
     bool isHovered = ImGui::IsItemHovered();
     ImGuiIO& io = ImGui::GetIO();
+    if (isHovered) {
+        ImVec2 cursor = mapView_.ScreenToWorld(io.MousePos.x, io.MousePos.y, canvasPos, canvasSize);
+        mapHovered_ = true;
+        mapCursorX_ = cursor.x;
+        mapCursorZ_ = cursor.y;
+    }
     
     // Mouse wheel for zooming
     if (isHovered && io.MouseWheel != 0.0f) {
@@ -377,7 +739,7 @@ void Application::RenderMapView() {
     }
     
     // Double-click to add new zone
-    if (isHovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && !io.KeyShift && !isDraggingZone_ && !mapView_.IsMarqueeSelecting()) {
+    if (isHovered && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left) && !io.KeyShift && !isDraggingZone_ && !mapView_.IsMarqueeSelecting() && !mapView_.IsRegionSelecting()) {
         ImVec2 mousePos = io.MousePos;
         ImVec2 worldPos = mapView_.ScreenToWorld(mousePos.x, mousePos.y, canvasPos, canvasSize);
         ShowAddZoneDialog(worldPos.x, worldPos.y);  // y contains the Z coordinate
@@ -407,13 +769,38 @@ void Application::RenderMapView() {
         mapView_.EndMarqueeSelection();
     }
     
+    // Polygon placement takes every click until it is closed or cancelled
+    bool placingPolygon = mapView_.IsRegionSelecting() && selectionTool_ == SelectionTool::Polygon;
+    if (placingPolygon) {
+        if (ImGui::IsKeyPressed(ImGuiKey_Escape)) {
+            mapView_.EndRegionSelection();
+        } else if (ImGui::IsKeyPressed(ImGuiKey_Enter)) {
+            FinishRegionSelection(io.KeyCtrl);
+        }
+    }
+    
     // Left-click handling - zone selection/dragging or marquee selection
-    if (isHovered && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+    if (placingPolygon && isHovered) {
+        if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+            FinishRegionSelection(io.KeyCtrl);
+        } else if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
+            const auto& points = mapView_.GetRegionPoints();
+            ImVec2 first = mapView_.WorldToScreen(points.front().x, points.front().z, canvasPos, canvasSize);
+            float dx = io.MousePos.x - first.x;
+            float dy = io.MousePos.y - first.y;
+            if (points.size() >= 3 && dx * dx + dy * dy <= 8.0f * 8.0f) {
+                FinishRegionSelection(io.KeyCtrl);
+            } else {
+                ImVec2 worldPos = mapView_.ScreenToWorld(io.MousePos.x, io.MousePos.y, canvasPos, canvasSize);
+                mapView_.AddRegionPoint(worldPos.x, worldPos.y);
+            }
+        }
+    } else if (isHovered && ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
         ImVec2 mousePos = io.MousePos;
         ImVec2 worldPos = mapView_.ScreenToWorld(mousePos.x, mousePos.y, canvasPos, canvasSize);
         
         if (ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
-            Zone* zoneAtPos = findZoneAt(worldPos.x, worldPos.y);
+            Zone* zoneAtPos = mapView_.GetZoneAt(territoryData_, mousePos.x, mousePos.y, canvasPos, canvasSize);
             
             if (zoneAtPos && zoneAtPos->selected) {
                 // Starting to drag a selected zone - save undo state
@@ -422,13 +809,24 @@ void Application::RenderMapView() {
                 draggingZone_ = zoneAtPos;
                 dragClickWorldX_ = worldPos.x;
                 dragClickWorldZ_ = worldPos.y;
+                dragAnchorX_ = zoneAtPos->x;
+                dragAnchorZ_ = zoneAtPos->z;
                 dragOriginalPositions_.clear();
+                dragOriginalPositions_.reserve(selectedZones_.size());
                 for (auto* zone : selectedZones_) {
-                    dragOriginalPositions_[zone] = {zone->x, zone->z};
+                    dragOriginalPositions_.push_back({zone->x, zone->z});
+                }
+                if (snapSettings_.enabled) {
+                    snapper_.Begin(territoryData_);
                 }
             } else if (io.KeyShift || !zoneAtPos) {
-                // Starting marquee selection (shift+click or click on empty space)
-                mapView_.StartMarqueeSelection(mousePos.x - canvasPos.x, mousePos.y - canvasPos.y);
+                // Starting area selection (shift+click or click on empty space)
+                if (selectionTool_ == SelectionTool::Marquee) {
+                    mapView_.StartMarqueeSelection(mousePos.x - canvasPos.x, mousePos.y - canvasPos.y);
+                } else {
+                    mapView_.StartRegionSelection();
+                    mapView_.AddRegionPoint(worldPos.x, worldPos.y);
+                }
             } else if (zoneAtPos) {
                 // Clicking on unselected zone - select it
                 if (!io.KeyCtrl) {
@@ -442,22 +840,48 @@ void Application::RenderMapView() {
             float moveDeltaX = currentWorldPos.x - dragClickWorldX_;
             float moveDeltaZ = currentWorldPos.y - dragClickWorldZ_;
             
-            for (auto* zone : selectedZones_) {
-                auto it = dragOriginalPositions_.find(zone);
-                if (it != dragOriginalPositions_.end()) {
-                    zone->x = it->second.first + moveDeltaX;
-                    zone->z = it->second.second + moveDeltaZ;
-                }
+            // Snap the grabbed zone (Alt to move freely) and carry the selection along
+            SnapResult snap;
+            if (snapSettings_.enabled && !io.KeyAlt) {
+                ViewTransform view = mapView_.GetViewTransform(canvasPos, canvasSize);
+                float tolerance = snapSettings_.tolerance / std::min(view.scaleX, -view.scaleZ);
+                snap = snapper_.Snap(dragAnchorX_ + moveDeltaX, dragAnchorZ_ + moveDeltaZ, draggingZone_->r,
+                                     snapSettings_, tolerance);
+                moveDeltaX = snap.x - dragAnchorX_;
+                moveDeltaZ = snap.z - dragAnchorZ_;
             }
+            mapView_.SetSnapGuide(snap);
+            
+            for (size_t i = 0; i < selectedZones_.size() && i < dragOriginalPositions_.size(); ++i) {
+                selectedZones_[i]->x = dragOriginalPositions_[i].first + moveDeltaX;
+                selectedZones_[i]->z = dragOriginalPositions_[i].second + moveDeltaZ;
+            }
+            stats_.MarkSelectionDirty();
+            documentRevision_++;
+            mapView_.InvalidateZoneCache();
         } else if (mapView_.IsMarqueeSelecting()) {
             // Update marquee selection
             ImVec2 mousePos = io.MousePos;
             mapView_.UpdateMarqueeSelection(mousePos.x - canvasPos.x, mousePos.y - canvasPos.y);
+        } else if (mapView_.IsRegionSelecting()) {
+            // Lasso: sample the outline every few pixels of mouse travel
+            const RegionPoint& last = mapView_.GetRegionPoints().back();
+            ImVec2 lastScreen = mapView_.WorldToScreen(last.x, last.z, canvasPos, canvasSize);
+            float dx = mousePos.x - lastScreen.x;
+            float dy = mousePos.y - lastScreen.y;
+            if (dx * dx + dy * dy >= 4.0f * 4.0f) {
+                mapView_.AddRegionPoint(worldPos.x, worldPos.y);
+            }
         }
+    } else if (mapView_.IsRegionSelecting() && selectionTool_ == SelectionTool::Lasso && ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
+        FinishRegionSelection(io.KeyCtrl);
     } else if (isDraggingZone_ && ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
+        JournalSelectedZones();
         isDraggingZone_ = false;
         draggingZone_ = nullptr;
         dragOriginalPositions_.clear();
+        snapper_.End();
+        mapView_.SetSnapGuide(SnapResult());
     } else if (mapView_.IsMarqueeSelecting() && ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
         ImVec2 start = mapView_.GetMarqueeStart();
         ImVec2 end = mapView_.GetMarqueeEnd();
@@ -475,13 +899,73 @@ void Application::RenderMapView() {
         mapView_.EndMarqueeSelection();
     }
     
+    // Hover inspection - zones under the cursor plus nearby centers, from the spatial index
+    hoveredZones_.clear();
+    if (isHovered && !isDraggingZone_ && !mapView_.IsMarqueeSelecting() && !mapView_.IsRegionSelecting() &&
+        !ImGui::IsMouseDown(ImGuiMouseButton_Middle)) {
+        mapView_.GetZonesNear(territoryData_, io.MousePos.x, io.MousePos.y, HOVER_TOLERANCE, MAX_HOVER_NEARBY,
+                              canvasPos, canvasSize, hoveredZones_);
+    }
+    mapView_.SetHoveredZones(hoveredZones_);
+    
     // Render map and zones
     mapView_.Render(territoryData_, canvasPos, canvasSize);
     
+    if (!hoveredZones_.empty()) {
+        ImGui::BeginTooltip();
+        for (size_t i = 0; i < hoveredZones_.size(); ++i) {
+            if (i == MAX_HOVER_LISTED) {
+                ImGui::TextDisabled("... and %zu more", hoveredZones_.size() - i);
+                break;
+            }
+            const ZoneHit& hit = hoveredZones_[i];
+            const Zone* zone = territoryData_.getZone(hit.ref);
+            const char* territoryName = NameTable::CStr(territoryData_.territories[hit.ref.territory].name);
+            if (hit.covers) {
+                ImGui::Text("%s #%u", territoryName, hit.ref.zone);
+            } else {
+                ImGui::TextDisabled("%s #%u (%.0f px away)", territoryName, hit.ref.zone, hit.distance);
+            }
+            ImGui::TextDisabled("  (%.1f, %.1f) r=%.1f  static %d-%d  dynamic %d-%d",
+                                zone->x, zone->z, zone->r, zone->smin, zone->smax, zone->dmin, zone->dmax);
+        }
+        ImGui::EndTooltip();
+    }
+    
     // Reset view button
     if (ImGui::Button("Reset View")) {
         mapView_.ResetView();
     }
+    
+    // Area selection tool
+    ImGui::SameLine();
+    int tool = static_cast<int>(selectionTool_);
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::Combo("Selection", &tool, "Marquee\0Lasso\0Polygon\0")) {
+        selectionTool_ = static_cast<SelectionTool>(tool);
+        mapView_.EndRegionSelection();
+    }
+    
+    // Drag snapping
+    ImGui::SameLine();
+    ImGui::Checkbox("Snap", &snapSettings_.enabled);
+    ImGui::SameLine();
+    if (ImGui::Button("...##snap")) {
+        ImGui::OpenPopup("Snap Options");
+    }
+    if (ImGui::BeginPopup("Snap Options")) {
+        ImGui::Checkbox("Grid", &snapSettings_.grid);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::InputFloat("Spacing (m)", &snapSettings_.gridSize, 10.0f, 100.0f, "%.1f");
+        snapSettings_.gridSize = std::max(snapSettings_.gridSize, 1.0f);
+        ImGui::Checkbox("Zone centers", &snapSettings_.centers);
+        ImGui::Checkbox("Tangent to neighbors", &snapSettings_.tangent);
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::SliderFloat("Tolerance (px)", &snapSettings_.tolerance, 2.0f, 40.0f, "%.0f");
+        ImGui::TextDisabled("Hold Alt while dragging to move freely");
+        ImGui::EndPopup();
+    }
 }
 
 void Application::RenderInspector() {
@@ -551,6 +1035,7 @@ void Application::RenderInspector() {
                     }
                 }
             }
+            JournalSelectedZones();
         }
         
         ImGui::Separator();
@@ -558,17 +1043,18 @@ void Application::RenderInspector() {
         // Show properties of first selected zone (or average if multiple)
         if (selectedZones_.size() == 1) {
             Zone* zone = selectedZones_[0];
-            ImGui::Text("Zone: %s", zone->name.c_str());
-            ImGui::InputInt("smin", &zone->smin);
-            ImGui::InputInt("smax", &zone->smax);
-            ImGui::InputInt("dmin", &zone->dmin);
-            ImGui::InputInt("dmax", &zone->dmax);
-            ImGui::InputFloat("X", &zone->x);
-            ImGui::InputFloat("Z", &zone->z);
+            ImGui::Text("Zone: %s", NameTable::CStr(zone->name));
+            bool edited = false;
+            edited |= ImGui::InputInt("smin", &zone->smin);
+            edited |= ImGui::InputInt("smax", &zone->smax);
+            edited |= ImGui::InputInt("dmin", &zone->dmin);
+            edited |= ImGui::InputInt("dmax", &zone->dmax);
+            edited |= ImGui::InputFloat("X", &zone->x);
+            edited |= ImGui::InputFloat("Z", &zone->z);
             
             // Radius with +/- buttons
             ImGui::PushID("Radius");
-            ImGui::InputFloat("Radius", &zone->r);
+            edited |= ImGui::InputFloat("Radius", &zone->r);
             ImGui::SameLine();
             ImGuiIO& io = ImGui::GetIO();
             float step = io.KeyShift ? 20.0f : 5.0f;
@@ -576,39 +1062,88 @@ void Application::RenderInspector() {
                 SaveUndoState();
                 zone->r = zone->r - step;
                 if (zone->r < 0.0f) zone->r = 0.0f;
+                edited = true;
             }
             ImGui::SameLine();
             if (ImGui::Button("+")) {
                 SaveUndoState();
                 zone->r += step;
+                edited = true;
             }
             ImGui::PopID();
             
-            ImGui::InputFloat("Height", &zone->h);
-        } else {
-            // Show averages
-            float avgX = 0, avgZ = 0, avgR = 0;
-            for (auto* zone : selectedZones_) {
-                avgX += zone->x;
-                avgZ += zone->z;
-                avgR += zone->r;
-            }
-            avgX /= selectedZones_.size();
-            avgZ /= selectedZones_.size();
-            avgR /= selectedZones_.size();
+            edited |= ImGui::InputFloat("Height", &zone->h);
             
-            ImGui::Text("Average Position: (%.2f, %.2f)", avgX, avgZ);
-            ImGui::Text("Average Radius: %.2f", avgR);
+            if (edited) {
+                MarkDocumentModified();
+                ZoneRef ref = territoryData_.findZone(zone);
+                journal_.RecordZone(ref, *zone);
+                MarkZoneDirty(ref);
+            }
+        } else {
+            // Kept up to date by stats_, so this doesn't walk the selection every frame
+            const ZoneAggregate& selection = stats_.GetSelection();
+            ImGui::Text("Average Position: (%.2f, %.2f)", selection.GetMean(ZoneField::X), selection.GetMean(ZoneField::Z));
+            ImGui::Text("Average Radius: %.2f", selection.GetMean(ZoneField::R));
+            RenderZoneStats(selection);
         }
     }
     
     if (selectedTerritory_) {
         ImGui::Separator();
-        ImGui::Text("Territory: %s", selectedTerritory_->name.c_str());
+        ImGui::Text("Territory: %s", NameTable::CStr(selectedTerritory_->name));
         ImGui::Text("Zones: %zu", selectedTerritory_->zones.size());
+        size_t territoryIndex = selectedTerritory_ - territoryData_.territories.data();
+        if (territoryIndex < stats_.GetTerritoryCount()) {
+            ImGui::PushID("Territory");
+            RenderZoneStats(stats_.GetTerritory(territoryIndex));
+            ImGui::PopID();
+        }
     }
 }
 
+void Application::RenderZoneStats(const ZoneAggregate& stats) {
+    if (stats.IsEmpty()) {
+        return;
+    }
+    
+    struct Row {
+        const char* label;
+        ZoneField field;
+    };
+    static const Row rows[] = {
+        { "smin", ZoneField::Smin },
+        { "smax", ZoneField::Smax },
+        { "dmin", ZoneField::Dmin },
+        { "dmax", ZoneField::Dmax },
+        { "radius", ZoneField::R },
+    };
+    if (ImGui::BeginTable("ZoneStats", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Field");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("Mean");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("Sum");
+        ImGui::TableHeadersRow();
+        
+        for (const Row& row : rows) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(row.label);
+            ImGui::TableNextColumn();
+            ImGui::Text("%g", stats.GetMin(row.field));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.GetMean(row.field));
+            ImGui::TableNextColumn();
+            ImGui::Text("%g", stats.GetMax(row.field));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", stats.GetSum(row.field));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Bounds: (%.0f, %.0f) - (%.0f, %.0f)", stats.boundsMinX, stats.boundsMinZ, stats.boundsMaxX, stats.boundsMaxZ);
+}
+
 void Application::HandleInput() {
     // Handle keyboard shortcuts
     ImGuiIO& io = ImGui::GetIO();
@@ -620,14 +1155,23 @@ void Application::HandleInput() {
             if (io.KeyShift) {
                 // TODO: Save As
             } else {
-                if (!currentFilePath_.empty()) {
-                    TerritoryParser::SaveToFile(currentFilePath_, territoryData_);
-                }
+                SaveCurrentFile();
             }
         }
         if (ImGui::IsKeyPressed(ImGuiKey_Z) && !io.WantTextInput) {
             Undo();
         }
+        if (!io.WantTextInput) {
+            if (ImGui::IsKeyPressed(ImGuiKey_C)) {
+                CopySelectedZones();
+            }
+            if (ImGui::IsKeyPressed(ImGuiKey_X)) {
+                CutSelectedZones();
+            }
+            if (ImGui::IsKeyPressed(ImGuiKey_V)) {
+                PasteZones(mapHovered_);
+            }
+        }
     }
     
     // Delete key to delete selected zones (only if not typing in a text field)
@@ -642,6 +1186,8 @@ void Application::ClearSelection() {
     }
     selectedZones_.clear();
     selectedTerritory_ = nullptr;
+    stats_.MarkSelectionDirty();
+    mapView_.InvalidateZoneStyle();
 }
 
 void Application::SelectZone(Zone* zone, bool addToSelection) {
@@ -652,6 +1198,8 @@ void Application::SelectZone(Zone* zone, bool addToSelection) {
     if (zone && !zone->selected) {
         zone->selected = true;
         selectedZones_.push_back(zone);
+        stats_.MarkSelectionDirty();
+        mapView_.InvalidateZoneStyle();
     }
 }
 
@@ -662,6 +1210,19 @@ void Application::DeleteSelectedZones() {
     
     SaveUndoState();
     
+    std::vector<ZoneRef> removedRefs;
+    removedRefs.reserve(selectedZones_.size());
+    for (uint32_t t = 0; t < territoryData_.territories.size(); ++t) {
+        const auto& zones = territoryData_.territories[t].zones;
+        for (uint32_t z = 0; z < zones.size(); ++z) {
+            if (zones[z].selected) {
+                removedRefs.push_back({ t, z });
+            }
+        }
+    }
+    journal_.RecordRemoveZones(removedRefs);
+    InvalidateAllZones();
+    
     // Remove selected zones from their territories
     for (auto it = territoryData_.territories.begin(); it != territoryData_.territories.end();) {
         auto& territory = *it;
@@ -689,38 +1250,166 @@ void Application::DeleteSelectedZones() {
     ClearSelection();
 }
 
-void Application::SaveUndoState() {
-    // Store current state in undo stack
-    undoStack_.push_back(territoryData_);
-    
-    // Limit stack size
-    if (undoStack_.size() > MAX_UNDO_STACK_SIZE) {
-        undoStack_.erase(undoStack_.begin());
+void Application::CopySelectedZones() {
+    if (selectedZones_.empty()) {
+        return;
     }
+    ZoneClipboardContent content = ZoneClipboard::CopySelected(territoryData_);
+    ImGui::SetClipboardText(ZoneClipboard::ToText(content).c_str());
+    std::cout << "Copied " << content.GetZoneCount() << " zone(s)" << std::endl;
 }
 
-void Application::Undo() {
-    if (undoStack_.empty()) {
+void Application::CutSelectedZones() {
+    if (selectedZones_.empty() || isDraggingZone_) {
         return;
     }
-    
-    // Restore previous state
-    territoryData_ = undoStack_.back();
-    undoStack_.pop_back();
-    
-    // Clear selection since zone pointers are now invalid
-    ClearSelection();
+    CopySelectedZones();
+    DeleteSelectedZones();
 }
 
-void Application::OpenFileDialog() {
-#ifdef _WIN32
-    OPENFILENAMEA ofn;
-    char szFile[260] = {0};
+void Application::PasteZones(bool atCursor) {
+    const char* text = ImGui::GetClipboardText();
+    if (!text || isDraggingZone_ || IsLoading()) {
+        return;
+    }
+    ZoneClipboardContent content;
+    std::string error;
+    if (!ZoneClipboard::FromText(text, content, error)) {
+        std::cerr << "Paste failed: " << error << std::endl;
+        return;
+    }
+    float originX = atCursor ? mapCursorX_ : content.anchorX;
+    float originZ = atCursor ? mapCursorZ_ : content.anchorZ;
     
-    ZeroMemory(&ofn, sizeof(ofn));
-    ofn.lStructSize = sizeof(ofn);
-    ofn.hwndOwner = glfwGetWin32Window(window_);
-    ofn.lpstrFile = szFile;
+    // One undo step and one journal record per territory; clear the selection before zone storage can move
+    SaveUndoState();
+    ClearSelection();
+    
+    // Zones join the territory of the same name, or a new one if this file has none
+    std::unordered_map<NameId, uint32_t> territoryByName;
+    for (uint32_t t = 0; t < territoryData_.territories.size(); ++t) {
+        territoryByName.emplace(territoryData_.territories[t].name, t);
+    }
+    
+    struct InsertedRange {
+        uint32_t territory;
+        size_t first;
+        size_t count;
+    };
+    std::vector<InsertedRange> inserted;
+    size_t pasted = 0;
+    for (const auto& source : content.data.territories) {
+        if (source.zones.empty()) {
+            continue;
+        }
+        auto found = territoryByName.find(source.name);
+        uint32_t t;
+        if (found != territoryByName.end()) {
+            t = found->second;
+        } else {
+            Territory territory;
+            territory.name = source.name;
+            territory.color = source.color;
+            territoryData_.territories.push_back(territory);
+            journal_.RecordAddTerritory(territory);
+            t = static_cast<uint32_t>(territoryData_.territories.size() - 1);
+            territoryByName.emplace(source.name, t);
+        }
+        
+        auto& zones = territoryData_.territories[t].zones;
+        size_t first = zones.size();
+        zones.reserve(first + source.zones.size());
+        for (Zone zone : source.zones) {
+            zone.x += originX;
+            zone.z += originZ;
+            zone.sourceId = UINT32_MAX;  // Not from the loaded file, wherever it was copied from
+            zones.push_back(zone);
+        }
+        journal_.RecordAddZones(t, zones.data() + first, zones.size() - first);
+        inserted.push_back({ t, first, source.zones.size() });
+        pasted += source.zones.size();
+    }
+    InvalidateAllZones();
+    
+    // Leave the pasted zones selected so they can be moved into place together
+    selectedZones_.reserve(pasted);
+    for (const InsertedRange& range : inserted) {
+        auto& zones = territoryData_.territories[range.territory].zones;
+        for (size_t i = range.first; i < range.first + range.count; ++i) {
+            SelectZone(&zones[i], true);
+        }
+    }
+    std::cout << "Pasted " << pasted << " zone(s)" << std::endl;
+}
+
+void Application::SaveUndoState() {
+    // Every undoable operation is about to modify the document
+    MarkDocumentModified();
+    
+    // Store current state in undo stack
+    undoStack_.push_back(territoryData_);
+    
+    // Limit stack size
+    if (undoStack_.size() > MAX_UNDO_STACK_SIZE) {
+        undoStack_.pop_front();
+    }
+}
+
+void Application::Undo() {
+    if (undoStack_.empty()) {
+        return;
+    }
+    
+    // Restore previous state
+    territoryData_ = undoStack_.back();
+    undoStack_.pop_back();
+    MarkDocumentModified();
+    journal_.Reset(territoryData_, currentFilePath_, false);
+    InvalidateAllZones();
+    
+    // Clear selection since zone pointers are now invalid
+    ResetSelection();
+}
+
+void Application::ResetSelection() {
+    // The document was replaced wholesale, so the old zone pointers must not be touched.
+    // Snapshots carry the selection flags they were taken with; clear those instead.
+    selectedZones_.clear();
+    selectedTerritory_ = nullptr;
+    for (auto& territory : territoryData_.territories) {
+        for (auto& zone : territory.zones) {
+            zone.selected = false;
+        }
+    }
+    stats_.MarkSelectionDirty();
+    mapView_.InvalidateZoneCache();
+}
+
+void Application::OpenFileDialog() {
+#ifdef _WIN32
+    std::string filePath;
+    if (BrowseForFile(filePath)) {
+        LoadFile(filePath);
+    }
+#else
+    // For non-Windows platforms, fall back to default file
+    LoadFile("Example Territory Files/zombie_territories.xml");
+#endif
+}
+
+bool Application::BrowseForFile(std::string& filePath) {
+    // A replay can't answer a native dialog
+    if (replaying_) {
+        return false;
+    }
+#ifdef _WIN32
+    OPENFILENAMEA ofn;
+    char szFile[260] = {0};
+    
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = glfwGetWin32Window(window_);
+    ofn.lpstrFile = szFile;
     ofn.nMaxFile = sizeof(szFile);
     ofn.lpstrFilter = "XML Files\0*.xml\0All Files\0*.*\0";
     ofn.nFilterIndex = 1;
@@ -730,28 +1419,468 @@ void Application::OpenFileDialog() {
     ofn.Flags = OFN_PATHMUSTEXIST | OFN_FILEMUSTEXIST;
     
     if (GetOpenFileNameA(&ofn) == TRUE) {
-        std::string filePath = ofn.lpstrFile;
-        if (TerritoryParser::LoadFromFile(filePath, territoryData_)) {
-            currentFilePath_ = filePath;
-            fileLoaded_ = true;
-            ClearSelection();
-            std::cout << "Loaded " << territoryData_.getTotalZoneCount() << " zones from " << filePath << std::endl;
+        filePath = ofn.lpstrFile;
+        return true;
+    }
+#else
+    (void)filePath;
+#endif
+    return false;
+}
+
+bool Application::LoadFile(const std::string& filePath) {
+    // A newer request replaces a load still in flight
+    CancelLoad();
+    
+    loadPath_ = filePath;
+    loadProgress_ = std::make_unique<LoadProgress>();
+    loadPreview_.clear();
+    LoadProgress* progress = loadProgress_.get();
+    loadFuture_ = JobSystem::Async("Load file", [this, filePath, progress]() {
+        if (!TerritoryParser::LoadFromFile(filePath, loadData_, progress)) {
+            return false;
+        }
+        // Without a source, the first save just rewrites the whole file
+        loadSource_.Attach(filePath, loadData_);
+        return true;
+    });
+    
+    // The map shows the incoming territories from now on
+    mapView_.InvalidateZoneCache();
+    return true;
+}
+
+void Application::CancelLoad() {
+    if (!loadFuture_.valid()) {
+        return;
+    }
+    loadProgress_->Cancel();
+    loadFuture_.get();
+    loadData_.clear();
+    loadSource_.Detach();
+    loadPreview_.clear();
+    mapView_.InvalidateZoneCache();
+}
+
+void Application::PollLoad() {
+    if (!loadFuture_.valid()) {
+        return;
+    }
+    
+    size_t shownTerritories = loadPreview_.territories.size();
+    loadProgress_->TakeFinished(loadPreview_);
+    if (loadPreview_.territories.size() != shownTerritories) {
+        mapView_.InvalidateZoneCache();
+    }
+    
+    // Zone pointers held by a drag must stay valid until it ends
+    if (isDraggingZone_ || loadFuture_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    
+    bool loaded = loadFuture_.get();
+    loadPreview_.clear();
+    mapView_.InvalidateZoneCache();
+    if (!loaded) {
+        if (loadProgress_->IsCancelled()) {
+            std::cout << "Cancelled loading " << loadPath_ << std::endl;
         } else {
-            std::cerr << "Failed to load file: " << filePath << std::endl;
+            std::cerr << "Failed to load file: " << loadPath_ << std::endl;
         }
+        loadData_.clear();
+        loadSource_.Detach();
+        return;
     }
-#else
-    // For non-Windows platforms, fall back to default file
-    std::string filePath = "Example Territory Files/zombie_territories.xml";
-    if (TerritoryParser::LoadFromFile(filePath, territoryData_)) {
-        currentFilePath_ = filePath;
-        fileLoaded_ = true;
-        ClearSelection();
-        std::cout << "Loaded " << territoryData_.getTotalZoneCount() << " zones from " << filePath << std::endl;
+    
+    // Discard any in-flight reparse of the previous file
+    if (reloadFuture_.valid()) {
+        reloadFuture_.get();
+    }
+    
+    // Drop the old selection while its zone pointers are still valid, then swap documents
+    ClearSelection();
+    territoryData_ = std::move(loadData_);
+    loadData_.clear();
+    source_ = std::move(loadSource_);
+    loadSource_.Detach();
+    
+    const std::string& filePath = loadPath_;
+    currentFilePath_ = filePath;
+    fileLoaded_ = true;
+    documentModified_ = false;
+    reloadPending_ = false;
+    showConflictPrompt_ = false;
+    fileWatcher_.Watch(filePath);
+    journal_.Reset(territoryData_, currentFilePath_, true);
+    InvalidateAllZones();
+    documentRevision_++;
+    std::cout << "Loaded " << territoryData_.getTotalZoneCount() << " zones from " << filePath << std::endl;
+}
+
+void Application::RenderLoadProgress(const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    // The map is read-only while loading and shows the territories parsed so far
+    ImGui::InvisibleButton("canvas", canvasSize);
+    hoveredZones_.clear();
+    mapView_.SetHoveredZones(hoveredZones_);
+    mapView_.Render(loadPreview_, canvasPos, canvasSize);
+    
+    size_t done = loadProgress_->GetTerritoriesDone();
+    size_t total = loadProgress_->GetTerritoryCount();
+    std::string status = total == 0
+        ? "Reading " + loadPath_ + "..."
+        : "Loading " + loadPath_ + ": " + std::to_string(done) + " / " + std::to_string(total) +
+          " territories, " + std::to_string(loadProgress_->GetZonesDone()) + " zones";
+    
+    ImGui::SetCursorScreenPos(ImVec2(canvasPos.x + 10.0f, canvasPos.y + 10.0f));
+    ImGui::BeginGroup();
+    ImGui::TextUnformatted(status.c_str());
+    ImGui::ProgressBar(total > 0 ? static_cast<float>(done) / total : 0.0f, ImVec2(300.0f, 0.0f));
+    ImGui::SameLine();
+    if (ImGui::Button("Cancel")) {
+        CancelLoad();
+    }
+    ImGui::EndGroup();
+}
+
+bool Application::SaveCurrentFile() {
+    if (currentFilePath_.empty()) {
+        return false;
+    }
+    
+    // Replays run in CI against checked-in files; never overwrite them
+    if (replaying_) {
+        std::cout << "Replay: skipped saving " << currentFilePath_ << std::endl;
+        return false;
+    }
+    
+    // Never overwrite a newer file on disk without asking first
+    if (reloadPending_ || reloadFuture_.valid()) {
+        showConflictPrompt_ = true;
+        return false;
+    }
+    
+    // Never write a file the server would choke on
+    validator_.Update(territoryData_);
+    if (validator_.GetErrorCount() > 0) {
+        std::cerr << "Not saving: " << validator_.GetErrorCount() << " validation error(s)" << std::endl;
+        showIssuesWindow_ = true;
+        return false;
+    }
+    
+    if (preserveFormatting_ && source_.IsAttachedTo(currentFilePath_)) {
+        SourceSaveStats stats;
+        if (!source_.Save(currentFilePath_, territoryData_, &stats)) {
+            std::cerr << "Failed to save file: " << currentFilePath_ << std::endl;
+            return false;
+        }
+        if (stats.regenerated) {
+            std::cout << "Saved " << currentFilePath_ << " (regenerated)" << std::endl;
+        } else {
+            std::cout << "Saved " << currentFilePath_ << ": " << stats.changedZones << " changed, " << stats.addedZones
+                      << " added, " << stats.removedZones << " removed zone(s), " << stats.bytesRewritten << " bytes rewritten" << std::endl;
+        }
     } else {
-        std::cerr << "Failed to load file: " << filePath << std::endl;
+        if (!TerritoryParser::SaveToFile(currentFilePath_, territoryData_)) {
+            std::cerr << "Failed to save file: " << currentFilePath_ << std::endl;
+            return false;
+        }
+        if (preserveFormatting_) {
+            source_.Attach(currentFilePath_, territoryData_);
+        }
+    }
+    
+    fileWatcher_.AcknowledgeCurrentState();
+    documentModified_ = false;
+    journal_.MarkClean();
+    return true;
+}
+
+void Application::MarkDocumentModified() {
+    documentModified_ = true;
+    documentRevision_++;
+    mapView_.InvalidateZoneCache();
+}
+
+void Application::PollExternalChanges() {
+    // Start a background reparse when the watcher reports a change
+    if (!reloadFuture_.valid() && fileWatcher_.ConsumeChange()) {
+        std::string filePath = currentFilePath_;
+        reloadPending_ = false;
+        reloadFuture_ = JobSystem::Async("Reload file", [this, filePath]() {
+            return TerritoryParser::LoadFromFile(filePath, reloadData_);
+        });
+    }
+    
+    if (reloadFuture_.valid() &&
+        reloadFuture_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        if (reloadFuture_.get()) {
+            reloadPending_ = true;
+            if (documentModified_) {
+                // Both sides changed - let the user decide
+                showConflictPrompt_ = true;
+            }
+        } else {
+            // Most likely caught the file mid-write; the watcher will fire again when it settles
+            std::cerr << "Failed to reparse changed file: " << currentFilePath_ << std::endl;
+        }
+    }
+    
+    if (reloadPending_ && !documentModified_ && !isDraggingZone_) {
+        ApplyExternalChanges(reloadData_);
+        reloadData_.clear();
+        reloadPending_ = false;
+    }
+}
+
+// Compares the fields a territory file stores
+static bool SameZoneData(const Zone& a, const Zone& b) {
+    return a.name == b.name && a.smin == b.smin && a.smax == b.smax &&
+           a.dmin == b.dmin && a.dmax == b.dmax && a.x == b.x &&
+           a.z == b.z && a.r == b.r && a.h == b.h;
+}
+
+// Copy file-backed fields only, keeping editor state such as selection and visibility
+static bool CopyZoneData(Zone& dst, const Zone& src) {
+    if (SameZoneData(dst, src)) {
+        return false;
+    }
+    
+    dst.name = src.name;
+    dst.smin = src.smin;
+    dst.smax = src.smax;
+    dst.dmin = src.dmin;
+    dst.dmax = src.dmax;
+    dst.x = src.x;
+    dst.z = src.z;
+    dst.r = src.r;
+    dst.h = src.h;
+    return true;
+}
+
+void Application::ApplyExternalChanges(const TerritoryData& diskData) {
+    TerritoryList& local = territoryData_.territories;
+    
+    // Pair zones by position within paired territories, so a zone inserted or removed on
+    // disk doesn't shift the rest; a kept zone carries its selection flag wherever it lands
+    std::vector<ZoneRef> unmatchedDisk;
+    std::vector<ZoneRef> toDisk = TerritoryDiff::MatchZones(territoryData_, diskData, TerritoryDiff::DEFAULT_TOLERANCE,
+                                                             unmatchedDisk);
+    std::vector<uint32_t> diskStart(diskData.territories.size());
+    uint32_t diskCount = 0;
+    for (size_t i = 0; i < diskData.territories.size(); ++i) {
+        diskStart[i] = diskCount;
+        diskCount += static_cast<uint32_t>(diskData.territories[i].zones.size());
+    }
+    
+    // A territory is updated in place when the file still has it at the same index and every
+    // zone in the same slot; only territories that gained, lost or reordered zones are rebuilt
+    bool sameTerritories = local.size() == diskData.territories.size();
+    for (size_t t = 0; sameTerritories && t < local.size(); ++t) {
+        sameTerritories = local[t].name == diskData.territories[t].name;
+    }
+    std::vector<bool> inPlace(local.size(), sameTerritories);
+    std::vector<const Zone*> localForDisk(diskCount, nullptr);
+    size_t changedZones = unmatchedDisk.size();
+    uint32_t flat = 0;
+    for (uint32_t t = 0; t < local.size(); ++t) {
+        if (sameTerritories && local[t].zones.size() != diskData.territories[t].zones.size()) {
+            inPlace[t] = false;
+        }
+        for (uint32_t z = 0; z < local[t].zones.size(); ++z) {
+            ZoneRef ref = toDisk[flat++];
+            if (ref.valid()) {
+                localForDisk[diskStart[ref.territory] + ref.zone] = &local[t].zones[z];
+            } else {
+                changedZones++;  // Removed on disk
+            }
+            if (ref.territory != t || ref.zone != z) {
+                inPlace[t] = false;
+            }
+        }
+    }
+    
+    std::vector<ZoneRef> changedInPlace;
+    bool rebuildAny = !sameTerritories;
+    bool colorsChanged = false;
+    for (uint32_t t = 0; sameTerritories && t < local.size(); ++t) {
+        const Territory& diskTerritory = diskData.territories[t];
+        colorsChanged |= local[t].color != diskTerritory.color;
+        if (!inPlace[t]) {
+            rebuildAny = true;
+            continue;
+        }
+        for (uint32_t z = 0; z < local[t].zones.size(); ++z) {
+            if (!SameZoneData(local[t].zones[z], diskTerritory.zones[z])) {
+                changedInPlace.push_back({ t, z });
+            }
+        }
+    }
+    
+    if (!rebuildAny && !colorsChanged && changedInPlace.empty()) {
+        // Touched, or rewritten with the same values: nothing to undo or revalidate. The text
+        // may still differ (formatting, comments), so the source is re-read for later saves.
+        if (documentModified_) {
+            documentModified_ = false;
+            journal_.MarkClean();
+        }
+        source_.Attach(currentFilePath_, territoryData_);
+        std::cout << "Reloaded " << currentFilePath_ << " (no zone changes)" << std::endl;
+        return;
+    }
+    
+    // Keep the pre-reload state undoable
+    SaveUndoState();
+    
+    // A zone list in disk order, so the document lines up with the file for TerritorySource
+    auto diskOrderZones = [&](size_t i) {
+        const ZoneList& diskZones = diskData.territories[i].zones;
+        ZoneList zones(local.get_allocator());
+        zones.reserve(diskZones.size());
+        for (size_t z = 0; z < diskZones.size(); ++z) {
+            const Zone* localZone = localForDisk[diskStart[i] + z];
+            if (localZone) {
+                zones.push_back(*localZone);
+                if (CopyZoneData(zones.back(), diskZones[z])) {
+                    changedZones++;
+                }
+            } else {
+                zones.push_back(diskZones[z]);
+            }
+        }
+        return zones;
+    };
+    
+    if (sameTerritories) {
+        for (uint32_t t = 0; t < local.size(); ++t) {
+            local[t].color = diskData.territories[t].color;
+            if (!inPlace[t]) {
+                local[t].zones = diskOrderZones(t);
+            }
+        }
+        for (const ZoneRef& ref : changedInPlace) {
+            CopyZoneData(local[ref.territory].zones[ref.zone], diskData.territories[ref.territory].zones[ref.zone]);
+        }
+        changedZones += changedInPlace.size();
+    } else {
+        // Match territories by name, preferring the same index, to keep their other state
+        std::vector<ZoneList> zoneLists;
+        zoneLists.reserve(diskData.territories.size());
+        for (size_t i = 0; i < diskData.territories.size(); ++i) {
+            zoneLists.push_back(diskOrderZones(i));
+        }
+        
+        std::vector<bool> used(local.size(), false);
+        TerritoryList merged(local.get_allocator());
+        merged.reserve(diskData.territories.size());
+        
+        for (size_t i = 0; i < diskData.territories.size(); ++i) {
+            const Territory& diskTerritory = diskData.territories[i];
+            
+            size_t match = local.size();
+            if (i < local.size() && !used[i] && local[i].name == diskTerritory.name) {
+                match = i;
+            } else {
+                for (size_t j = 0; j < local.size(); ++j) {
+                    if (!used[j] && local[j].name == diskTerritory.name) {
+                        match = j;
+                        break;
+                    }
+                }
+            }
+            
+            if (match == local.size()) {
+                merged.push_back(diskTerritory);
+            } else {
+                used[match] = true;
+                merged.push_back(std::move(local[match]));
+                merged.back().color = diskTerritory.color;
+            }
+            merged.back().zones = std::move(zoneLists[i]);
+        }
+        
+        NameId selectedTerritoryName = selectedTerritory_ ? selectedTerritory_->name : 0;
+        local = std::move(merged);
+        selectedTerritory_ = nullptr;
+        for (auto& territory : local) {
+            if (selectedTerritoryName != 0 && territory.name == selectedTerritoryName) {
+                selectedTerritory_ = &territory;
+                break;
+            }
+        }
+    }
+    
+    // The document now matches the file on disk
+    documentModified_ = false;
+    source_.Attach(currentFilePath_, territoryData_);
+    if (rebuildAny) {
+        // Rebuilt lists moved their zones; rebuild the selection from the surviving flags
+        selectedZones_.clear();
+        for (auto& territory : local) {
+            for (auto& zone : territory.zones) {
+                if (zone.selected) {
+                    selectedZones_.push_back(&zone);
+                }
+            }
+        }
+        InvalidateAllZones();
+    } else {
+        // Only values changed: the selection still points at the same zones
+        for (const ZoneRef& ref : changedInPlace) {
+            MarkZoneDirty(ref);
+        }
+    }
+    
+    // The journal has no records for rebuilt lists or territory colors
+    if (rebuildAny || colorsChanged) {
+        journal_.Reset(territoryData_, currentFilePath_, true);
+    } else {
+        for (const ZoneRef& ref : changedInPlace) {
+            journal_.RecordZone(ref, *territoryData_.getZone(ref));
+        }
+        journal_.MarkClean();
+    }
+    documentRevision_++;
+    std::cout << "Reloaded " << currentFilePath_ << " (" << changedZones << " zone(s) changed)" << std::endl;
+}
+
+void Application::RenderExternalChangePrompt() {
+    if (showConflictPrompt_) {
+        ImGui::OpenPopup("File Changed On Disk");
+        showConflictPrompt_ = false;
+    }
+    
+    if (ImGui::BeginPopupModal("File Changed On Disk", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("%s was changed by another program.", currentFilePath_.c_str());
+        ImGui::Text("You also have unsaved changes.");
+        ImGui::Separator();
+        
+        if (!reloadPending_) {
+            ImGui::TextDisabled("Reading changed file...");
+        }
+        
+        if (reloadPending_ && ImGui::Button("Load Disk Version")) {
+            // Local edits stay reachable through Undo
+            ApplyExternalChanges(reloadData_);
+            reloadData_.clear();
+            reloadPending_ = false;
+            ImGui::CloseCurrentPopup();
+        }
+        
+        ImGui::SameLine();
+        if (reloadPending_ && ImGui::Button("Keep My Changes")) {
+            // Drop the disk version; the next save intentionally overwrites it
+            reloadData_.clear();
+            reloadPending_ = false;
+            ImGui::CloseCurrentPopup();
+        }
+        
+        ImGui::SameLine();
+        if (ImGui::Button("Decide Later")) {
+            ImGui::CloseCurrentPopup();
+        }
+        
+        ImGui::EndPopup();
     }
-#endif
 }
 
 void Application::ShowAddZoneDialog(float worldX, float worldZ) {
@@ -762,8 +1891,8 @@ void Application::ShowAddZoneDialog(float worldX, float worldZ) {
     availableTerritoryTypes_.clear();
     std::set<std::string> uniqueTypes;
     for (const auto& territory : territoryData_.territories) {
-        if (!territory.name.empty()) {
-            uniqueTypes.insert(territory.name);
+        if (territory.name != 0) {
+            uniqueTypes.insert(NameTable::Resolve(territory.name));
         }
     }
     
@@ -776,3 +1905,821 @@ void Application::ShowAddZoneDialog(float worldX, float worldZ) {
     showAddZoneDialog_ = true;
 }
 
+
+
+void Application::FocusZone(Zone* zone) {
+    ClearSelection();
+    SelectZone(zone, true);
+    mapView_.CenterOn(zone->x, zone->z);
+}
+
+void Application::CompareWithFile() {
+    diffValid_ = false;
+    mergeConflicts_.clear();
+    if (!TerritoryParser::LoadFromFile(diffOtherPath_, diffOtherData_)) {
+        std::cerr << "Failed to load file: " << diffOtherPath_ << std::endl;
+        return;
+    }
+    
+    diffResult_ = TerritoryDiff::Compare(territoryData_, diffOtherData_, diffTolerance_);
+    diffValid_ = true;
+}
+
+void Application::MergeWithFile() {
+    TerritoryData base;
+    if (!TerritoryParser::LoadFromFile(diffBasePath_, base)) {
+        std::cerr << "Failed to load file: " << diffBasePath_ << std::endl;
+        return;
+    }
+    if (!TerritoryParser::LoadFromFile(diffOtherPath_, diffOtherData_)) {
+        std::cerr << "Failed to load file: " << diffOtherPath_ << std::endl;
+        return;
+    }
+    
+    TerritoryMergeResult merge = TerritoryDiff::Merge(base, territoryData_, diffOtherData_, diffTolerance_);
+    
+    SaveUndoState();
+    territoryData_ = std::move(merge.merged);
+    ResetSelection();
+    journal_.Reset(territoryData_, currentFilePath_, false);
+    InvalidateAllZones();
+    
+    mergeConflicts_ = std::move(merge.conflicts);
+    diffValid_ = false;
+    std::cout << "Merged " << merge.appliedFromTheirs << " change(s), " << mergeConflicts_.size() << " conflict(s)" << std::endl;
+}
+
+void Application::RenderDiffWindow() {
+    ImGui::SetNextWindowSize(ImVec2(600, 500), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Compare Files", &showDiffWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    std::string browsedPath;
+    ImGui::InputText("Other file", diffOtherPath_, sizeof(diffOtherPath_));
+    ImGui::SameLine();
+    if (ImGui::Button("Browse##other") && BrowseForFile(browsedPath)) {
+        snprintf(diffOtherPath_, sizeof(diffOtherPath_), "%s", browsedPath.c_str());
+    }
+    
+    ImGui::InputText("Base (merge)", diffBasePath_, sizeof(diffBasePath_));
+    ImGui::SameLine();
+    if (ImGui::Button("Browse##base") && BrowseForFile(browsedPath)) {
+        snprintf(diffBasePath_, sizeof(diffBasePath_), "%s", browsedPath.c_str());
+    }
+    
+    ImGui::DragFloat("Match tolerance (m)", &diffTolerance_, 1.0f, 0.0f, 1000.0f, "%.1f");
+    
+    if (ImGui::Button("Compare") && diffOtherPath_[0] != '\0') {
+        CompareWithFile();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Merge Into Document") && diffOtherPath_[0] != '\0' && diffBasePath_[0] != '\0') {
+        MergeWithFile();
+    }
+    
+    ImGui::Separator();
+    
+    if (!mergeConflicts_.empty()) {
+        ImGui::Text("%zu merge conflict(s), our version was kept:", mergeConflicts_.size());
+        ImGui::BeginChild("Conflicts", ImVec2(0, 120), true);
+        for (size_t i = 0; i < mergeConflicts_.size(); ++i) {
+            const MergeConflict& conflict = mergeConflicts_[i];
+            ImGui::PushID(static_cast<int>(i));
+            std::string label = conflict.territoryName + ": " + conflict.description;
+            if (ImGui::Selectable(label.c_str())) {
+                mapView_.CenterOn(conflict.x, conflict.z);
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndChild();
+    }
+    
+    if (!diffValid_) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::Text("%zu added, %zu removed, %zu moved, %zu changed, %zu unchanged",
+                diffResult_.addedCount, diffResult_.removedCount, diffResult_.movedCount,
+                diffResult_.changedCount, diffResult_.unchangedCount);
+    
+    // Entries refer to zones by index; edits since the comparison can invalidate them
+    ImGui::BeginChild("DiffEntries", ImVec2(0, 0), true);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(diffResult_.entries.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const ZoneDiffEntry& entry = diffResult_.entries[i];
+            const Zone* ourZone = territoryData_.getZone(entry.oldRef);
+            const Zone* otherZone = diffOtherData_.getZone(entry.newRef);
+            if ((entry.oldRef.valid() && !ourZone) || (entry.newRef.valid() && !otherZone)) {
+                ImGui::TextDisabled("(out of date, compare again)");
+                continue;
+            }
+            
+            ImGui::PushID(i);
+            std::string label = TerritoryDiff::FormatEntry(entry, territoryData_, diffOtherData_);
+            if (ImGui::Selectable(label.c_str())) {
+                if (ourZone) {
+                    FocusZone(territoryData_.getZone(entry.oldRef));
+                } else {
+                    mapView_.CenterOn(otherZone->x, otherZone->z);
+                }
+            }
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+    
+    ImGui::End();
+}
+
+void Application::FinishRegionSelection(bool addToSelection) {
+    std::vector<RegionPoint> polygon = mapView_.GetRegionPoints();
+    mapView_.EndRegionSelection();
+    if (polygon.size() < 3) {
+        return;
+    }
+    
+    SelectRegion(polygon, addToSelection);
+    lastRegion_ = std::move(polygon);
+}
+
+void Application::SelectRegion(const std::vector<RegionPoint>& polygon, bool addToSelection) {
+    auto zones = mapView_.GetZonesInPolygon(territoryData_, polygon);
+    if (!addToSelection) {
+        ClearSelection();
+    }
+    for (auto* zone : zones) {
+        SelectZone(zone, true);
+    }
+}
+
+void Application::CompileQuery() {
+    auto findRegion = [this](const std::string& name) -> const SelectionRegion* {
+        for (const auto& region : savedRegions_) {
+            if (region.name == name) {
+                return &region;
+            }
+        }
+        return nullptr;
+    };
+    query_.Compile(queryText_, queryError_, findRegion);
+}
+
+void Application::ApplyQuery() {
+    if (query_.IsEmpty()) {
+        return;
+    }
+    
+    if (attributeIndexRevision_ != documentRevision_) {
+        attributeIndex_.Invalidate();
+        attributeIndexRevision_ = documentRevision_;
+    }
+    attributeIndex_.Update(territoryData_);
+    
+    std::vector<uint32_t> matches;
+    query_.Evaluate(attributeIndex_, mapView_.GetZoneIndex(territoryData_), matches);
+    queryMatchCount_ = matches.size();
+    
+    ClearSelection();
+    selectedZones_.reserve(matches.size());
+    for (uint32_t index : matches) {
+        SelectZone(territoryData_.getZone(attributeIndex_.GetRef(index)), true);
+    }
+}
+
+void Application::RenderRegionsWindow() {
+    if (!ImGui::Begin("Regions", &showRegionsWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    const std::string& mapName = mapView_.GetCurrentMap().name;
+    bool changed = false;
+    
+    // Save the outline of the last lasso / polygon selection
+    ImGui::BeginDisabled(lastRegion_.empty());
+    ImGui::InputTextWithHint("##name", "Region name", regionName_, sizeof(regionName_));
+    ImGui::SameLine();
+    if (ImGui::Button("Save Last Selection") && regionName_[0] != '\0') {
+        SelectionRegion region;
+        region.name = regionName_;
+        region.mapName = mapName;
+        region.points = lastRegion_;
+        savedRegions_.push_back(std::move(region));
+        regionName_[0] = '\0';
+        changed = true;
+    }
+    ImGui::EndDisabled();
+    ImGui::Separator();
+    
+    // Regions of the current map; hovering one outlines it on the map
+    int hovered = -1;
+    int toDelete = -1;
+    for (int i = 0; i < static_cast<int>(savedRegions_.size()); ++i) {
+        const SelectionRegion& region = savedRegions_[i];
+        if (region.mapName != mapName) {
+            continue;
+        }
+        
+        ImGui::PushID(i);
+        if (ImGui::Button("Select")) {
+            SelectRegion(region.points, ImGui::GetIO().KeyCtrl);
+        }
+        if (ImGui::IsItemHovered()) {
+            hovered = i;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Delete")) {
+            toDelete = i;
+        }
+        ImGui::SameLine();
+        ImGui::Text("%s (%zu points)", region.name.c_str(), region.points.size());
+        if (ImGui::IsItemHovered()) {
+            hovered = i;
+        }
+        ImGui::PopID();
+    }
+    
+    if (toDelete >= 0) {
+        savedRegions_.erase(savedRegions_.begin() + toDelete);
+        hovered = -1;
+        changed = true;
+    }
+    if (changed || hovered != highlightedRegion_) {
+        highlightedRegion_ = hovered;
+        mapView_.SetHighlightedRegion(hovered >= 0 ? savedRegions_[hovered].points : std::vector<RegionPoint>());
+    }
+    if (changed && !SelectionRegionStore::SaveToFile(SelectionRegionStore::DefaultPath(), savedRegions_)) {
+        std::cerr << "Failed to save regions: " << SelectionRegionStore::DefaultPath() << std::endl;
+    }
+    
+    ImGui::End();
+}
+
+void Application::RenderIssuesWindow() {
+    ImGui::SetNextWindowSize(ImVec2(500, 400), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Issues", &showIssuesWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::Text("%zu error(s), %zu warning(s)", validator_.GetErrorCount(), validator_.GetWarningCount());
+    if (validator_.GetErrorCount() > 0) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Saving is blocked until errors are fixed");
+    }
+    ImGui::Separator();
+    
+    const std::vector<ValidationIssue>& issues = validator_.GetIssues();
+    ImGui::BeginChild("IssueList", ImVec2(0, 0), false);
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(issues.size()));
+    while (clipper.Step()) {
+        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; ++i) {
+            const ValidationIssue& issue = issues[i];
+            bool isError = TerritoryValidator::GetSeverity(issue.rule) == ValidationSeverity::Error;
+            
+            ImGui::PushID(i);
+            ImGui::PushStyleColor(ImGuiCol_Text, isError ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) : ImVec4(1.0f, 0.85f, 0.3f, 1.0f));
+            std::string label = TerritoryValidator::FormatIssue(issue, territoryData_);
+            if (ImGui::Selectable(label.c_str())) {
+                if (Zone* zone = territoryData_.getZone(issue.ref)) {
+                    FocusZone(zone);
+                }
+            }
+            ImGui::PopStyleColor();
+            ImGui::PopID();
+        }
+    }
+    ImGui::EndChild();
+    
+    ImGui::End();
+}
+
+void Application::StartSimulation() {
+    const MapInfo& map = mapView_.GetCurrentMap();
+    simSettings_.worldSizeX = map.worldSizeX;
+    simSettings_.worldSizeZ = map.worldSizeZ;
+    
+    // Capture is a quick copy; the rounds themselves run off the main thread
+    SpawnSimulator::Input input = SpawnSimulator::Capture(territoryData_, simSettings_);
+    simFuture_ = JobSystem::Async("Spawn simulation", [input = std::move(input)]() {
+        return SpawnSimulator::Run(input);
+    });
+    simRevision_ = documentRevision_;
+}
+
+void Application::PollSimulation() {
+    if (simFuture_.valid()) {
+        if (simFuture_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+        simResult_ = simFuture_.get();
+        simValid_ = true;
+        UpdateSimulationOverlay();
+    }
+    
+    // Rerun once an edit is finished, not on every frame of a drag or while typing a value
+    const MapInfo& map = mapView_.GetCurrentMap();
+    bool stale = simRevision_ != documentRevision_ ||
+                 simResult_.settings.worldSizeX != map.worldSizeX || simResult_.settings.worldSizeZ != map.worldSizeZ;
+    if (simValid_ && simAutoRerun_ && stale && !isDraggingZone_ && !ImGui::IsAnyItemActive()) {
+        StartSimulation();
+    }
+}
+
+void Application::UpdateSimulationOverlay() {
+    if (!simValid_ || simOverlayMode_ == 0) {
+        mapView_.ClearCellOverlay();
+    } else if (simOverlayMode_ == 1) {
+        mapView_.SetCellOverlay(simResult_.cellMean, simResult_.settings.gridSize, simResult_.maxCellMean);
+    } else {
+        mapView_.SetCellOverlay(simResult_.cellP95, simResult_.settings.gridSize, simResult_.maxCellP95);
+    }
+}
+
+void Application::RenderSimulationWindow() {
+    ImGui::SetNextWindowSize(ImVec2(520, 500), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Spawn Simulation", &showSimulationWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::SliderInt("Rounds", &simSettings_.rounds, 16, SpawnSimulator::MAX_ROUNDS);
+    ImGui::SliderInt("Grid cells per side", &simSettings_.gridSize, 16, SpawnSimulator::MAX_GRID_SIZE);
+    ImGui::Checkbox("Rerun after edits", &simAutoRerun_);
+    
+    bool running = simFuture_.valid();
+    ImGui::BeginDisabled(running);
+    if (ImGui::Button("Run")) {
+        StartSimulation();
+    }
+    ImGui::EndDisabled();
+    if (running) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("Running...");
+    }
+    
+    if (ImGui::Combo("Overlay", &simOverlayMode_, "Off\0Expected population\095th percentile\0")) {
+        UpdateSimulationOverlay();
+    }
+    
+    if (!simValid_) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::Separator();
+    ImGui::Text("Expected total: %.0f spawns (%d rounds, %.1f ms)", simResult_.totalMean,
+                simResult_.settings.rounds, simResult_.elapsedMs);
+    if (simRevision_ != documentRevision_) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(out of date)");
+    }
+    
+    if (ImGui::BeginTable("Populations", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Territory");
+        ImGui::TableSetupColumn("Zones");
+        ImGui::TableSetupColumn("Mean");
+        ImGui::TableSetupColumn("P5");
+        ImGui::TableSetupColumn("P50");
+        ImGui::TableSetupColumn("P95");
+        ImGui::TableHeadersRow();
+        
+        for (const TerritoryPopulation& population : simResult_.territories) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(NameTable::CStr(population.name));
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", population.zoneCount);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", population.mean);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", population.p5);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", population.p50);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", population.p95);
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::End();
+}
+
+void Application::GenerateFill() {
+    std::vector<RegionPoint> outline;
+    if (fillSource_ == 0) {
+        outline = lastRegion_;
+    } else if (fillSource_ == 1) {
+        outline = ZoneGenerator::MakeRect(std::min(fillRect_[0], fillRect_[2]), std::min(fillRect_[1], fillRect_[3]),
+                                          std::max(fillRect_[0], fillRect_[2]), std::max(fillRect_[1], fillRect_[3]));
+    } else if (fillSource_ - 2 < static_cast<int>(savedRegions_.size())) {
+        outline = savedRegions_[fillSource_ - 2].points;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    ZoneGenerator::PoissonFill(outline, fillSettings_, mapView_.GetZoneIndex(territoryData_), fillPreview_, fillError_);
+    fillElapsedMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    mapView_.SetPreviewZones(fillPreview_, fillSettings_.radius);
+}
+
+void Application::CommitFill() {
+    if (fillPreview_.empty() || fillTerritory_ < 0 || fillTerritory_ >= static_cast<int>(territoryData_.territories.size())) {
+        return;
+    }
+    
+    // One undo step for the whole fill; clear the selection before zone storage can move
+    SaveUndoState();
+    ClearSelection();
+    
+    auto& territory = territoryData_.territories[fillTerritory_];
+    size_t firstNew = territory.zones.size();
+    territory.zones.reserve(firstNew + fillPreview_.size());
+    for (const auto& center : fillPreview_) {
+        Zone zone;
+        zone.name = territory.name;
+        zone.x = center.x;
+        zone.z = center.z;
+        zone.r = fillSettings_.radius;
+        zone.smin = fillCounts_[0];
+        zone.smax = fillCounts_[1];
+        zone.dmin = fillCounts_[2];
+        zone.dmax = fillCounts_[3];
+        territory.zones.push_back(zone);
+    }
+    journal_.RecordAddZones(static_cast<uint32_t>(fillTerritory_), territory.zones.data() + firstNew, fillPreview_.size());
+    InvalidateAllZones();
+    
+    // Leave the new zones selected so they can be adjusted together
+    for (size_t i = firstNew; i < territory.zones.size(); ++i) {
+        SelectZone(&territory.zones[i], true);
+    }
+    std::cout << "Added " << fillPreview_.size() << " generated zones to " << NameTable::CStr(territory.name) << std::endl;
+    fillPreview_.clear();
+    mapView_.ClearPreviewZones();
+}
+
+void Application::RenderFillWindow() {
+    ImGui::SetNextWindowSize(ImVec2(420, 0), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Generate Zones", &showFillWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    // Area to fill
+    std::string sourceLabel = fillSource_ == 0 ? "Last lasso / polygon" : fillSource_ == 1 ? "Rectangle" :
+        fillSource_ - 2 < static_cast<int>(savedRegions_.size()) ? "Region: " + savedRegions_[fillSource_ - 2].name : "(none)";
+    if (ImGui::BeginCombo("Area", sourceLabel.c_str())) {
+        if (ImGui::Selectable("Last lasso / polygon", fillSource_ == 0)) fillSource_ = 0;
+        if (ImGui::Selectable("Rectangle", fillSource_ == 1)) fillSource_ = 1;
+        for (size_t i = 0; i < savedRegions_.size(); ++i) {
+            ImGui::PushID(static_cast<int>(i));
+            std::string label = "Region: " + savedRegions_[i].name;
+            if (ImGui::Selectable(label.c_str(), fillSource_ == static_cast<int>(i) + 2)) {
+                fillSource_ = static_cast<int>(i) + 2;
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+    if (fillSource_ == 1) {
+        ImGui::InputFloat2("Min (X, Z)", &fillRect_[0], "%.0f");
+        ImGui::InputFloat2("Max (X, Z)", &fillRect_[2], "%.0f");
+    }
+    
+    // Target territory and the values generated zones get
+    const char* territoryLabel = fillTerritory_ < static_cast<int>(territoryData_.territories.size())
+        ? NameTable::CStr(territoryData_.territories[fillTerritory_].name) : "(none)";
+    if (ImGui::BeginCombo("Territory", territoryLabel)) {
+        for (size_t i = 0; i < territoryData_.territories.size(); ++i) {
+            ImGui::PushID(static_cast<int>(i));
+            if (ImGui::Selectable(NameTable::CStr(territoryData_.territories[i].name), fillTerritory_ == static_cast<int>(i))) {
+                fillTerritory_ = static_cast<int>(i);
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::InputInt4("smin smax dmin dmax", fillCounts_);
+    
+    ImGui::Separator();
+    ImGui::DragFloat("Spacing (m)", &fillSettings_.spacing, 1.0f, 5.0f, 5000.0f, "%.0f");
+    ImGui::DragFloat("Zone radius (m)", &fillSettings_.radius, 1.0f, 1.0f, 1000.0f, "%.0f");
+    ImGui::DragFloat("Clearance (m)", &fillSettings_.clearance, 1.0f, 0.0f, 1000.0f, "%.0f");
+    ImGui::InputInt("Max zones", &fillSettings_.maxZones);
+    int seed = static_cast<int>(fillSettings_.seed);
+    if (ImGui::InputInt("Seed", &seed)) {
+        fillSettings_.seed = static_cast<uint32_t>(seed);
+    }
+    fillSettings_.spacing = std::max(fillSettings_.spacing, 1.0f);
+    fillSettings_.maxZones = std::max(fillSettings_.maxZones, 1);
+    
+    if (ImGui::Button("Preview")) {
+        GenerateFill();
+    }
+    ImGui::SameLine();
+    ImGui::BeginDisabled(fillPreview_.empty());
+    if (ImGui::Button("Add Zones")) {
+        CommitFill();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Discard")) {
+        fillPreview_.clear();
+        mapView_.ClearPreviewZones();
+    }
+    ImGui::EndDisabled();
+    
+    if (!fillError_.empty()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", fillError_.c_str());
+    } else if (!fillPreview_.empty()) {
+        ImGui::TextDisabled("%zu zones generated in %.1f ms", fillPreview_.size(), fillElapsedMs_);
+    }
+    
+    ImGui::End();
+}
+
+void Application::FindDuplicates() {
+    auto start = std::chrono::steady_clock::now();
+    ZoneDeduplicator::FindDuplicates(territoryData_, dedupSettings_, dedupGroups_);
+    dedupElapsedMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    dedupRevision_ = documentRevision_;
+}
+
+void Application::MergeDuplicates() {
+    // Only merge what the user was shown; groups found for an older document need a new Find
+    if (dedupRevision_ != documentRevision_) {
+        std::cerr << "Duplicate groups are out of date; run Find again before merging" << std::endl;
+        return;
+    }
+    if (dedupGroups_.GetGroupCount() == 0) {
+        return;
+    }
+    
+    // One undo step for the whole merge; clear the selection before zone storage moves
+    SaveUndoState();
+    ClearSelection();
+    
+    std::vector<ZoneRef> removedRefs;
+    removedRefs.reserve(dedupGroups_.GetDuplicateCount());
+    size_t removed = ZoneDeduplicator::RemoveDuplicates(territoryData_, dedupGroups_, &removedRefs);
+    journal_.RecordRemoveZones(removedRefs);
+    InvalidateAllZones();
+    
+    std::cout << "Merged " << dedupGroups_.GetGroupCount() << " duplicate group(s), removed " << removed << " zone(s)" << std::endl;
+    dedupGroups_.clear();
+    dedupRevision_ = documentRevision_;
+}
+
+void Application::RenderDedupWindow() {
+    ImGui::SetNextWindowSize(ImVec2(420, 400), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Duplicate Zones", &showDedupWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::InputFloat("Max distance", &dedupSettings_.distance, 0.5f, 5.0f, "%.2f");
+    ImGui::InputFloat("Max radius difference", &dedupSettings_.radiusTolerance, 0.5f, 5.0f, "%.2f");
+    ImGui::Checkbox("Same spawn counts", &dedupSettings_.matchCounts);
+    dedupSettings_.distance = std::max(dedupSettings_.distance, 0.0f);
+    dedupSettings_.radiusTolerance = std::max(dedupSettings_.radiusTolerance, 0.0f);
+    
+    if (ImGui::Button("Find")) {
+        FindDuplicates();
+    }
+    bool stale = dedupRevision_ != documentRevision_ && dedupRevision_ != UINT64_MAX;
+    ImGui::SameLine();
+    ImGui::BeginDisabled(stale || dedupGroups_.GetGroupCount() == 0);
+    if (ImGui::Button("Merge All")) {
+        MergeDuplicates();
+    }
+    ImGui::EndDisabled();
+    
+    if (dedupRevision_ != UINT64_MAX) {
+        ImGui::TextDisabled("%zu group(s), %zu duplicate zone(s) in %.1f ms%s", dedupGroups_.GetGroupCount(),
+                            dedupGroups_.GetDuplicateCount(), dedupElapsedMs_, stale ? " - out of date" : "");
+    }
+    ImGui::Separator();
+    
+    // Groups are only listed for the document they were found in; their refs may be stale otherwise
+    if (!stale) {
+        ImGui::BeginChild("DuplicateList", ImVec2(0, 0), false);
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(dedupGroups_.GetGroupCount()));
+        while (clipper.Step()) {
+            for (int g = clipper.DisplayStart; g < clipper.DisplayEnd; ++g) {
+                uint32_t begin = dedupGroups_.groupStart[g];
+                uint32_t end = dedupGroups_.groupStart[g + 1];
+                const ZoneRef& first = dedupGroups_.members[begin];
+                const Zone* zone = territoryData_.getZone(first);
+                if (!zone) continue;
+                
+                ImGui::PushID(g);
+                char label[256];
+                snprintf(label, sizeof(label), "%s (%.1f, %.1f): %u zones",
+                          NameTable::CStr(territoryData_.territories[first.territory].name), zone->x, zone->z, end - begin);
+                if (ImGui::Selectable(label)) {
+                    // Select the whole group and center on the zone a merge would keep
+                    ClearSelection();
+                    for (uint32_t m = begin; m < end; ++m) {
+                        SelectZone(territoryData_.getZone(dedupGroups_.members[m]), true);
+                    }
+                    mapView_.CenterOn(zone->x, zone->z);
+                }
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndChild();
+    }
+    
+    ImGui::End();
+}
+
+void Application::SampleMemory() {
+    framesSinceMemorySample_ = 0;
+    
+    memoryStats_.Set("document", territoryData_.getMemoryUsage());
+    memoryStats_.Set("document.names", NameTable::GetMemoryUsage());
+    memoryStats_.Set("document.source_text", source_.GetMemoryUsage());
+    size_t undoBytes = 0;
+    for (const TerritoryData& snapshot : undoStack_) {
+        undoBytes += snapshot.getMemoryUsage();
+    }
+    memoryStats_.Set("undo", undoBytes);
+    // loadData_ and a running reload's reloadData_ belong to their worker threads until they finish
+    size_t otherBytes = loadPreview_.getMemoryUsage() + diffOtherData_.getMemoryUsage();
+    if (!reloadFuture_.valid()) {
+        otherBytes += reloadData_.getMemoryUsage();
+    }
+    memoryStats_.Set("documents.other", otherBytes);
+    
+    memoryStats_.Set("textures.uploaded", mapView_.GetTextureCache().GetResidentBytes());
+    memoryStats_.Set("textures.decoded", TextureCache::GetDecodedBytes());
+    
+    memoryStats_.Set("cache.map_view", mapView_.GetCacheMemoryUsage());
+    memoryStats_.Set("cache.attribute_index", attributeIndex_.GetMemoryUsage());
+    memoryStats_.Set("cache.validator", validator_.GetMemoryUsage());
+    memoryStats_.Set("cache.territory_stats", stats_.GetMemoryUsage());
+    memoryStats_.Set("cache.duplicates", dedupGroups_.members.capacity() * sizeof(ZoneRef) +
+                                         dedupGroups_.groupStart.capacity() * sizeof(uint32_t));
+    memoryStats_.Set("cache.simulation", simResult_.territories.capacity() * sizeof(TerritoryPopulation) +
+                                         (simResult_.cellMean.capacity() + simResult_.cellP95.capacity()) * sizeof(float));
+    memoryStats_.Set("journal.queue", journal_.GetQueuedBytes());
+    
+    // Includes ImGui's draw lists, font atlas and window state
+    memoryStats_.Set("imgui.heap", MemoryStats::GetImGuiHeapBytes(), MemoryStats::GetImGuiPeakHeapBytes());
+    memoryStats_.FinishSample();
+}
+
+void Application::RenderMemoryWindow() {
+    ImGui::SetNextWindowSize(ImVec2(420, 400), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Memory", &showMemoryWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::Text("Total: %s (peak %s)", MemoryStats::FormatBytes(memoryStats_.GetTotal()).c_str(),
+                MemoryStats::FormatBytes(memoryStats_.GetPeakTotal()).c_str());
+    if (ImGui::Button("Reset Peaks")) {
+        memoryStats_.ResetPeaks();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Copy JSON")) {
+        ImGui::SetClipboardText(memoryStats_.ToJson().c_str());
+    }
+    ImGui::TextDisabled("Estimated from container capacities; the ImGui heap is counted exactly");
+    
+    if (ImGui::BeginTable("Memory", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("Current");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableHeadersRow();
+        
+        for (const MemoryStats::Entry& entry : memoryStats_.GetEntries()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(entry.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemoryStats::FormatBytes(entry.bytes).c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(MemoryStats::FormatBytes(entry.peak).c_str());
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::End();
+}
+
+void Application::RenderJobsWindow() {
+    ImGui::SetNextWindowSize(ImVec2(480, 360), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Jobs", &showJobsWindow_)) {
+        ImGui::End();
+        return;
+    }
+    
+    ImGui::Text("%zu worker thread(s)", JobSystem::GetWorkerCount());
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) {
+        JobSystem::ResetTaskStats();
+    }
+    
+    if (ImGui::BeginTable("Jobs", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Task");
+        ImGui::TableSetupColumn("Runs");
+        ImGui::TableSetupColumn("Total ms");
+        ImGui::TableSetupColumn("Mean ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+        
+        for (const JobSystem::TaskStats& task : JobSystem::GetTaskStats()) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(task.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", task.runs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", task.totalMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", task.totalMs / task.runs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", task.maxMs);
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::End();
+}
+
+void Application::StartJournal(bool matchesFile) {
+    journal_.Start(EditJournal::DefaultPath());
+    journal_.Reset(territoryData_, currentFilePath_, matchesFile);
+    InvalidateAllZones();
+}
+
+void Application::JournalSelectedZones() {
+    for (uint32_t t = 0; t < territoryData_.territories.size(); ++t) {
+        const auto& zones = territoryData_.territories[t].zones;
+        for (uint32_t z = 0; z < zones.size(); ++z) {
+            if (zones[z].selected) {
+                journal_.RecordZone({ t, z }, zones[z]);
+                MarkZoneDirty({ t, z });
+            }
+        }
+    }
+}
+
+void Application::MarkZoneDirty(ZoneRef ref) {
+    validator_.MarkDirty(ref);
+    stats_.MarkDirty(ref);
+}
+
+void Application::InvalidateAllZones() {
+    validator_.InvalidateAll();
+    stats_.InvalidateAll();
+}
+
+void Application::RenderRecoveryPrompt() {
+    if (showRecoveryPrompt_) {
+        ImGui::OpenPopup("Recover Session");
+        showRecoveryPrompt_ = false;
+    }
+    
+    if (ImGui::BeginPopupModal("Recover Session", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::Text("The editor closed with unsaved changes.");
+        ImGui::Text("Recover them from the edit journal?");
+        ImGui::Separator();
+        
+        if (ImGui::Button("Recover")) {
+            std::string filePath;
+            if (EditJournal::Recover(EditJournal::DefaultPath(), territoryData_, filePath)) {
+                currentFilePath_ = filePath;
+                fileLoaded_ = !filePath.empty();
+                documentModified_ = true;
+                source_.Detach();
+                documentRevision_++;
+                ResetSelection();
+                if (fileLoaded_) {
+                    fileWatcher_.Watch(filePath);
+                }
+                std::cout << "Recovered " << territoryData_.getTotalZoneCount() << " zones for " << filePath << std::endl;
+            }
+            StartJournal(false);
+            ImGui::CloseCurrentPopup();
+        }
+        
+        ImGui::SameLine();
+        if (ImGui::Button("Discard")) {
+            StartJournal(true);
+            ImGui::CloseCurrentPopup();
+        }
+        
+        ImGui::EndPopup();
+    }
+}
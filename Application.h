@@ -1,12 +1,29 @@
 #pragma once
 
 #include "TerritoryData.h"
+#include "TerritoryParser.h"
 #include "MapView.h"
+#include "FileWatcher.h"
+#include "TerritoryDiff.h"
+#include "EditJournal.h"
+#include "TerritoryValidator.h"
+#include "TerritoryStats.h"
+#include "SpawnSimulator.h"
+#include "ZoneAttributeIndex.h"
+#include "ZoneQuery.h"
+#include "ZoneSnapper.h"
+#include "ZoneGenerator.h"
+#include "TerritorySource.h"
+#include "ZoneDeduplicator.h"
+#include "InputRecording.h"
+#include "MemoryStats.h"
+#include "JobSystem.h"
 #include <GLFW/glfw3.h>
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
+#include <future>
+#include <deque>
 
 class Application {
 public:
@@ -17,30 +34,208 @@ public:
     void Shutdown();
     void Run();
     
+    // Loads filePath and waits for it, so a recording or replay starts from a known document
+    bool LoadFileBlocking(const std::string& filePath);
+    
+    // Records the input stream of the interactive session to path (see InputRecording.h)
+    bool StartRecording(const std::string& path);
+    // Replays a recording headless (no window, no GL) and prints per-phase frame times.
+    // Returns the process exit code.
+    int RunReplay(const std::string& recordingPath, const std::string& filePath);
+    // Loads filePath headless, replays the recording if one is given (otherwise runs a couple of
+    // idle frames so the editor's caches get built) and writes the memory accounting to jsonPath
+    int RunMemoryReport(const std::string& filePath, const std::string& jsonPath, const std::string& recordingPath);
+
 private:
+    // ImGui context, fonts and map for running frames without a window; loads filePath if given
+    bool InitializeHeadless(const std::string& filePath);
+    void ReplayFrames(const InputReplay& replay, FrameStats& stats);
+    // Everything in a frame between ImGui::NewFrame and ImGui::Render, inclusive of Render
+    void UpdateFrame(FrameTimes& times);
     void RenderUI();
     void RenderTerritoryHierarchy();
+    void UpdateHierarchyRows();
+    void RenderHierarchyRow(size_t territoryIndex);
     void RenderMapView();
     void RenderInspector();
+    void RenderZoneStats(const ZoneAggregate& stats);  // Min/mean/max/sum table and bounding box
     
     void HandleInput();
     void ClearSelection();
     void SelectZone(Zone* zone, bool addToSelection = false);
     void DeleteSelectedZones();
+    
+    // Clipboard - see ZoneClipboard for the format
+    void CopySelectedZones();
+    void CutSelectedZones();
+    // At the map cursor when it is over the map, else where the zones were copied from
+    void PasteZones(bool atCursor);
     void ShowAddZoneDialog(float worldX, float worldZ);
     void SaveUndoState();
     void Undo();
     void OpenFileDialog();
+    bool BrowseForFile(std::string& filePath);
+    // Starts loading in the background; the current document stays until the load succeeds
+    bool LoadFile(const std::string& filePath);
+    bool IsLoading() const { return loadFuture_.valid(); }
+    void CancelLoad();
+    void PollLoad();
+    void RenderLoadProgress(const ImVec2& canvasPos, const ImVec2& canvasSize);
+    bool SaveCurrentFile();
+    void MarkDocumentModified();
+    
+    // External change handling
+    void PollExternalChanges();
+    void ApplyExternalChanges(const TerritoryData& diskData);
+    void RenderExternalChangePrompt();
+    
+    // Compare / merge with another file
+    void RenderDiffWindow();
+    void CompareWithFile();
+    void MergeWithFile();
+    void FocusZone(Zone* zone);
+    void ResetSelection();
+    
+    // Lasso / polygon selection and saved regions
+    void FinishRegionSelection(bool addToSelection);
+    void SelectRegion(const std::vector<RegionPoint>& polygon, bool addToSelection);
+    void RenderRegionsWindow();
+    
+    // Zone query
+    void CompileQuery();
+    void ApplyQuery();
+    
+    // Procedural zone fill
+    void GenerateFill();
+    void CommitFill();
+    void RenderFillWindow();
+    
+    // Duplicate zones
+    void FindDuplicates();
+    void MergeDuplicates();
+    void RenderDedupWindow();
+    
+    // Validation
+    void RenderIssuesWindow();
+    
+    // Spawn simulation
+    void StartSimulation();
+    void PollSimulation();
+    void UpdateSimulationOverlay();
+    void RenderSimulationWindow();
+    
+    // Memory accounting
+    void SampleMemory();
+    void RenderMemoryWindow();
+    
+    // Job timings
+    void RenderJobsWindow();
+    
+    // Edit journal / crash recovery
+    void StartJournal(bool matchesFile);
+    void JournalSelectedZones();
+    void RenderRecoveryPrompt();
+    
+    // Tell the validator and the stats about edits
+    void MarkZoneDirty(ZoneRef ref);
+    void InvalidateAllZones();
     
     TerritoryData territoryData_;
     MapView mapView_;
     
     std::string currentFilePath_;
     bool fileLoaded_ = false;
+    bool documentModified_ = false;  // Unsaved local edits since last load/save
+    uint64_t documentRevision_ = 0;  // Bumped on every change to the document
+    
+    // Original text of the current file; saves patch it instead of rewriting everything
+    TerritorySource source_;
+    bool preserveFormatting_ = true;
+    
+    // Background load - parsed into loadData_, swapped in only when complete
+    std::future<bool> loadFuture_;
+    std::unique_ptr<LoadProgress> loadProgress_;
+    TerritoryData loadData_;
+    TerritoryData loadPreview_;      // Territories parsed so far, shown on the map while loading
+    TerritorySource loadSource_;     // Text of the file being loaded, tied to loadData_
+    std::string loadPath_;
+    
+    // Hot reload - file is reparsed in the background when changed on disk
+    FileWatcher fileWatcher_;
+    std::future<bool> reloadFuture_;
+    TerritoryData reloadData_;
+    bool reloadPending_ = false;     // reloadData_ is parsed and waiting to be applied
+    bool showConflictPrompt_ = false;
+    
+    // Edit journal - replayed on the next start if we die before saving
+    EditJournal journal_;
+    bool showRecoveryPrompt_ = false;
+    
+    // Validation - told about every edit the journal records, blocks saving on errors
+    TerritoryValidator validator_;
+    bool showIssuesWindow_ = false;
+    
+    // Per-territory, document and selection aggregates for the hierarchy and inspector
+    TerritoryStats stats_;
+    
+    // Spawn simulation - runs in the background, reruns after edits when enabled
+    bool showSimulationWindow_ = false;
+    SpawnSimSettings simSettings_;
+    std::future<SpawnSimResult> simFuture_;
+    uint64_t simRevision_ = 0;       // Document revision the running/last simulation was started from
+    SpawnSimResult simResult_;
+    bool simValid_ = false;
+    bool simAutoRerun_ = true;
+    int simOverlayMode_ = 1;         // 0 = off, 1 = mean, 2 = 95th percentile
+    
+    // Compare / merge
+    bool showDiffWindow_ = false;
+    char diffOtherPath_[260] = "";
+    char diffBasePath_[260] = "";
+    float diffTolerance_ = TerritoryDiff::DEFAULT_TOLERANCE;
+    TerritoryData diffOtherData_;
+    TerritoryDiffResult diffResult_;
+    bool diffValid_ = false;
+    std::vector<MergeConflict> mergeConflicts_;
     
     // Selection
     std::vector<Zone*> selectedZones_;
     Territory* selectedTerritory_ = nullptr;
+    SelectionTool selectionTool_ = SelectionTool::Marquee;
+    
+    // Saved regions
+    bool showRegionsWindow_ = false;
+    std::vector<SelectionRegion> savedRegions_;
+    std::vector<RegionPoint> lastRegion_;  // Outline of the last lasso/polygon selection
+    char regionName_[64] = "";
+    int highlightedRegion_ = -1;
+    
+    // Procedural fill - generated into a preview, added as one undoable edit on commit
+    bool showFillWindow_ = false;
+    ZoneFillSettings fillSettings_;
+    int fillSource_ = 0;              // 0 = last lasso/polygon, 1 = rectangle, 2 + i = saved region i
+    float fillRect_[4] = { 0.0f, 0.0f, 1000.0f, 1000.0f };  // minX, minZ, maxX, maxZ
+    int fillTerritory_ = 0;
+    int fillCounts_[4] = { 0, 0, 1, 3 };  // smin, smax, dmin, dmax of generated zones
+    std::vector<RegionPoint> fillPreview_;
+    std::string fillError_;
+    double fillElapsedMs_ = 0.0;
+    
+    // Duplicate zones - groups are found on request and merged as one undoable edit
+    bool showDedupWindow_ = false;
+    DedupSettings dedupSettings_;
+    DuplicateGroups dedupGroups_;
+    uint64_t dedupRevision_ = UINT64_MAX;  // documentRevision_ the groups were found for
+    double dedupElapsedMs_ = 0.0;
+    
+    // Zone query - recompiled on every keystroke; with live preview the matches become the selection
+    char queryText_[512] = "";
+    ZoneQuery query_;
+    std::string queryError_;
+    size_t queryMatchCount_ = 0;
+    bool queryLive_ = true;
+    ZoneAttributeIndex attributeIndex_;
+    uint64_t attributeIndexRevision_ = UINT64_MAX;  // Document revision attributeIndex_ was built from
     
     // UI State
     char searchFilter_[256] = "";
@@ -48,13 +243,33 @@ private:
     std::vector<MapInfo> availableMaps_;
     bool dockingInitialized_ = false;
     
+    // Hierarchy rows: territory indices after filtering and sorting, rebuilt only when the
+    // filter, the sort column or the order behind it changes
+    std::vector<uint32_t> hierarchyRows_;
+    int hierarchySortKey_ = -1;  // TerritorySortKey, or -1 for document order
+    bool hierarchySortDescending_ = false;
+    bool hierarchyRowsDirty_ = true;
+    uint64_t hierarchyRowsRevision_ = UINT64_MAX;  // stats_ order revision the rows were built from
+    
+    // Input recording and headless replay
+    InputRecorder recorder_;
+    bool replaying_ = false;         // Headless replay: no window, and nothing is written to disk
+    
+    // Memory accounting - sampled every frame while the panel is open or replaying, otherwise now and then
+    MemoryStats memoryStats_;
+    bool showMemoryWindow_ = false;
+    int framesSinceMemorySample_ = 0;
+    static const int MEMORY_SAMPLE_INTERVAL = 30;
+    bool showJobsWindow_ = false;
+    
     // Batch edit
     char batchEditValue_[64] = "";
     int batchEditField_ = 0; // 0=smin, 1=smax, 2=smin+smax, 3=dmin, 4=dmax, 5=dmin+dmax, 6=r
     bool batchEditPercentage_ = false;
     
     // Undo system
-    std::vector<TerritoryData> undoStack_;
+    // Each snapshot lives in its own arena; deque so trimming the oldest never moves the rest
+    std::deque<TerritoryData> undoStack_;
     static const size_t MAX_UNDO_STACK_SIZE = 50;
     
     // Add zone dialog
@@ -64,12 +279,29 @@ private:
     int selectedTerritoryTypeIndex_ = 0;
     std::vector<std::string> availableTerritoryTypes_;
     
+    // Hover inspection
+    std::vector<ZoneHit> hoveredZones_;
+    static constexpr float HOVER_TOLERANCE = 12.0f;  // Pixels from the cursor to a zone center
+    static const size_t MAX_HOVER_NEARBY = 4;
+    static const size_t MAX_HOVER_LISTED = 12;
+    
     // Zone dragging
     Zone* draggingZone_ = nullptr;
     float dragClickWorldX_ = 0.0f;
     float dragClickWorldZ_ = 0.0f;
+    float dragAnchorX_ = 0.0f;  // draggingZone_'s position when the drag started
+    float dragAnchorZ_ = 0.0f;
     bool isDraggingZone_ = false;
-    std::map<Zone*, std::pair<float, float>> dragOriginalPositions_;
+    std::vector<std::pair<float, float>> dragOriginalPositions_;  // Parallel to selectedZones_
+    
+    // Map cursor as of the last frame, for pasting at the cursor
+    bool mapHovered_ = false;
+    float mapCursorX_ = 0.0f;
+    float mapCursorZ_ = 0.0f;
+    
+    // Snapping - the grabbed zone snaps, the rest of the selection follows it
+    SnapSettings snapSettings_;
+    ZoneSnapper snapper_;
     
     GLFWwindow* window_ = nullptr;
 };
@@ -0,0 +1,213 @@
+#include "CommandLineTool.h"
+#include "TerritoryParser.h"
+#include "TerritoryDiff.h"
+#include "TerritoryValidator.h"
+#include "MapRegistry.h"
+#include "ZoneDeduplicator.h"
+#include "Application.h"
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+
+// Exit codes follow diff(1): 0 = no differences/clean, 1 = differences/conflicts/validation errors, 2 = error
+static const int EXIT_SAME = 0;
+static const int EXIT_DIFFERENT = 1;
+static const int EXIT_ERROR = 2;
+
+bool CommandLineTool::IsHeadlessCommand(int argc, char* argv[]) {
+    if (argc < 2) return false;
+    return std::strcmp(argv[1], "--diff") == 0 ||
+           std::strcmp(argv[1], "--merge") == 0 ||
+           std::strcmp(argv[1], "--validate") == 0 ||
+           std::strcmp(argv[1], "--dedup") == 0 ||
+           std::strcmp(argv[1], "--replay") == 0 ||
+           std::strcmp(argv[1], "--memory") == 0 ||
+           std::strcmp(argv[1], "--help") == 0;
+}
+
+int CommandLineTool::Run(int argc, char* argv[]) {
+    std::string command = argv[1];
+    
+    // Optional trailing "--tolerance <meters>"
+    float tolerance = TerritoryDiff::DEFAULT_TOLERANCE;
+    bool toleranceGiven = false;
+    if (argc >= 4 && std::strcmp(argv[argc - 2], "--tolerance") == 0) {
+        tolerance = static_cast<float>(std::atof(argv[argc - 1]));
+        toleranceGiven = true;
+        argc -= 2;
+    }
+    
+    if (command == "--diff" && argc == 4) {
+        return RunDiff(argv[2], argv[3], tolerance);
+    }
+    if (command == "--merge" && argc == 6) {
+        return RunMerge(argv[2], argv[3], argv[4], argv[5], tolerance);
+    }
+    if (command == "--validate" && argc == 3) {
+        return RunValidate(argv[2], nullptr);
+    }
+    if (command == "--validate" && argc == 5 && std::strcmp(argv[3], "--map") == 0) {
+        return RunValidate(argv[2], argv[4]);
+    }
+    if (command == "--dedup" && argc == 4) {
+        // The diff tolerance is far too coarse for duplicates, so only an explicit one applies
+        return RunDedup(argv[2], argv[3], toleranceGiven ? tolerance : DedupSettings().distance);
+    }
+    if (command == "--replay" && (argc == 3 || argc == 4)) {
+        return RunReplay(argv[2], argc == 4 ? argv[3] : nullptr);
+    }
+    if (command == "--memory" && (argc == 4 || argc == 5)) {
+        return RunMemoryReport(argv[2], argv[3], argc == 5 ? argv[4] : nullptr);
+    }
+    
+    PrintUsage();
+    return command == "--help" ? EXIT_SAME : EXIT_ERROR;
+}
+
+void CommandLineTool::PrintUsage() {
+    std::cout << "Usage:\n"
+              << "  TerritoryEditor [file.xml]\n"
+              << "  TerritoryEditor --diff <old.xml> <new.xml> [--tolerance <m>]\n"
+              << "  TerritoryEditor --merge <base.xml> <ours.xml> <theirs.xml> <out.xml> [--tolerance <m>]\n"
+              << "  TerritoryEditor --validate <file.xml> [--map <name>]\n"
+              << "  TerritoryEditor --dedup <in.xml> <out.xml> [--tolerance <m>]\n"
+              << "  TerritoryEditor --record <session.rec> [file.xml]\n"
+              << "  TerritoryEditor --replay <session.rec> [file.xml]\n"
+              << "  TerritoryEditor --memory <file.xml> <out.json> [session.rec]\n";
+}
+
+static bool LoadOrReport(const char* path, TerritoryData& data) {
+    if (!TerritoryParser::LoadFromFile(path, data)) {
+        std::cerr << "Failed to load file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int CommandLineTool::RunDiff(const char* oldPath, const char* newPath, float tolerance) {
+    TerritoryData oldData;
+    TerritoryData newData;
+    if (!LoadOrReport(oldPath, oldData) || !LoadOrReport(newPath, newData)) {
+        return EXIT_ERROR;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    TerritoryDiffResult diff = TerritoryDiff::Compare(oldData, newData, tolerance);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    
+    for (const auto& entry : diff.entries) {
+        std::cout << TerritoryDiff::FormatEntry(entry, oldData, newData) << "\n";
+    }
+    
+    std::cout << diff.addedCount << " added, " << diff.removedCount << " removed, "
+              << diff.movedCount << " moved, " << diff.changedCount << " changed, "
+              << diff.unchangedCount << " unchanged (" << elapsed.count() << " ms)" << std::endl;
+    
+    return diff.empty() ? EXIT_SAME : EXIT_DIFFERENT;
+}
+
+int CommandLineTool::RunMerge(const char* basePath, const char* oursPath, const char* theirsPath,
+                              const char* outputPath, float tolerance) {
+    TerritoryData base;
+    TerritoryData ours;
+    TerritoryData theirs;
+    if (!LoadOrReport(basePath, base) || !LoadOrReport(oursPath, ours) || !LoadOrReport(theirsPath, theirs)) {
+        return EXIT_ERROR;
+    }
+    
+    TerritoryMergeResult merge = TerritoryDiff::Merge(base, ours, theirs, tolerance);
+    
+    for (const auto& conflict : merge.conflicts) {
+        std::cout << "CONFLICT " << conflict.territoryName << " (" << conflict.x << ", " << conflict.z
+                  << "): " << conflict.description << "\n";
+    }
+    
+    if (!TerritoryParser::SaveToFile(outputPath, merge.merged)) {
+        std::cerr << "Failed to save file: " << outputPath << std::endl;
+        return EXIT_ERROR;
+    }
+    
+    std::cout << "Merged " << merge.appliedFromTheirs << " change(s) from " << theirsPath << ", "
+              << merge.conflicts.size() << " conflict(s) kept ours" << std::endl;
+    
+    return merge.conflicts.empty() ? EXIT_SAME : EXIT_DIFFERENT;
+}
+
+int CommandLineTool::RunValidate(const char* path, const char* mapName) {
+    TerritoryData data;
+    if (!LoadOrReport(path, data)) {
+        return EXIT_ERROR;
+    }
+    
+    // Map bounds are only checked when we know which map the file is for
+    TerritoryValidator validator;
+    if (mapName) {
+        std::vector<MapInfo> maps;
+        if (!MapRegistry::LoadFromFile(MapRegistry::DefaultPath(), maps)) {
+            maps = MapRegistry::GetBuiltInMaps();
+        }
+        auto it = std::find_if(maps.begin(), maps.end(), [mapName](const MapInfo& map) { return map.name == mapName; });
+        if (it == maps.end()) {
+            std::cerr << "Unknown map: " << mapName << std::endl;
+            return EXIT_ERROR;
+        }
+        validator.SetWorldSize(it->worldSizeX, it->worldSizeZ);
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    validator.Update(data);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    
+    for (const auto& issue : validator.GetIssues()) {
+        std::cout << TerritoryValidator::FormatIssue(issue, data) << "\n";
+    }
+    
+    std::cout << validator.GetErrorCount() << " error(s), " << validator.GetWarningCount() << " warning(s) in "
+              << data.getTotalZoneCount() << " zones (" << elapsed.count() << " ms)" << std::endl;
+    
+    return validator.GetErrorCount() == 0 ? EXIT_SAME : EXIT_DIFFERENT;
+}
+
+int CommandLineTool::RunDedup(const char* inputPath, const char* outputPath, float distance) {
+    TerritoryData data;
+    if (!LoadOrReport(inputPath, data)) {
+        return EXIT_ERROR;
+    }
+    
+    DedupSettings settings;
+    settings.distance = distance;
+    
+    auto start = std::chrono::steady_clock::now();
+    DuplicateGroups groups;
+    ZoneDeduplicator::FindDuplicates(data, settings, groups);
+    size_t removed = ZoneDeduplicator::RemoveDuplicates(data, groups);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+    
+    if (!TerritoryParser::SaveToFile(outputPath, data)) {
+        std::cerr << "Failed to save file: " << outputPath << std::endl;
+        return EXIT_ERROR;
+    }
+    
+    std::cout << groups.GetGroupCount() << " duplicate group(s), removed " << removed << " of "
+              << data.getTotalZoneCount() + removed << " zones (" << elapsed.count() << " ms)" << std::endl;
+    
+    return removed == 0 ? EXIT_SAME : EXIT_DIFFERENT;
+}
+
+int CommandLineTool::RunReplay(const char* recordingPath, const char* filePath) {
+    // Replay against the same file the session was recorded with, or an empty document
+    Application app;
+    int result = app.RunReplay(recordingPath, filePath ? filePath : "");
+    app.Shutdown();
+    return result;
+}
+
+int CommandLineTool::RunMemoryReport(const char* filePath, const char* jsonPath, const char* recordingPath) {
+    Application app;
+    int result = app.RunMemoryReport(filePath, jsonPath, recordingPath ? recordingPath : "");
+    app.Shutdown();
+    return result;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Headless entry points (no window or GL context), e.g. for scripts and CI.
+class CommandLineTool {
+public:
+    // True if argv starts with a headless command such as --diff
+    static bool IsHeadlessCommand(int argc, char* argv[]);
+    
+    // Returns the process exit code
+    static int Run(int argc, char* argv[]);
+    
+private:
+    static void PrintUsage();
+    static int RunDiff(const char* oldPath, const char* newPath, float tolerance);
+    static int RunMerge(const char* basePath, const char* oursPath, const char* theirsPath,
+                        const char* outputPath, float tolerance);
+    static int RunValidate(const char* path, const char* mapName);
+    static int RunDedup(const char* inputPath, const char* outputPath, float distance);
+    static int RunReplay(const char* recordingPath, const char* filePath);
+    static int RunMemoryReport(const char* filePath, const char* jsonPath, const char* recordingPath);
+};
@@ -0,0 +1,481 @@
+#include "EditJournal.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const char JOURNAL_MAGIC[4] = { 'T', 'E', 'J', '1' };
+static const int FLUSH_INTERVAL_MS = 250;
+static const size_t FLUSH_BATCH_BYTES = 64 * 1024;
+
+// Little-endian POD encoding; the journal is only ever read back on the machine that wrote it
+template<typename T>
+static void Put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void PutString(std::vector<uint8_t>& out, const std::string& value) {
+    Put<uint32_t>(out, static_cast<uint32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static void PutZone(std::vector<uint8_t>& out, const Zone& zone) {
+    PutString(out, NameTable::Resolve(zone.name));
+    Put<int32_t>(out, zone.smin);
+    Put<int32_t>(out, zone.smax);
+    Put<int32_t>(out, zone.dmin);
+    Put<int32_t>(out, zone.dmax);
+    Put<float>(out, zone.x);
+    Put<float>(out, zone.z);
+    Put<float>(out, zone.r);
+    Put<float>(out, zone.h);
+}
+
+struct ByteReader {
+    const uint8_t* ptr;
+    const uint8_t* end;
+    bool ok = true;
+    
+    template<typename T>
+    T Get() {
+        T value{};
+        if (static_cast<size_t>(end - ptr) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+    
+    std::string GetString() {
+        uint32_t length = Get<uint32_t>();
+        if (!ok || static_cast<size_t>(end - ptr) < length) {
+            ok = false;
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char*>(ptr), length);
+        ptr += length;
+        return value;
+    }
+    
+    Zone GetZone() {
+        Zone zone;
+        zone.name = NameTable::Intern(GetString());
+        zone.smin = Get<int32_t>();
+        zone.smax = Get<int32_t>();
+        zone.dmin = Get<int32_t>();
+        zone.dmax = Get<int32_t>();
+        zone.x = Get<float>();
+        zone.z = Get<float>();
+        zone.r = Get<float>();
+        zone.h = Get<float>();
+        return zone;
+    }
+};
+
+// FNV-1a; only needs to catch torn and partially flushed writes
+static uint32_t Checksum(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void EncodeSnapshot(const TerritoryData& data, const std::string& filePath, bool matchesFile,
+                           std::vector<uint8_t>& out) {
+    Put<uint8_t>(out, matchesFile ? 1 : 0);
+    PutString(out, filePath);
+    Put<uint32_t>(out, static_cast<uint32_t>(data.territories.size()));
+    for (const auto& territory : data.territories) {
+        PutString(out, NameTable::Resolve(territory.name));
+        Put<uint32_t>(out, territory.color);
+        Put<uint32_t>(out, static_cast<uint32_t>(territory.zones.size()));
+        for (const auto& zone : territory.zones) {
+            PutZone(out, zone);
+        }
+    }
+}
+
+EditJournal::EditJournal() {
+}
+
+EditJournal::~EditJournal() {
+    Stop(true);
+}
+
+std::string EditJournal::DefaultPath() {
+    // Lives in the working directory, like imgui.ini
+    return "TerritoryEditor.journal";
+}
+
+bool EditJournal::HasRecoverableSession(const std::string& journalPath) {
+    TerritoryData data;
+    std::string filePath;
+    return Recover(journalPath, data, filePath);
+}
+
+bool EditJournal::Recover(const std::string& journalPath, TerritoryData& data, std::string& filePath) {
+    std::ifstream in(journalPath, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    
+    bool clean = true;
+    if (!Replay(bytes, data, filePath, clean)) {
+        return false;
+    }
+    return !clean;
+}
+
+void EditJournal::EncodeRecord(RecordType type, const std::vector<uint8_t>& payload, std::vector<uint8_t>& out) {
+    Put<uint32_t>(out, static_cast<uint32_t>(payload.size()));
+    size_t checksumStart = out.size();
+    Put<uint8_t>(out, type);
+    out.insert(out.end(), payload.begin(), payload.end());
+    Put<uint32_t>(out, Checksum(out.data() + checksumStart, out.size() - checksumStart));
+}
+
+bool EditJournal::Replay(const std::vector<uint8_t>& bytes, TerritoryData& data, std::string& filePath, bool& clean) {
+    if (bytes.size() < sizeof(JOURNAL_MAGIC) || std::memcmp(bytes.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0) {
+        return false;
+    }
+    
+    ByteReader file{ bytes.data() + sizeof(JOURNAL_MAGIC), bytes.data() + bytes.size() };
+    bool haveSnapshot = false;
+    
+    while (file.ptr < file.end) {
+        uint32_t payloadSize = file.Get<uint32_t>();
+        if (!file.ok || static_cast<size_t>(file.end - file.ptr) < payloadSize + 1 + sizeof(uint32_t)) {
+            break;  // Torn tail
+        }
+        
+        const uint8_t* recordStart = file.ptr;
+        uint8_t type = recordStart[0];
+        ByteReader record{ recordStart + 1, recordStart + 1 + payloadSize };
+        file.ptr = recordStart + 1 + payloadSize;
+        uint32_t checksum = file.Get<uint32_t>();
+        if (checksum != Checksum(recordStart, payloadSize + 1)) {
+            break;
+        }
+        
+        if (type == Record_Snapshot) {
+            data.clear();
+            clean = record.Get<uint8_t>() != 0;
+            filePath = record.GetString();
+            uint32_t territoryCount = record.Get<uint32_t>();
+            for (uint32_t t = 0; t < territoryCount && record.ok; ++t) {
+                Territory territory(data.territories.get_allocator());
+                territory.name = NameTable::Intern(record.GetString());
+                territory.color = record.Get<uint32_t>();
+                uint32_t zoneCount = record.Get<uint32_t>();
+                territory.zones.reserve(std::min<size_t>(zoneCount, payloadSize));
+                for (uint32_t z = 0; z < zoneCount && record.ok; ++z) {
+                    territory.zones.push_back(record.GetZone());
+                }
+                data.territories.push_back(std::move(territory));
+            }
+            haveSnapshot = record.ok;
+            continue;
+        }
+        
+        if (!haveSnapshot) {
+            return false;
+        }
+        
+        switch (type) {
+            case Record_SetZone: {
+                ZoneRef ref;
+                ref.territory = record.Get<uint32_t>();
+                ref.zone = record.Get<uint32_t>();
+                Zone zone = record.GetZone();
+                if (Zone* target = data.getZone(ref)) {
+                    if (record.ok) *target = zone;
+                }
+                break;
+            }
+            case Record_AddTerritory: {
+                Territory territory;
+                territory.name = NameTable::Intern(record.GetString());
+                territory.color = record.Get<uint32_t>();
+                if (record.ok) data.territories.push_back(std::move(territory));
+                break;
+            }
+            case Record_AddZone: {
+                uint32_t territoryIndex = record.Get<uint32_t>();
+                Zone zone = record.GetZone();
+                if (record.ok && territoryIndex < data.territories.size()) {
+                    data.territories[territoryIndex].zones.push_back(zone);
+                }
+                break;
+            }
+            case Record_AddZones: {
+                uint32_t territoryIndex = record.Get<uint32_t>();
+                uint32_t count = record.Get<uint32_t>();
+                if (!record.ok || territoryIndex >= data.territories.size()) {
+                    break;
+                }
+                auto& zones = data.territories[territoryIndex].zones;
+                zones.reserve(zones.size() + std::min<size_t>(count, payloadSize));
+                for (uint32_t i = 0; i < count && record.ok; ++i) {
+                    Zone zone = record.GetZone();
+                    if (record.ok) zones.push_back(zone);
+                }
+                break;
+            }
+            case Record_RemoveZones: {
+                uint32_t count = record.Get<uint32_t>();
+                std::vector<std::vector<bool>> removed(data.territories.size());
+                for (uint32_t i = 0; i < count && record.ok; ++i) {
+                    uint32_t t = record.Get<uint32_t>();
+                    uint32_t z = record.Get<uint32_t>();
+                    if (record.ok && data.getZone({ t, z })) {
+                        removed[t].resize(data.territories[t].zones.size(), false);
+                        removed[t][z] = true;
+                    }
+                }
+                for (size_t t = 0; t < data.territories.size(); ++t) {
+                    if (removed[t].empty()) continue;
+                    auto& zones = data.territories[t].zones;
+                    size_t write = 0;
+                    for (size_t z = 0; z < zones.size(); ++z) {
+                        if (!removed[t][z]) zones[write++] = std::move(zones[z]);
+                    }
+                    zones.resize(write);
+                }
+                data.territories.erase(std::remove_if(data.territories.begin(), data.territories.end(),
+                    [](const Territory& territory) { return territory.zones.empty(); }), data.territories.end());
+                break;
+            }
+            case Record_Clean:
+                clean = true;
+                continue;
+            default:
+                break;
+        }
+        clean = false;
+    }
+    
+    return haveSnapshot;
+}
+
+bool EditJournal::Start(const std::string& journalPath) {
+    Stop(true);
+    
+    journalPath_ = journalPath;
+    stopRequested_ = false;
+    running_ = true;
+    writer_ = std::thread(&EditJournal::WriterThread, this);
+    return true;
+}
+
+void EditJournal::Stop(bool keepForRecovery) {
+    if (!running_) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    running_ = false;
+    
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    if (!keepForRecovery) {
+        std::error_code ec;
+        fs::remove(journalPath_, ec);
+    }
+}
+
+void EditJournal::Reset(const TerritoryData& data, const std::string& filePath, bool matchesFile) {
+    if (!running_) return;
+    
+    // Encoding is cheap next to the disk write, and doing it here avoids copying the document
+    PendingWrite write;
+    write.isSnapshot = true;
+    write.bytes.reserve(64 + data.getTotalZoneCount() * 64);
+    std::vector<uint8_t> payload;
+    EncodeSnapshot(data, filePath, matchesFile, payload);
+    EncodeRecord(Record_Snapshot, payload, write.bytes);
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Anything still queued is superseded by the snapshot
+        queue_.clear();
+        queue_.push_back(std::move(write));
+    }
+    recordsSinceSnapshot_ = 0;
+    wake_.notify_one();
+}
+
+void EditJournal::MarkClean() {
+    AppendRecord(Record_Clean, {});
+}
+
+void EditJournal::RecordZone(ZoneRef ref, const Zone& zone) {
+    std::vector<uint8_t> payload;
+    Put<uint32_t>(payload, ref.territory);
+    Put<uint32_t>(payload, ref.zone);
+    PutZone(payload, zone);
+    AppendRecord(Record_SetZone, payload);
+}
+
+void EditJournal::RecordAddTerritory(const Territory& territory) {
+    std::vector<uint8_t> payload;
+    PutString(payload, NameTable::Resolve(territory.name));
+    Put<uint32_t>(payload, territory.color);
+    AppendRecord(Record_AddTerritory, payload);
+}
+
+void EditJournal::RecordAddZone(uint32_t territoryIndex, const Zone& zone) {
+    std::vector<uint8_t> payload;
+    Put<uint32_t>(payload, territoryIndex);
+    PutZone(payload, zone);
+    AppendRecord(Record_AddZone, payload);
+}
+
+void EditJournal::RecordAddZones(uint32_t territoryIndex, const Zone* zones, size_t count) {
+    std::vector<uint8_t> payload;
+    Put<uint32_t>(payload, territoryIndex);
+    Put<uint32_t>(payload, static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        PutZone(payload, zones[i]);
+    }
+    AppendRecord(Record_AddZones, payload);
+}
+
+void EditJournal::RecordRemoveZones(const std::vector<ZoneRef>& refs) {
+    std::vector<uint8_t> payload;
+    payload.reserve(4 + refs.size() * 8);
+    Put<uint32_t>(payload, static_cast<uint32_t>(refs.size()));
+    for (const auto& ref : refs) {
+        Put<uint32_t>(payload, ref.territory);
+        Put<uint32_t>(payload, ref.zone);
+    }
+    AppendRecord(Record_RemoveZones, payload);
+}
+
+size_t EditJournal::GetQueuedBytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const PendingWrite& write : queue_) {
+        bytes += write.bytes.capacity();
+    }
+    return bytes;
+}
+
+void EditJournal::AppendRecord(RecordType type, const std::vector<uint8_t>& payload) {
+    if (!running_) return;
+    
+    bool flushNow = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty() || queue_.back().isSnapshot) {
+            queue_.emplace_back();
+        }
+        std::vector<uint8_t>& bytes = queue_.back().bytes;
+        EncodeRecord(type, payload, bytes);
+        flushNow = bytes.size() >= FLUSH_BATCH_BYTES;
+    }
+    recordsSinceSnapshot_++;
+    
+    if (flushNow) {
+        wake_.notify_one();
+    }
+}
+
+void EditJournal::WriterThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    
+    while (true) {
+        // Batch writes: wake on a timer, on a large batch, a snapshot or shutdown
+        wake_.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        
+        std::vector<PendingWrite> batch;
+        batch.swap(queue_);
+        bool stopping = stopRequested_;
+        lock.unlock();
+        
+        bool appended = false;
+        for (const PendingWrite& write : batch) {
+            if (write.isSnapshot) {
+                WriteSnapshotFile(write.bytes);
+            } else if (file_ && !write.bytes.empty()) {
+                fwrite(write.bytes.data(), 1, write.bytes.size(), file_);
+                appended = true;
+            }
+        }
+        if (appended) {
+            SyncFile();
+        }
+        
+        lock.lock();
+        if (stopping && queue_.empty()) {
+            break;
+        }
+    }
+}
+
+bool EditJournal::WriteSnapshotFile(const std::vector<uint8_t>& bytes) {
+    // Write the compacted journal beside the old one and swap it in, so a crash
+    // mid-compaction still leaves a usable journal
+    std::string tempPath = journalPath_ + ".tmp";
+    FILE* temp = fopen(tempPath.c_str(), "wb");
+    if (!temp) {
+        std::cerr << "Failed to write journal: " << tempPath << std::endl;
+        return false;
+    }
+    fwrite(JOURNAL_MAGIC, 1, sizeof(JOURNAL_MAGIC), temp);
+    fwrite(bytes.data(), 1, bytes.size(), temp);
+    fflush(temp);
+#ifdef _WIN32
+    _commit(_fileno(temp));
+#else
+    fsync(fileno(temp));
+#endif
+    fclose(temp);
+    
+    if (file_) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    
+    std::error_code ec;
+    fs::rename(tempPath, journalPath_, ec);
+    if (ec) {
+        std::cerr << "Failed to replace journal: " << ec.message() << std::endl;
+        return false;
+    }
+    
+    file_ = fopen(journalPath_.c_str(), "ab");
+    return file_ != nullptr;
+}
+
+void EditJournal::SyncFile() {
+    fflush(file_);
+#ifdef _WIN32
+    _commit(_fileno(file_));
+#else
+    fsync(fileno(file_));
+#endif
+}
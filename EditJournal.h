@@ -0,0 +1,94 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+// Append-only binary log of edit operations for autosave and crash recovery.
+//
+// The journal starts with a snapshot of the document; every edit after that is
+// appended as a small record. Records are written and fsynced in batches on a
+// background thread. Reset() compacts the journal by replacing it with a fresh
+// snapshot, which bounds replay time. Each record carries a checksum, so a torn
+// write at the end of the file is simply dropped on recovery.
+class EditJournal {
+public:
+    EditJournal();
+    ~EditJournal();
+    
+    static std::string DefaultPath();
+    
+    // True if the journal holds edits that were never saved to the territory file
+    static bool HasRecoverableSession(const std::string& journalPath);
+    static bool Recover(const std::string& journalPath, TerritoryData& data, std::string& filePath);
+    
+    bool Start(const std::string& journalPath);
+    // Flushes outstanding records; the file is deleted unless it is needed for recovery
+    void Stop(bool keepForRecovery);
+    bool IsRunning() const { return running_; }
+    
+    // Start over from a snapshot of the document (load, compaction, wholesale replacement)
+    void Reset(const TerritoryData& data, const std::string& filePath, bool matchesFile);
+    // The document was saved; nothing before this point needs recovering
+    void MarkClean();
+    
+    void RecordZone(ZoneRef ref, const Zone& zone);
+    void RecordAddTerritory(const Territory& territory);
+    void RecordAddZone(uint32_t territoryIndex, const Zone& zone);
+    // One record for a bulk insert (paste) into one territory
+    void RecordAddZones(uint32_t territoryIndex, const Zone* zones, size_t count);
+    // Removes the zones, then drops territories left empty (matches DeleteSelectedZones)
+    void RecordRemoveZones(const std::vector<ZoneRef>& refs);
+    
+    // Too many records since the last snapshot; caller should Reset()
+    bool NeedsCompaction() const { return recordsSinceSnapshot_ >= COMPACTION_THRESHOLD; }
+    
+    // Encoded bytes waiting for the writer thread
+    size_t GetQueuedBytes();
+    
+private:
+    enum RecordType : uint8_t {
+        Record_Snapshot = 1,
+        Record_SetZone = 2,
+        Record_AddTerritory = 3,
+        Record_AddZone = 4,
+        Record_RemoveZones = 5,
+        Record_Clean = 6,
+        Record_AddZones = 7,
+    };
+    
+    // A unit of work for the writer thread: either a snapshot that replaces the
+    // journal file, or a batch of encoded records to append
+    struct PendingWrite {
+        bool isSnapshot = false;
+        std::vector<uint8_t> bytes;
+    };
+    
+    static const size_t COMPACTION_THRESHOLD = 4096;
+    
+    void AppendRecord(RecordType type, const std::vector<uint8_t>& payload);
+    void WriterThread();
+    bool WriteSnapshotFile(const std::vector<uint8_t>& bytes);
+    void SyncFile();
+    
+    static void EncodeRecord(RecordType type, const std::vector<uint8_t>& payload, std::vector<uint8_t>& out);
+    static bool Replay(const std::vector<uint8_t>& bytes, TerritoryData& data, std::string& filePath, bool& clean);
+    
+    std::string journalPath_;
+    FILE* file_ = nullptr;
+    
+    std::thread writer_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<PendingWrite> queue_;
+    std::atomic<bool> running_{false};
+    bool stopRequested_ = false;
+    
+    size_t recordsSinceSnapshot_ = 0;
+};
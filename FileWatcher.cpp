@@ -0,0 +1,156 @@
+#include "FileWatcher.h"
+#include <filesystem>
+#include <chrono>
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <climits>
+#endif
+
+namespace fs = std::filesystem;
+
+// Writers (scripts, git checkouts) often touch a file several times in a row,
+// so wait for a short quiet period before reporting a change.
+static const int DEBOUNCE_MS = 200;
+static const int POLL_INTERVAL_MS = 250;
+
+FileWatcher::FileWatcher() {
+}
+
+FileWatcher::~FileWatcher() {
+    Stop();
+}
+
+bool FileWatcher::Watch(const std::string& filepath) {
+    Stop();
+    
+    filepath_ = filepath;
+    {
+        std::lock_guard<std::mutex> lock(signatureMutex_);
+        knownSignature_ = ReadSignature(filepath_);
+    }
+    changed_ = false;
+    running_ = true;
+    thread_ = std::thread(&FileWatcher::WatchThread, this);
+    return true;
+}
+
+void FileWatcher::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool FileWatcher::ConsumeChange() {
+    return changed_.exchange(false);
+}
+
+void FileWatcher::AcknowledgeCurrentState() {
+    std::lock_guard<std::mutex> lock(signatureMutex_);
+    knownSignature_ = ReadSignature(filepath_);
+    changed_ = false;
+}
+
+FileWatcher::FileSignature FileWatcher::ReadSignature(const std::string& filepath) {
+    FileSignature signature;
+    std::error_code ec;
+    auto modified = fs::last_write_time(filepath, ec);
+    if (ec) {
+        return signature;
+    }
+    auto size = fs::file_size(filepath, ec);
+    if (ec) {
+        return signature;
+    }
+    
+    signature.exists = true;
+    signature.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    signature.size = static_cast<uint64_t>(size);
+    return signature;
+}
+
+void FileWatcher::CheckForChange() {
+    FileSignature current = ReadSignature(filepath_);
+    
+    // A missing file is usually the middle of a delete+recreate; wait for it to come back
+    if (!current.exists) {
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(signatureMutex_);
+    if (current != knownSignature_) {
+        knownSignature_ = current;
+        changed_ = true;
+    }
+}
+
+#ifndef _WIN32
+
+void FileWatcher::WatchThread() {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "inotify_init1 failed, file watching disabled" << std::endl;
+        return;
+    }
+    
+    fs::path path(filepath_);
+    std::string directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    std::string filename = path.filename().string();
+    
+    int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+    if (wd < 0) {
+        std::cerr << "Failed to watch directory: " << directory << std::endl;
+        close(fd);
+        return;
+    }
+    
+    alignas(inotify_event) char buffer[4096];
+    bool pending = false;
+    auto lastEventTime = std::chrono::steady_clock::now();
+    
+    while (running_) {
+        pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, pending ? DEBOUNCE_MS : POLL_INTERVAL_MS);
+        
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char* ptr = buffer; ptr < buffer + length;) {
+                    const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+                    if (event->len > 0 && filename == event->name) {
+                        pending = true;
+                        lastEventTime = std::chrono::steady_clock::now();
+                    }
+                    ptr += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+        
+        if (pending) {
+            auto quiet = std::chrono::steady_clock::now() - lastEventTime;
+            if (quiet >= std::chrono::milliseconds(DEBOUNCE_MS)) {
+                pending = false;
+                CheckForChange();
+            }
+        }
+    }
+    
+    inotify_rm_watch(fd, wd);
+    close(fd);
+}
+
+#else
+
+void FileWatcher::WatchThread() {
+    // No inotify on Windows; comparing size and mtime on a timer is cheap enough for one file
+    while (running_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        CheckForChange();
+    }
+}
+
+#endif
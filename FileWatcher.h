@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+// Watches a single file for external modification on a background thread.
+// Uses inotify on Linux (watching the parent directory so rename-over saves
+// from editors and git are caught) and mtime polling elsewhere.
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+    
+    bool Watch(const std::string& filepath);
+    void Stop();
+    bool IsWatching() const { return running_; }
+    const std::string& GetPath() const { return filepath_; }
+    
+    // Returns true once per detected external change
+    bool ConsumeChange();
+    
+    // Record the file's current state as known (call after our own saves)
+    void AcknowledgeCurrentState();
+    
+private:
+    struct FileSignature {
+        int64_t modifiedTime = 0;
+        uint64_t size = 0;
+        bool exists = false;
+        
+        bool operator==(const FileSignature& other) const {
+            return modifiedTime == other.modifiedTime && size == other.size && exists == other.exists;
+        }
+        bool operator!=(const FileSignature& other) const { return !(*this == other); }
+    };
+    
+    static FileSignature ReadSignature(const std::string& filepath);
+    void CheckForChange();
+    void WatchThread();
+    
+    std::string filepath_;
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> changed_{false};
+    
+    std::mutex signatureMutex_;
+    FileSignature knownSignature_;
+};
@@ -0,0 +1,264 @@
+#include "InputRecording.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iterator>
+
+static const char RECORDING_MAGIC[4] = { 'T', 'E', 'I', 'R' };
+static const uint32_t RECORDING_VERSION = 1;
+
+// Event types as stored in the file; independent of ImGui's own enum values
+enum RecordedEventType : uint8_t {
+    Event_MousePos = 1,
+    Event_MouseWheel = 2,
+    Event_MouseButton = 3,
+    Event_Key = 4,
+    Event_Text = 5,
+    Event_Focus = 6,
+};
+
+template<typename T>
+static void Put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template<typename T>
+static bool Get(const std::vector<uint8_t>& in, size_t& pos, T& value) {
+    if (pos + sizeof(T) > in.size()) return false;
+    std::memcpy(&value, in.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+bool InputRecorder::Start(const std::string& path) {
+    Stop();
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        return false;
+    }
+    file_.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    file_.write(reinterpret_cast<const char*>(&RECORDING_VERSION), sizeof(RECORDING_VERSION));
+    frameCount_ = 0;
+    return true;
+}
+
+void InputRecorder::Stop() {
+    if (file_.is_open()) {
+        file_.close();
+    }
+}
+
+void InputRecorder::CaptureFrame() {
+    if (!file_.is_open()) {
+        return;
+    }
+    
+    ImGuiIO& io = ImGui::GetIO();
+    const ImVector<ImGuiInputEvent>& queue = ImGui::GetCurrentContext()->InputEventsQueue;
+    
+    buffer_.clear();
+    Put<float>(buffer_, io.DeltaTime);
+    Put<float>(buffer_, io.DisplaySize.x);
+    Put<float>(buffer_, io.DisplaySize.y);
+    size_t countPos = buffer_.size();
+    Put<uint32_t>(buffer_, 0);
+    
+    uint32_t count = 0;
+    for (int i = 0; i < queue.Size; ++i) {
+        const ImGuiInputEvent& event = queue.Data[i];
+        switch (event.Type) {
+            case ImGuiInputEventType_MousePos:
+                Put<uint8_t>(buffer_, Event_MousePos);
+                Put<float>(buffer_, event.MousePos.PosX);
+                Put<float>(buffer_, event.MousePos.PosY);
+                break;
+            case ImGuiInputEventType_MouseWheel:
+                Put<uint8_t>(buffer_, Event_MouseWheel);
+                Put<float>(buffer_, event.MouseWheel.WheelX);
+                Put<float>(buffer_, event.MouseWheel.WheelY);
+                break;
+            case ImGuiInputEventType_MouseButton:
+                Put<uint8_t>(buffer_, Event_MouseButton);
+                Put<int32_t>(buffer_, event.MouseButton.Button);
+                Put<uint8_t>(buffer_, event.MouseButton.Down ? 1 : 0);
+                break;
+            case ImGuiInputEventType_Key:
+                Put<uint8_t>(buffer_, Event_Key);
+                Put<int32_t>(buffer_, static_cast<int32_t>(event.Key.Key));
+                Put<uint8_t>(buffer_, event.Key.Down ? 1 : 0);
+                Put<float>(buffer_, event.Key.AnalogValue);
+                break;
+            case ImGuiInputEventType_Text:
+                Put<uint8_t>(buffer_, Event_Text);
+                Put<uint32_t>(buffer_, event.Text.Char);
+                break;
+            case ImGuiInputEventType_Focus:
+                Put<uint8_t>(buffer_, Event_Focus);
+                Put<uint8_t>(buffer_, event.AppFocused.Focused ? 1 : 0);
+                break;
+            default:
+                continue;  // Viewport hover changes only matter with platform windows
+        }
+        ++count;
+    }
+    std::memcpy(buffer_.data() + countPos, &count, sizeof(count));
+    
+    file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    frameCount_++;
+}
+
+bool InputReplay::Load(const std::string& path, std::string& error) {
+    events_.clear();
+    frames_.clear();
+    
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    
+    size_t pos = 0;
+    uint32_t version = 0;
+    if (bytes.size() < sizeof(RECORDING_MAGIC) || std::memcmp(bytes.data(), RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0) {
+        error = "not an input recording";
+        return false;
+    }
+    pos = sizeof(RECORDING_MAGIC);
+    if (!Get(bytes, pos, version) || version != RECORDING_VERSION) {
+        error = "unsupported recording version";
+        return false;
+    }
+    
+    while (pos < bytes.size()) {
+        Frame frame;
+        if (!Get(bytes, pos, frame.deltaTime) || !Get(bytes, pos, frame.displayW) ||
+            !Get(bytes, pos, frame.displayH) || !Get(bytes, pos, frame.eventCount)) {
+            break;  // Truncated last frame, e.g. the editor was killed while recording
+        }
+        frame.firstEvent = static_cast<uint32_t>(events_.size());
+        
+        bool complete = true;
+        for (uint32_t i = 0; i < frame.eventCount && complete; ++i) {
+            Event event;
+            uint8_t flag = 0;
+            complete = Get(bytes, pos, event.type);
+            if (!complete) break;
+            switch (event.type) {
+                case Event_MousePos:
+                case Event_MouseWheel:
+                    complete = Get(bytes, pos, event.x) && Get(bytes, pos, event.y);
+                    break;
+                case Event_MouseButton:
+                    complete = Get(bytes, pos, event.code) && Get(bytes, pos, flag);
+                    break;
+                case Event_Key:
+                    complete = Get(bytes, pos, event.code) && Get(bytes, pos, flag) && Get(bytes, pos, event.x);
+                    break;
+                case Event_Text:
+                    complete = Get(bytes, pos, event.character);
+                    break;
+                case Event_Focus:
+                    complete = Get(bytes, pos, flag);
+                    break;
+                default:
+                    error = "corrupt recording (unknown event type)";
+                    return false;
+            }
+            event.down = flag != 0;
+            events_.push_back(event);
+        }
+        if (!complete) {
+            events_.resize(frame.firstEvent);
+            break;
+        }
+        frames_.push_back(frame);
+    }
+    return true;
+}
+
+void InputReplay::ApplyFrame(size_t frame) const {
+    const Frame& f = frames_[frame];
+    ImGuiIO& io = ImGui::GetIO();
+    io.DeltaTime = f.deltaTime > 0.0f ? f.deltaTime : 1.0f / 60.0f;
+    io.DisplaySize = ImVec2(f.displayW, f.displayH);
+    
+    for (uint32_t i = f.firstEvent; i < f.firstEvent + f.eventCount; ++i) {
+        const Event& event = events_[i];
+        switch (event.type) {
+            case Event_MousePos:
+                io.AddMousePosEvent(event.x, event.y);
+                break;
+            case Event_MouseWheel:
+                io.AddMouseWheelEvent(event.x, event.y);
+                break;
+            case Event_MouseButton:
+                io.AddMouseButtonEvent(event.code, event.down);
+                break;
+            case Event_Key:
+                io.AddKeyAnalogEvent(static_cast<ImGuiKey>(event.code), event.down, event.x);
+                break;
+            case Event_Text:
+                io.AddInputCharacter(event.character);
+                break;
+            case Event_Focus:
+                io.AddFocusEvent(event.down);
+                break;
+        }
+    }
+}
+
+const char* FrameStats::GetPhaseName(FramePhase phase) {
+    switch (phase) {
+        case FramePhase::NewFrame: return "NewFrame";
+        case FramePhase::Layout: return "Layout";
+        case FramePhase::Poll: return "Poll";
+        case FramePhase::Input: return "Input";
+        case FramePhase::UI: return "UI";
+        case FramePhase::Render: return "Render";
+        default: return "?";
+    }
+}
+
+void FrameStats::Print(std::ostream& out) const {
+    if (frames_.empty()) {
+        out << "No frames" << std::endl;
+        return;
+    }
+    
+    const int phaseCount = static_cast<int>(FramePhase::Count);
+    std::vector<double> samples(frames_.size());
+    auto printRow = [&out, &samples](const char* name) {
+        double sum = 0.0;
+        for (double sample : samples) sum += sample;
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&samples](double p) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+        };
+        out << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << sum / samples.size() << std::setw(10) << percentile(0.5)
+            << std::setw(10) << percentile(0.95) << std::setw(10) << percentile(0.99)
+            << std::setw(10) << samples.back() << "\n";
+    };
+    
+    out << frames_.size() << " frames, times in ms\n";
+    out << std::left << std::setw(10) << "phase" << std::right << std::setw(10) << "mean" << std::setw(10) << "p50"
+        << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    for (int phase = 0; phase < phaseCount; ++phase) {
+        for (size_t i = 0; i < frames_.size(); ++i) {
+            samples[i] = frames_[i].ms[phase];
+        }
+        printRow(GetPhaseName(static_cast<FramePhase>(phase)));
+    }
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        samples[i] = 0.0;
+        for (int phase = 0; phase < phaseCount; ++phase) {
+            samples[i] += frames_[i].ms[phase];
+        }
+    }
+    printRow("Total");
+    out.flush();
+}
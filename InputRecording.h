@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <ostream>
+#include <cstdint>
+
+// Sessions are recorded as the ImGui input events queued for each frame, plus the
+// frame's delta time and display size. Replaying feeds the same events with the same
+// timing into a fresh context, so a replay runs the exact same frames as the session
+// (as long as it starts from the same file).
+//
+// File layout (little endian): "TEIR", uint32 version, then per frame: float deltaTime,
+// float displayW, float displayH, uint32 eventCount, and the events (uint8 type + payload).
+// Key codes are ImGuiKey values, so recordings are tied to the ImGui version that made them.
+class InputRecorder {
+public:
+    ~InputRecorder() { Stop(); }
+    
+    bool Start(const std::string& path);
+    void Stop();
+    bool IsRecording() const { return file_.is_open(); }
+    size_t GetFrameCount() const { return frameCount_; }
+    
+    // Appends the events ImGui has queued for the coming frame; call right before ImGui::NewFrame
+    void CaptureFrame();
+
+private:
+    std::ofstream file_;
+    std::vector<uint8_t> buffer_;
+    size_t frameCount_ = 0;
+};
+
+class InputReplay {
+public:
+    bool Load(const std::string& path, std::string& error);
+    size_t GetFrameCount() const { return frames_.size(); }
+    
+    // Queues the frame's events and sets its delta time and display size; call before ImGui::NewFrame
+    void ApplyFrame(size_t frame) const;
+
+private:
+    struct Event {
+        uint8_t type = 0;
+        int32_t code = 0;      // Mouse button or key
+        bool down = false;     // Button/key state, or app focus
+        float x = 0.0f;        // Mouse position, wheel delta, or key analog value in x
+        float y = 0.0f;
+        uint32_t character = 0;
+    };
+    
+    struct Frame {
+        float deltaTime = 0.0f;
+        float displayW = 0.0f;
+        float displayH = 0.0f;
+        uint32_t firstEvent = 0;
+        uint32_t eventCount = 0;
+    };
+    
+    std::vector<Event> events_;
+    std::vector<Frame> frames_;
+};
+
+// Phases of one Application frame, timed separately so a replay shows where the time goes
+enum class FramePhase {
+    NewFrame,  // ImGui::NewFrame: input processing, window and docking bookkeeping
+    Layout,    // Dockspace and main menu bar
+    Poll,      // Background loads, reloads, validation, simulation, journal
+    Input,     // Keyboard shortcuts
+    UI,        // Panels and the map view
+    Render,    // ImGui::Render: finishing the draw lists
+    Count
+};
+
+struct FrameTimes {
+    double ms[static_cast<int>(FramePhase::Count)] = {};
+};
+
+// Per-phase frame time distribution over a run
+class FrameStats {
+public:
+    void Add(const FrameTimes& times) { frames_.push_back(times); }
+    size_t GetFrameCount() const { return frames_.size(); }
+    
+    // One line per phase plus the total: mean, median, 95th/99th percentile and max in ms
+    void Print(std::ostream& out) const;
+    
+    static const char* GetPhaseName(FramePhase phase);
+
+private:
+    std::vector<FrameTimes> frames_;
+};
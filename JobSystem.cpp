@@ -0,0 +1,342 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// ParallelFor makes at most this many ranges per thread, enough to even out uneven ranges by stealing
+static const size_t RANGES_PER_THREAD = 4;
+
+namespace {
+
+struct Task {
+    const char* name = "";
+    std::function<void()> fn;
+};
+
+class Scheduler {
+public:
+    explicit Scheduler(size_t workerCount);
+    ~Scheduler();
+    
+    size_t GetWorkerCount() const { return threads_.size(); }
+    void Push(Task task);
+    void Record(const char* name, double ms);
+    std::vector<JobSystem::TaskStats> GetStats();
+    void ResetStats();
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    
+    bool TryPop(size_t self, Task& task);
+    void Run(Task& task);
+    void WorkerLoop(size_t index);
+    
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    
+    std::mutex injectedMutex_;
+    std::deque<Task> injected_;  // Submitted from outside the pool
+    
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{0};
+    bool stopping_ = false;
+    
+    std::mutex statsMutex_;
+    std::vector<JobSystem::TaskStats> stats_;
+};
+
+// Set on pool threads, so tasks queue follow-up work on their own deque
+thread_local Scheduler* currentScheduler = nullptr;
+thread_local size_t currentWorker = 0;
+
+Scheduler::Scheduler(size_t workerCount) {
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        threads_.emplace_back(&Scheduler::WorkerLoop, this, i);
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+    
+    // Work queued by a task after the others had already left; ParallelFor helpers find nothing left to do
+    currentScheduler = this;
+    Task task;
+    while (TryPop(0, task)) {
+        Run(task);
+    }
+    currentScheduler = nullptr;
+}
+
+void Scheduler::Push(Task task) {
+    if (currentScheduler == this) {
+        Worker& worker = *workers_[currentWorker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(injectedMutex_);
+        injected_.push_back(std::move(task));
+    }
+    queued_++;
+    // Taking the lock orders the increment before a sleeper's check, so the wakeup can't be lost
+    { std::lock_guard<std::mutex> lock(sleepMutex_); }
+    wake_.notify_one();
+}
+
+bool Scheduler::TryPop(size_t self, Task& task) {
+    // Own work newest first, then the shared queue, then steal the oldest work of the others
+    if (!workers_.empty()) {
+        Worker& own = *workers_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_--;
+            return true;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(injectedMutex_);
+        if (!injected_.empty()) {
+            task = std::move(injected_.front());
+            injected_.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(self + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::Run(Task& task) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        task.fn();
+    } catch (const std::exception& e) {
+        std::cerr << "Task \"" << task.name << "\" failed: " << e.what() << std::endl;
+    }
+    Record(task.name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    task.fn = nullptr;  // Release captures before the next wait
+}
+
+void Scheduler::WorkerLoop(size_t index) {
+    currentScheduler = this;
+    currentWorker = index;
+    
+    Task task;
+    while (true) {
+        if (TryPop(index, task)) {
+            Run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this]() { return queued_ > 0 || stopping_; });
+        if (stopping_ && queued_ == 0) {
+            break;
+        }
+    }
+}
+
+void Scheduler::Record(const char* name, double ms) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    auto it = std::find_if(stats_.begin(), stats_.end(),
+                           [name](const JobSystem::TaskStats& stats) { return std::strcmp(stats.name, name) == 0; });
+    if (it == stats_.end()) {
+        stats_.push_back(JobSystem::TaskStats());
+        it = stats_.end() - 1;
+        it->name = name;
+    }
+    it->runs++;
+    it->totalMs += ms;
+    it->maxMs = std::max(it->maxMs, ms);
+}
+
+std::vector<JobSystem::TaskStats> Scheduler::GetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    return stats_;
+}
+
+void Scheduler::ResetStats() {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.clear();
+}
+
+// Declared before the scheduler, so they outlive a pool still running at exit
+std::mutex mainThreadMutex;
+std::vector<std::function<void()>> mainThreadTasks;
+
+std::mutex schedulerMutex;
+std::unique_ptr<Scheduler> scheduler;
+
+size_t DefaultWorkerCount() {
+    size_t threads = std::thread::hardware_concurrency();
+    return threads > 1 ? threads - 1 : 1;
+}
+
+Scheduler& GetScheduler() {
+    // Pool threads use their own scheduler, which stays valid while Stop() drains it
+    if (currentScheduler) {
+        return *currentScheduler;
+    }
+    std::lock_guard<std::mutex> lock(schedulerMutex);
+    if (!scheduler) {
+        scheduler = std::make_unique<Scheduler>(DefaultWorkerCount());
+    }
+    return *scheduler;
+}
+
+}
+
+void JobSystem::Start(size_t workerCount) {
+    std::lock_guard<std::mutex> lock(schedulerMutex);
+    if (!scheduler) {
+        scheduler = std::make_unique<Scheduler>(workerCount > 0 ? workerCount : DefaultWorkerCount());
+    }
+}
+
+void JobSystem::Stop() {
+    std::unique_ptr<Scheduler> stopping;
+    {
+        std::lock_guard<std::mutex> lock(schedulerMutex);
+        stopping = std::move(scheduler);
+    }
+    stopping.reset();
+    RunMainThreadTasks();
+}
+
+size_t JobSystem::GetWorkerCount() {
+    return GetScheduler().GetWorkerCount();
+}
+
+void JobSystem::Submit(const char* name, std::function<void()> fn) {
+    Task task;
+    task.name = name;
+    task.fn = std::move(fn);
+    GetScheduler().Push(std::move(task));
+}
+
+size_t JobSystem::GetRangeCount(size_t count, size_t minRange) {
+    size_t ranges = (count + std::max<size_t>(minRange, 1) - 1) / std::max<size_t>(minRange, 1);
+    return std::min(ranges, (GetWorkerCount() + 1) * RANGES_PER_THREAD);
+}
+
+void JobSystem::ParallelForRanges(const char* name, size_t count, size_t minRange,
+                                  const std::function<void(size_t, size_t, size_t)>& body) {
+    size_t ranges = GetRangeCount(count, minRange);
+    if (ranges == 0) {
+        return;
+    }
+    
+    // Helpers and the caller claim ranges from a shared counter. A helper that starts after
+    // the last range was claimed returns at once, so nothing touches body after we return.
+    struct Loop {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto loop = std::make_shared<Loop>();
+    auto runRanges = [loop, ranges, count, &body]() {
+        for (size_t range = loop->next++; range < ranges; range = loop->next++) {
+            try {
+                body(range, range * count / ranges, (range + 1) * count / ranges);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->error = std::current_exception();
+            }
+            if (++loop->done == ranges) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                loop->finished.notify_all();
+            }
+        }
+    };
+    
+    Scheduler& pool = GetScheduler();
+    size_t helpers = std::min(ranges - 1, pool.GetWorkerCount());
+    for (size_t i = 0; i < helpers; ++i) {
+        Task task;
+        task.name = name;
+        task.fn = runRanges;
+        pool.Push(std::move(task));
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    runRanges();
+    pool.Record(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop, ranges]() { return loop->done == ranges; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+void JobSystem::RunOnMainThread(std::function<void()> fn) {
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadTasks.push_back(std::move(fn));
+}
+
+void JobSystem::RunMainThreadTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+        tasks.swap(mainThreadTasks);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+std::vector<JobSystem::TaskStats> JobSystem::GetTaskStats() {
+    std::vector<TaskStats> stats = GetScheduler().GetStats();
+    std::sort(stats.begin(), stats.end(), [](const TaskStats& a, const TaskStats& b) { return a.totalMs > b.totalMs; });
+    return stats;
+}
+
+void JobSystem::ResetTaskStats() {
+    GetScheduler().ResetStats();
+}
+
+void JobSystem::PrintTaskStats(std::ostream& out) {
+    std::vector<TaskStats> stats = GetTaskStats();
+    out << GetWorkerCount() << " worker(s), task times in ms\n";
+    out << std::left << std::setw(28) << "task" << std::right << std::setw(8) << "runs" << std::setw(12) << "total"
+        << std::setw(10) << "mean" << std::setw(10) << "max" << "\n";
+    for (const TaskStats& task : stats) {
+        out << std::left << std::setw(28) << task.name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(8) << task.runs << std::setw(12) << task.totalMs << std::setw(10) << task.totalMs / task.runs
+            << std::setw(10) << task.maxMs << "\n";
+    }
+    out.flush();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <cstddef>
+
+// Process-wide work-stealing task scheduler. Every worker owns a deque: it pushes
+// and pops its own tasks at the back and, once that runs dry, steals from the
+// front of the others', so thieves take the oldest (usually largest) work first.
+// Tasks submitted from outside the pool go to a shared queue.
+//
+// Computation (parsing, decoding, validation, analysis) runs here; threads that
+// mostly block (file watching, journal fsync) keep their own. The editor starts
+// the pool in Application::Initialize; headless tools start it on first use.
+class JobSystem {
+public:
+    // workerCount 0 = one per hardware thread, minus one for the main thread
+    static void Start(size_t workerCount = 0);
+    // Runs every queued task to completion, joins the workers, then runs pending main-thread tasks
+    static void Stop();
+    static size_t GetWorkerCount();
+    
+    // Queues fn on a worker. name should be a string literal; it keys the timing stats.
+    static void Submit(const char* name, std::function<void()> fn);
+    
+    // Queues fn on a worker; the future yields its result, or rethrows what it threw
+    template<typename F>
+    static auto Async(const char* name, F fn) -> std::future<decltype(fn())> {
+        using Result = decltype(fn());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        std::future<Result> future = task->get_future();
+        Submit(name, [task]() { (*task)(); });
+        return future;
+    }
+    
+    // Number of ranges ParallelFor splits count items into, for sizing per-range outputs
+    static size_t GetRangeCount(size_t count, size_t minRange);
+    
+    // Calls body(range, begin, end) for each of GetRangeCount(count, minRange) contiguous ranges
+    // of [0, count) and returns once all of them ran. The calling thread takes ranges too but
+    // never unrelated tasks, so this is safe on the main thread and inside other tasks.
+    template<typename Body>
+    static void ParallelFor(const char* name, size_t count, size_t minRange, Body&& body) {
+        ParallelForRanges(name, count, minRange, std::function<void(size_t, size_t, size_t)>(std::ref(body)));
+    }
+    
+    // Queues fn for the main thread, e.g. a GL upload once a decode finished
+    static void RunOnMainThread(std::function<void()> fn);
+    // Call once per frame on the main thread
+    static void RunMainThreadTasks();
+    
+    // Wall time per task name, summed over every run since start or the last reset
+    struct TaskStats {
+        const char* name = "";
+        size_t runs = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+    // Most total time first
+    static std::vector<TaskStats> GetTaskStats();
+    static void ResetTaskStats();
+    // One line per task name: runs, total, mean and max in ms
+    static void PrintTaskStats(std::ostream& out);
+
+private:
+    static void ParallelForRanges(const char* name, size_t count, size_t minRange,
+                                  const std::function<void(size_t, size_t, size_t)>& body);
+};
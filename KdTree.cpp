@@ -0,0 +1,64 @@
+#include "KdTree.h"
+
+void KdTree::Build(std::vector<Point> points) {
+    points_ = std::move(points);
+    BuildRecursive(0, points_.size(), 0);
+}
+
+void KdTree::BuildRecursive(size_t begin, size_t end, int depth) {
+    if (end - begin <= 1) return;
+    
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(points_.begin() + begin, points_.begin() + mid, points_.begin() + end,
+        [depth](const Point& a, const Point& b) {
+            return AxisValue(a, depth) < AxisValue(b, depth);
+        });
+    
+    BuildRecursive(begin, mid, depth + 1);
+    BuildRecursive(mid + 1, end, depth + 1);
+}
+
+static bool CloserHit(const KdTree::Hit& a, const KdTree::Hit& b) {
+    return a.distSq < b.distSq;
+}
+
+void KdTree::KNearest(float x, float z, size_t k, float maxDist, std::vector<Hit>& out) const {
+    out.clear();
+    if (k == 0) return;
+    
+    out.reserve(k);
+    KNearestRecursive(0, points_.size(), 0, x, z, k, maxDist * maxDist, out);
+    std::sort_heap(out.begin(), out.end(), CloserHit);
+}
+
+void KdTree::KNearestRecursive(size_t begin, size_t end, int depth, float x, float z,
+                               size_t k, float maxDistSq, std::vector<Hit>& heap) const {
+    if (begin >= end) return;
+    
+    size_t mid = begin + (end - begin) / 2;
+    const Point& p = points_[mid];
+    float dx = p.x - x;
+    float dz = p.z - z;
+    float distSq = dx * dx + dz * dz;
+    
+    // heap is a max-heap on distance holding the best k so far
+    if (distSq <= maxDistSq) {
+        if (heap.size() < k) {
+            heap.push_back({ p.id, distSq });
+            std::push_heap(heap.begin(), heap.end(), CloserHit);
+        } else if (distSq < heap.front().distSq) {
+            std::pop_heap(heap.begin(), heap.end(), CloserHit);
+            heap.back() = { p.id, distSq };
+            std::push_heap(heap.begin(), heap.end(), CloserHit);
+        }
+    }
+    
+    float diff = ((depth & 1) ? z : x) - AxisValue(p, depth);
+    bool goLeft = diff < 0.0f;
+    KNearestRecursive(goLeft ? begin : mid + 1, goLeft ? mid : end, depth + 1, x, z, k, maxDistSq, heap);
+    
+    float bound = heap.size() < k ? maxDistSq : heap.front().distSq;
+    if (diff * diff <= bound) {
+        KNearestRecursive(goLeft ? mid + 1 : begin, goLeft ? end : mid, depth + 1, x, z, k, maxDistSq, heap);
+    }
+}
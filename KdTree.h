@@ -0,0 +1,147 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// Static 2D k-d tree over world X/Z points. The tree is stored implicitly:
+// points are reordered so the median of every [begin, end) range is its
+// splitting node, alternating X and Z by depth. Rebuild after edits.
+class KdTree {
+public:
+    struct Point {
+        float x = 0.0f;
+        float z = 0.0f;
+        uint32_t id = 0;  // Caller-defined payload, usually an index into a zone list
+    };
+    
+    struct Hit {
+        uint32_t id = 0;
+        float distSq = 0.0f;
+    };
+    
+    void Build(std::vector<Point> points);
+    void Clear() { points_.clear(); }
+    size_t Size() const { return points_.size(); }
+    bool Empty() const { return points_.empty(); }
+    const std::vector<Point>& GetPoints() const { return points_; }
+    size_t GetMemoryUsage() const { return points_.capacity() * sizeof(Point); }
+    
+    // Nearest point within maxDist for which accept(id) returns true; returns false if none
+    template<typename Accept>
+    bool Nearest(float x, float z, float maxDist, Accept accept, Hit& out) const {
+        out.distSq = maxDist * maxDist;
+        bool found = false;
+        NearestRecursive(0, points_.size(), 0, x, z, accept, out, found);
+        return found;
+    }
+    
+    bool Nearest(float x, float z, float maxDist, Hit& out) const {
+        return Nearest(x, z, maxDist, [](uint32_t) { return true; }, out);
+    }
+    
+    // Up to k nearest points within maxDist, sorted by distance
+    void KNearest(float x, float z, size_t k, float maxDist, std::vector<Hit>& out) const;
+    
+    // Calls visit(id, distSq) for every point within radius
+    template<typename Visit>
+    void QueryRadius(float x, float z, float radius, Visit visit) const {
+        RadiusRecursive(0, points_.size(), 0, x, z, radius * radius, visit);
+    }
+    
+    // Calls visit(id) for every point inside the rectangle (inclusive)
+    template<typename Visit>
+    void QueryRect(float minX, float minZ, float maxX, float maxZ, Visit visit) const {
+        QueryRectPoints(minX, minZ, maxX, maxZ, [&](const Point& p) { visit(p.id); });
+    }
+    
+    // Same as QueryRect, but visit(const Point&) also gets the coordinates for further filtering
+    template<typename Visit>
+    void QueryRectPoints(float minX, float minZ, float maxX, float maxZ, Visit visit) const {
+        RectRecursive(0, points_.size(), 0, minX, minZ, maxX, maxZ, visit);
+    }
+    
+private:
+    std::vector<Point> points_;
+    
+    void BuildRecursive(size_t begin, size_t end, int depth);
+    void KNearestRecursive(size_t begin, size_t end, int depth, float x, float z,
+                           size_t k, float maxDistSq, std::vector<Hit>& heap) const;
+    
+    static float AxisValue(const Point& p, int depth) { return (depth & 1) ? p.z : p.x; }
+    
+    template<typename Accept>
+    void NearestRecursive(size_t begin, size_t end, int depth, float x, float z,
+                          Accept& accept, Hit& best, bool& found) const {
+        if (begin >= end) return;
+        
+        size_t mid = begin + (end - begin) / 2;
+        const Point& p = points_[mid];
+        float dx = p.x - x;
+        float dz = p.z - z;
+        float distSq = dx * dx + dz * dz;
+        if (distSq <= best.distSq && accept(p.id)) {
+            best.id = p.id;
+            best.distSq = distSq;
+            found = true;
+        }
+        
+        float diff = ((depth & 1) ? z : x) - AxisValue(p, depth);
+        size_t nearBegin = diff < 0.0f ? begin : mid + 1;
+        size_t nearEnd = diff < 0.0f ? mid : end;
+        size_t farBegin = diff < 0.0f ? mid + 1 : begin;
+        size_t farEnd = diff < 0.0f ? end : mid;
+        
+        NearestRecursive(nearBegin, nearEnd, depth + 1, x, z, accept, best, found);
+        if (diff * diff <= best.distSq) {
+            NearestRecursive(farBegin, farEnd, depth + 1, x, z, accept, best, found);
+        }
+    }
+    
+    template<typename Visit>
+    void RadiusRecursive(size_t begin, size_t end, int depth, float x, float z,
+                         float radiusSq, Visit& visit) const {
+        if (begin >= end) return;
+        
+        size_t mid = begin + (end - begin) / 2;
+        const Point& p = points_[mid];
+        float dx = p.x - x;
+        float dz = p.z - z;
+        float distSq = dx * dx + dz * dz;
+        if (distSq <= radiusSq) {
+            visit(p.id, distSq);
+        }
+        
+        float diff = ((depth & 1) ? z : x) - AxisValue(p, depth);
+        if (diff <= 0.0f || diff * diff <= radiusSq) {
+            RadiusRecursive(begin, mid, depth + 1, x, z, radiusSq, visit);
+        }
+        if (diff >= 0.0f || diff * diff <= radiusSq) {
+            RadiusRecursive(mid + 1, end, depth + 1, x, z, radiusSq, visit);
+        }
+    }
+    
+    template<typename Visit>
+    void RectRecursive(size_t begin, size_t end, int depth, float minX, float minZ,
+                       float maxX, float maxZ, Visit& visit) const {
+        if (begin >= end) return;
+        
+        size_t mid = begin + (end - begin) / 2;
+        const Point& p = points_[mid];
+        if (p.x >= minX && p.x <= maxX && p.z >= minZ && p.z <= maxZ) {
+            visit(p);
+        }
+        
+        float value = AxisValue(p, depth);
+        float lo = (depth & 1) ? minZ : minX;
+        float hi = (depth & 1) ? maxZ : maxX;
+        if (lo <= value) {
+            RectRecursive(begin, mid, depth + 1, minX, minZ, maxX, maxZ, visit);
+        }
+        if (hi >= value) {
+            RectRecursive(mid + 1, end, depth + 1, minX, minZ, maxX, maxZ, visit);
+        }
+    }
+};
@@ -0,0 +1,89 @@
+#include "MapRegistry.h"
+#include "tinyxml2.h"
+#include <iostream>
+
+using namespace tinyxml2;
+
+bool MapRegistry::LoadFromFile(const std::string& filepath, std::vector<MapInfo>& maps) {
+    maps.clear();
+    
+    XMLDocument doc;
+    if (doc.LoadFile(filepath.c_str()) != XML_SUCCESS) {
+        return false;
+    }
+    
+    XMLElement* root = doc.FirstChildElement("maps");
+    if (!root) {
+        std::cerr << "Map definitions have no <maps> root: " << filepath << "\n";
+        return false;
+    }
+    
+    for (XMLElement* mapElem = root->FirstChildElement("map"); mapElem; mapElem = mapElem->NextSiblingElement("map")) {
+        MapInfo info;
+        
+        const char* name = mapElem->Attribute("name");
+        if (!name) {
+            std::cerr << "Skipping map without a name (line " << mapElem->GetLineNum() << ")\n";
+            continue;
+        }
+        info.name = name;
+        
+        mapElem->QueryFloatAttribute("worldSizeX", &info.worldSizeX);
+        mapElem->QueryFloatAttribute("worldSizeZ", &info.worldSizeZ);
+        if (info.worldSizeX <= 0.0f || info.worldSizeZ <= 0.0f) {
+            std::cerr << "Skipping map " << info.name << ": invalid world size\n";
+            continue;
+        }
+        
+        if (XMLElement* imageElem = mapElem->FirstChildElement("image")) {
+            const char* path = imageElem->Attribute("path");
+            if (path) {
+                info.imagePath = path;
+            }
+        }
+        
+        if (XMLElement* tilesElem = mapElem->FirstChildElement("tiles")) {
+            const char* pattern = tilesElem->Attribute("pattern");
+            int columns = tilesElem->IntAttribute("columns");
+            int rows = tilesElem->IntAttribute("rows");
+            if (pattern && columns > 0 && rows > 0) {
+                info.tilePattern = pattern;
+                info.tileColumns = columns;
+                info.tileRows = rows;
+            } else {
+                std::cerr << "Ignoring invalid tiles for map " << info.name << "\n";
+            }
+        }
+        
+        if (XMLElement* heightmapElem = mapElem->FirstChildElement("heightmap")) {
+            const char* path = heightmapElem->Attribute("path");
+            if (path) {
+                info.heightmapPath = path;
+            }
+        }
+        
+        maps.push_back(info);
+    }
+    
+    return !maps.empty();
+}
+
+std::vector<MapInfo> MapRegistry::GetBuiltInMaps() {
+    std::vector<MapInfo> maps;
+    
+    MapInfo chernarus;
+    chernarus.name = "Chernarus";
+    chernarus.worldSizeX = 15360.0f;
+    chernarus.worldSizeZ = 15360.0f;
+    chernarus.imagePath = "Maps/chernarusplus_Map.png";
+    maps.push_back(chernarus);
+    
+    MapInfo livonia;
+    livonia.name = "Livonia";
+    livonia.worldSizeX = 12800.0f;
+    livonia.worldSizeZ = 12800.0f;
+    livonia.imagePath = "Maps/enoch_Map.png";
+    maps.push_back(livonia);
+    
+    return maps;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "MapView.h"
+#include <string>
+#include <vector>
+
+// Loads the list of selectable maps from a definition file so new maps or
+// imagery can be added without rebuilding.
+class MapRegistry {
+public:
+    static const char* DefaultPath() { return "Maps/maps.xml"; }
+    
+    static bool LoadFromFile(const std::string& filepath, std::vector<MapInfo>& maps);
+    // Built-in definitions used when the definition file is missing or invalid
+    static std::vector<MapInfo> GetBuiltInMaps();
+};
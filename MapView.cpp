@@ -1,39 +1,23 @@
 #include "MapView.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include "imgui.h"
+#include "imgui_internal.h"
 #include "imgui_impl_opengl3.h"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <limits>
 
-// OpenGL function declarations (avoiding Windows GL/gl.h conflicts)
-// These functions are provided by opengl32.dll on Windows
-#ifdef _WIN32
-extern "C" {
-    typedef unsigned int GLuint;
-    typedef unsigned int GLenum;
-    typedef int GLint;
-    typedef int GLsizei;
-    
-    void __stdcall glGenTextures(GLsizei n, GLuint* textures);
-    void __stdcall glDeleteTextures(GLsizei n, const GLuint* textures);
-    void __stdcall glBindTexture(GLenum target, GLuint texture);
-    void __stdcall glTexParameteri(GLenum target, GLenum pname, GLint param);
-    void __stdcall glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
-    
-    #define GL_TEXTURE_2D         0x0DE1
-    #define GL_TEXTURE_MIN_FILTER 0x2801
-    #define GL_TEXTURE_MAG_FILTER 0x2800
-    #define GL_TEXTURE_WRAP_S     0x2802
-    #define GL_TEXTURE_WRAP_T     0x2803
-    #define GL_LINEAR             0x2601
-    #define GL_CLAMP_TO_EDGE      0x812F
-    #define GL_RGBA               0x1908
-    #define GL_UNSIGNED_BYTE      0x1401
-}
-#else
-#include <GL/gl.h>
-#endif
+std::string MapInfo::GetTilePath(int column, int row) const {
+    std::string path = tilePattern;
+    size_t pos;
+    while ((pos = path.find("{x}")) != std::string::npos) {
+        path.replace(pos, 3, std::to_string(column));
+    }
+    while ((pos = path.find("{y}")) != std::string::npos) {
+        path.replace(pos, 3, std::to_string(row));
+    }
+    return path;
+}
 
 MapView::MapView() {
     currentMap_.name = "Chernarus";
@@ -42,48 +26,22 @@ MapView::MapView() {
 }
 
 MapView::~MapView() {
-    if (currentMap_.textureId != 0) {
-        glDeleteTextures(1, &currentMap_.textureId);
-    }
 }
 
 bool MapView::LoadMapImage(const std::string& imagePath) {
-    int width, height, channels;
-    unsigned char* data = stbi_load(imagePath.c_str(), &width, &height, &channels, 4);
-    
-    if (!data) {
+    // Decodes synchronously, but only on the first use of this path
+    const TextureCache::Texture* texture = textureCache_.Load(imagePath);
+    if (!texture) {
         return false;
     }
     
-    // Delete old texture if exists
-    if (currentMap_.textureId != 0) {
-        glDeleteTextures(1, &currentMap_.textureId);
-    }
-    
-    // Create new texture
-    glGenTextures(1, &currentMap_.textureId);
-    glBindTexture(GL_TEXTURE_2D, currentMap_.textureId);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    
-    stbi_image_free(data);
-    
-    currentMap_.imageWidth = width;
-    currentMap_.imageHeight = height;
     currentMap_.imagePath = imagePath;
-    
     return true;
 }
 
 void MapView::SetMapInfo(const MapInfo& info) {
+    // Imagery is looked up in the texture cache when rendering, so switching maps never re-decodes
     currentMap_ = info;
-    // Load the map image if path is provided
-    if (!info.imagePath.empty()) {
-        LoadMapImage(info.imagePath);
-    }
 }
 
 void MapView::Update(float deltaTime) {
@@ -92,72 +50,119 @@ void MapView::Update(float deltaTime) {
 
 void MapView::Render(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize) {
     ImDrawList* drawList = ImGui::GetWindowDrawList();
+    lastCanvasSize_ = canvasSize;
+    
+    // Upload any imagery that finished decoding since last frame
+    textureCache_.Update();
+    
+    // Draw placeholder background; map imagery (or the tiles that have loaded so far) covers it
+    drawList->AddRectFilled(canvasPos, ImVec2(canvasPos.x + canvasSize.x, canvasPos.y + canvasSize.y), IM_COL32(40, 40, 40, 255));
     
     // Draw map background - transform with zoom/pan like zones
-    if (currentMap_.textureId != 0) {
-        // Transform the four corners of the world map to screen coordinates
-        // World coordinates: (0,0) = bottom-left, (worldSizeX, worldSizeZ) = top-right
-        // Image UV: (0,0) = top-left, (1,1) = bottom-right
-        ImVec2 bottomLeft = WorldToScreen(0.0f, 0.0f, canvasPos, canvasSize);
-        ImVec2 bottomRight = WorldToScreen(currentMap_.worldSizeX, 0.0f, canvasPos, canvasSize);
-        ImVec2 topLeft = WorldToScreen(0.0f, currentMap_.worldSizeZ, canvasPos, canvasSize);
-        ImVec2 topRight = WorldToScreen(currentMap_.worldSizeX, currentMap_.worldSizeZ, canvasPos, canvasSize);
-        
-        // Use AddImageQuad to draw the transformed quad
-        // UV coordinates: (0,0) top-left, (1,0) top-right, (1,1) bottom-right, (0,1) bottom-left
-        ImVec2 uv0(0.0f, 0.0f); // top-left
-        ImVec2 uv1(1.0f, 0.0f); // top-right
-        ImVec2 uv2(1.0f, 1.0f); // bottom-right
-        ImVec2 uv3(0.0f, 1.0f); // bottom-left
-        
-        drawList->AddImageQuad(
-            reinterpret_cast<void*>(static_cast<intptr_t>(currentMap_.textureId)),
-            topLeft, topRight, bottomRight, bottomLeft,
-            uv0, uv1, uv2, uv3
-        );
-    } else {
-        // Draw placeholder background
-        drawList->AddRectFilled(canvasPos, ImVec2(canvasPos.x + canvasSize.x, canvasPos.y + canvasSize.y), IM_COL32(40, 40, 40, 255));
+    if (currentMap_.tileColumns > 0 && currentMap_.tileRows > 0 && !currentMap_.tilePattern.empty()) {
+        float tileWorldX = currentMap_.worldSizeX / currentMap_.tileColumns;
+        float tileWorldZ = currentMap_.worldSizeZ / currentMap_.tileRows;
+        for (int row = 0; row < currentMap_.tileRows; ++row) {
+            for (int column = 0; column < currentMap_.tileColumns; ++column) {
+                // Row 0 is the top (north) edge of the map, like image rows
+                float minX = column * tileWorldX;
+                float maxZ = currentMap_.worldSizeZ - row * tileWorldZ;
+                DrawMapImage(drawList, currentMap_.GetTilePath(column, row),
+                             minX, maxZ - tileWorldZ, minX + tileWorldX, maxZ, canvasPos, canvasSize);
+            }
+        }
+    } else if (!currentMap_.imagePath.empty()) {
+        DrawMapImage(drawList, currentMap_.imagePath, 0.0f, 0.0f, currentMap_.worldSizeX, currentMap_.worldSizeZ, canvasPos, canvasSize);
     }
     
-    // Draw zones
-    for (const auto& territory : data.territories) {
-        if (!territory.visible) continue;
-        
-        for (const auto& zone : territory.zones) {
-            if (!zone.visible) continue;
-            DrawZone(zone, territory, canvasPos, canvasSize);
-        }
+    if (!cellOverlay_.empty()) {
+        DrawCellOverlay(drawList, canvasPos, canvasSize);
+    }
+    
+    // Draw zones from the cached mesh, rebuilding it only when zones or the view changed
+    ViewKey view = MakeViewKey(canvasPos, canvasSize);
+    if (zoneCacheDirty_ || !(view == cachedView_)) {
+        UpdateZonePositions(data, canvasPos, canvasSize);
+        RebuildZoneCache(data, canvasPos, canvasSize, drawList->_Data->TexUvWhitePixel);
+        RebuildLabels(data, canvasPos, canvasSize);
+        cachedView_ = view;
+        zoneCacheDirty_ = false;
+    }
+    AppendZoneCache(drawList);
+    DrawLabels(drawList);
+    
+    if (!previewZones_.empty()) {
+        DrawPreviewZones(drawList, canvasPos, canvasSize);
+    }
+    if (!hoveredZones_.empty()) {
+        DrawHoveredZones(drawList, data, canvasPos, canvasSize);
+    }
+    if (snapGuide_.kind != SnapKind::None) {
+        DrawSnapGuide(drawList, data, canvasPos, canvasSize);
+    }
+    
+    if (!highlightedRegion_.empty()) {
+        DrawRegion(drawList, highlightedRegion_, true, canvasPos, canvasSize);
     }
     
     // Draw marquee selection
     if (isMarqueeSelecting_) {
         DrawMarquee(canvasPos, canvasSize);
     }
+    if (isRegionSelecting_) {
+        DrawRegion(drawList, regionPoints_, false, canvasPos, canvasSize);
+    }
 }
 
-ImVec2 MapView::WorldToScreen(float worldX, float worldZ, const ImVec2& canvasPos, const ImVec2& canvasSize) const {
-    float scaleX = canvasSize.x / currentMap_.worldSizeX;
-    float scaleZ = canvasSize.y / currentMap_.worldSizeZ;
+void MapView::DrawMapImage(ImDrawList* drawList, const std::string& imagePath, float minX, float minZ,
+                           float maxX, float maxZ, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    // Skip images entirely outside the canvas so off-screen tiles are never requested
+    ImVec2 topLeft = WorldToScreen(minX, maxZ, canvasPos, canvasSize);
+    ImVec2 bottomRight = WorldToScreen(maxX, minZ, canvasPos, canvasSize);
+    if (bottomRight.x < canvasPos.x || topLeft.x > canvasPos.x + canvasSize.x ||
+        bottomRight.y < canvasPos.y || topLeft.y > canvasPos.y + canvasSize.y) {
+        return;
+    }
+    
+    const TextureCache::Texture* texture = textureCache_.Request(imagePath);
+    if (!texture) {
+        return;
+    }
+    
+    // Transform the four corners of the image to screen coordinates
+    // World coordinates: (0,0) = bottom-left, (worldSizeX, worldSizeZ) = top-right
+    // Image UV: (0,0) = top-left, (1,1) = bottom-right
+    ImVec2 topRight = WorldToScreen(maxX, maxZ, canvasPos, canvasSize);
+    ImVec2 bottomLeft = WorldToScreen(minX, minZ, canvasPos, canvasSize);
     
-    // X increases left to right (correct)
-    float screenX = (worldX * scaleX * zoom_) + panX_ + canvasPos.x;
-    // Z increases bottom to top in world, but Y increases top to bottom on screen (need to flip)
-    float screenY = ((currentMap_.worldSizeZ - worldZ) * scaleZ * zoom_) + panY_ + canvasPos.y;
+    // Use AddImageQuad to draw the transformed quad
+    // UV coordinates: (0,0) top-left, (1,0) top-right, (1,1) bottom-right, (0,1) bottom-left
+    ImVec2 uv0(0.0f, 0.0f); // top-left
+    ImVec2 uv1(1.0f, 0.0f); // top-right
+    ImVec2 uv2(1.0f, 1.0f); // bottom-right
+    ImVec2 uv3(0.0f, 1.0f); // bottom-left
     
-    return ImVec2(screenX, screenY);
+    drawList->AddImageQuad(
+        reinterpret_cast<void*>(static_cast<intptr_t>(texture->id)),
+        topLeft, topRight, bottomRight, bottomLeft,
+        uv0, uv1, uv2, uv3
+    );
+}
+
+ViewTransform MapView::GetViewTransform(const ImVec2& canvasPos, const ImVec2& canvasSize) const {
+    return ViewTransform::Create(currentMap_.worldSizeX, currentMap_.worldSizeZ, zoom_, panX_, panY_,
+                                 canvasPos.x, canvasPos.y, canvasSize.x, canvasSize.y);
+}
+
+ImVec2 MapView::WorldToScreen(float worldX, float worldZ, const ImVec2& canvasPos, const ImVec2& canvasSize) const {
+    // X increases left to right; world Z increases bottom to top, screen Y top to bottom (flipped by the transform)
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    return ImVec2(view.ToScreenX(worldX), view.ToScreenY(worldZ));
 }
 
 ImVec2 MapView::ScreenToWorld(float screenX, float screenY, const ImVec2& canvasPos, const ImVec2& canvasSize) const {
-    float scaleX = currentMap_.worldSizeX / canvasSize.x;
-    float scaleZ = currentMap_.worldSizeZ / canvasSize.y;
-    
-    // X increases left to right (correct)
-    float worldX = ((screenX - canvasPos.x - panX_) / zoom_) * scaleX;
-    // Z increases bottom to top in world, but Y increases top to bottom on screen (need to flip)
-    float worldZ = currentMap_.worldSizeZ - (((screenY - canvasPos.y - panY_) / zoom_) * scaleZ);
-    
-    return ImVec2(worldX, worldZ);
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    return ImVec2(view.ToWorldX(screenX), view.ToWorldZ(screenY));
 }
 
 void MapView::Pan(float deltaX, float deltaY) {
@@ -175,9 +180,6 @@ void MapView::Zoom(float delta, float mouseX, float mouseY, const ImVec2& canvas
     zoom_ = std::max(0.1f, std::min(10.0f, zoom_ + delta * 0.1f));
     
     // Adjust pan to keep mouse position fixed
-    float scaleX = canvasSize.x / currentMap_.worldSizeX;
-    float scaleZ = canvasSize.y / currentMap_.worldSizeZ;
-    
     ImVec2 newScreenPos = WorldToScreen(mouseWorld.x, mouseWorld.y, canvasPos, canvasSize);
     panX_ += (mouseX + canvasPos.x) - newScreenPos.x;
     panY_ += (mouseY + canvasPos.y) - newScreenPos.y;
@@ -189,6 +191,14 @@ void MapView::ResetView() {
     zoom_ = 1.0f;
 }
 
+void MapView::CenterOn(float worldX, float worldZ) {
+    // Solve WorldToScreen for the pan that puts the point in the middle of the last rendered canvas
+    float scaleX = lastCanvasSize_.x / currentMap_.worldSizeX;
+    float scaleZ = lastCanvasSize_.y / currentMap_.worldSizeZ;
+    panX_ = lastCanvasSize_.x * 0.5f - worldX * scaleX * zoom_;
+    panY_ = lastCanvasSize_.y * 0.5f - (currentMap_.worldSizeZ - worldZ) * scaleZ * zoom_;
+}
+
 void MapView::StartMarqueeSelection(float x, float y) {
     isMarqueeSelecting_ = true;
     marqueeStart_ = ImVec2(x, y);
@@ -205,51 +215,598 @@ void MapView::EndMarqueeSelection() {
     isMarqueeSelecting_ = false;
 }
 
+void MapView::StartRegionSelection() {
+    isRegionSelecting_ = true;
+    regionPoints_.clear();
+}
+
+void MapView::AddRegionPoint(float worldX, float worldZ) {
+    if (isRegionSelecting_) {
+        regionPoints_.push_back({ worldX, worldZ });
+    }
+}
+
+void MapView::EndRegionSelection() {
+    isRegionSelecting_ = false;
+    regionPoints_.clear();
+}
+
 std::vector<Zone*> MapView::GetZonesInRect(TerritoryData& data, float x1, float y1, float x2, float y2, const ImVec2& canvasPos, const ImVec2& canvasSize) {
     std::vector<Zone*> result;
     
-    float minX = std::min(x1, x2);
-    float maxX = std::max(x1, x2);
-    float minY = std::min(y1, y2);
-    float maxY = std::max(y1, y2);
-    
-    for (auto& territory : data.territories) {
-        for (auto& zone : territory.zones) {
-            ImVec2 screenPos = WorldToScreen(zone.x, zone.z, canvasPos, canvasSize);
-            if (screenPos.x >= minX && screenPos.x <= maxX &&
-                screenPos.y >= minY && screenPos.y <= maxY) {
-                result.push_back(&zone);
-            }
+    // The screen rectangle maps to an axis-aligned world rectangle (Z flipped)
+    ImVec2 worldA = ScreenToWorld(x1, y1, canvasPos, canvasSize);
+    ImVec2 worldB = ScreenToWorld(x2, y2, canvasPos, canvasSize);
+    
+    zoneIndex_.Update(data);
+    zoneIndex_.QueryRect(std::min(worldA.x, worldB.x), std::min(worldA.y, worldB.y),
+                         std::max(worldA.x, worldB.x), std::max(worldA.y, worldB.y),
+                         [&](ZoneRef ref) {
+        if (Zone* zone = data.getZone(ref)) {
+            result.push_back(zone);
         }
+    });
+    
+    return result;
+}
+
+std::vector<Zone*> MapView::GetZonesInPolygon(TerritoryData& data, const std::vector<RegionPoint>& polygon) {
+    std::vector<Zone*> result;
+    
+    PolygonTester tester(polygon);
+    if (!tester.IsValid()) {
+        return result;
     }
     
+    // Bounding box through the index first, exact test only on those candidates
+    zoneIndex_.Update(data);
+    zoneIndex_.QueryRect(tester.minX, tester.minZ, tester.maxX, tester.maxZ,
+                         [&](float x, float z) { return tester.Contains(x, z); },
+                         [&](ZoneRef ref) {
+        if (Zone* zone = data.getZone(ref)) {
+            result.push_back(zone);
+        }
+    });
+    
     return result;
 }
 
-void MapView::DrawZone(const Zone& zone, const Territory& territory, const ImVec2& canvasPos, const ImVec2& canvasSize) {
-    ImDrawList* drawList = ImGui::GetWindowDrawList();
+Zone* MapView::GetZoneAt(TerritoryData& data, float screenX, float screenY, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    std::vector<ZoneHit> hits;
+    GetZonesNear(data, screenX, screenY, 0.0f, 0, canvasPos, canvasSize, hits);
+    return !hits.empty() && hits.front().covers ? data.getZone(hits.front().ref) : nullptr;
+}
+
+void MapView::GetZonesNear(const TerritoryData& data, float screenX, float screenY, float tolerance, size_t maxNearby,
+                           const ImVec2& canvasPos, const ImVec2& canvasSize, std::vector<ZoneHit>& out) {
+    out.clear();
+    zoneIndex_.Update(data);
+    const KdTree& tree = zoneIndex_.GetTree();
+    if (tree.Empty()) {
+        return;
+    }
+    
+    // Circles are drawn with the smaller axis scale; dividing pixels by it gives a world
+    // distance that bounds the pixel distance on both axes
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float radiusScale = std::min(view.scaleX, -view.scaleZ);
+    if (radiusScale <= 0.0f) {
+        return;
+    }
+    float worldX = view.ToWorldX(screenX);
+    float worldZ = view.ToWorldZ(screenY);
+    
+    auto isVisible = [&data](ZoneRef ref) {
+        return data.territories[ref.territory].visible && data.territories[ref.territory].zones[ref.zone].visible;
+    };
+    auto screenDistance = [&](const KdTree::Point& p) {
+        float dx = view.ToScreenX(p.x) - screenX;
+        float dy = view.ToScreenY(p.z) - screenY;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+    
+    // Covering zones: only centers within the largest radius can contain the point
+    float maxRadius = zoneIndex_.GetMaxRadius();
+    tree.QueryRectPoints(worldX - maxRadius, worldZ - maxRadius, worldX + maxRadius, worldZ + maxRadius,
+                         [&](const KdTree::Point& p) {
+        float distance = screenDistance(p);
+        if (distance < zoneIndex_.GetRadius(p.id) * radiusScale) {
+            ZoneRef ref = zoneIndex_.GetRef(p.id);
+            if (isVisible(ref)) {
+                out.push_back({ ref, distance, true });
+            }
+        }
+    });
+    std::sort(out.begin(), out.end(), [](const ZoneHit& a, const ZoneHit& b) { return a.distance < b.distance; });
+    
+    // Nearby centers: the k nearest within the tolerance, skipping zones already listed
+    if (maxNearby > 0 && tolerance > 0.0f) {
+        std::vector<KdTree::Hit> nearest;
+        tree.KNearest(worldX, worldZ, maxNearby + out.size(), tolerance / radiusScale, nearest);
+        size_t coverCount = out.size();
+        for (const auto& hit : nearest) {
+            if (out.size() - coverCount >= maxNearby) break;
+            ZoneRef ref = zoneIndex_.GetRef(hit.id);
+            bool listed = std::any_of(out.begin(), out.begin() + coverCount, [&ref](const ZoneHit& h) {
+                return h.ref.territory == ref.territory && h.ref.zone == ref.zone;
+            });
+            if (listed || !isVisible(ref)) continue;
+            const Zone& zone = data.territories[ref.territory].zones[ref.zone];
+            float dx = view.ToScreenX(zone.x) - screenX;
+            float dy = view.ToScreenY(zone.z) - screenY;
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (distance <= tolerance) {
+                out.push_back({ ref, distance, false });
+            }
+        }
+    }
+}
+
+MapView::ViewKey MapView::MakeViewKey(const ImVec2& canvasPos, const ImVec2& canvasSize) const {
+    ViewKey view;
+    view.panX = panX_;
+    view.panY = panY_;
+    view.zoom = zoom_;
+    view.canvasX = canvasPos.x;
+    view.canvasY = canvasPos.y;
+    view.canvasW = canvasSize.x;
+    view.canvasH = canvasSize.y;
+    view.worldSizeX = currentMap_.worldSizeX;
+    view.worldSizeZ = currentMap_.worldSizeZ;
+    return view;
+}
+
+void MapView::UpdateZonePositions(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    // The count check guards against edits that haven't invalidated the cache yet
+    size_t zoneCount = data.getTotalZoneCount();
+    bool gather = zonePositionsDirty_ || zoneWorldX_.size() != zoneCount;
+    ViewKey view = MakeViewKey(canvasPos, canvasSize);
+    if (!gather && view == positionsView_) {
+        return;
+    }
+    
+    if (gather) {
+        zoneWorldX_.resize(zoneCount);
+        zoneWorldZ_.resize(zoneCount);
+        size_t flatIndex = 0;
+        for (const auto& territory : data.territories) {
+            for (const auto& zone : territory.zones) {
+                zoneWorldX_[flatIndex] = zone.x;
+                zoneWorldZ_[flatIndex] = zone.z;
+                ++flatIndex;
+            }
+        }
+        zonePositionsDirty_ = false;
+    }
+    
+    zoneScreenX_.resize(zoneCount);
+    zoneScreenY_.resize(zoneCount);
+    GetViewTransform(canvasPos, canvasSize).Apply(zoneWorldX_.data(), zoneWorldZ_.data(), zoneCount,
+                                                  zoneScreenX_.data(), zoneScreenY_.data());
+    positionsView_ = view;
+}
+
+// Unit circle tables per segment count, shared by all zone tessellation
+static const int MAX_CIRCLE_SEGMENTS = 32;
+static const int DOT_SEGMENTS = 10;
+
+static const ImVec2* UnitCircle(int segments) {
+    static std::vector<ImVec2> tables[MAX_CIRCLE_SEGMENTS + 1];
+    std::vector<ImVec2>& table = tables[segments];
+    if (table.empty()) {
+        table.resize(segments);
+        for (int i = 0; i < segments; ++i) {
+            float angle = (static_cast<float>(i) / segments) * 2.0f * 3.14159265f;
+            table[i] = ImVec2(std::cos(angle), std::sin(angle));
+        }
+    }
+    return table.data();
+}
+
+void MapView::RebuildZoneCache(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize, const ImVec2& whiteUv) {
+    zoneVertices_.clear();
+    zoneIndices_.clear();
+    zoneChunks_.clear();
+    zoneChunks_.push_back(ZoneMeshChunk());
+    
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float radiusScale = std::min(view.scaleX, -view.scaleZ);
+    
+    // Screen positions were batch transformed by UpdateZonePositions, in the same order
+    size_t flatIndex = 0;
+    for (const auto& territory : data.territories) {
+        size_t territoryStart = flatIndex;
+        flatIndex += territory.zones.size();
+        if (!territory.visible) continue;
+        
+        // Convert territory color from ARGB to RGBA once per territory
+        uint32_t color = territory.color;
+        uint8_t r = (color >> 16) & 0xFF;
+        uint8_t g = (color >> 8) & 0xFF;
+        uint8_t b = color & 0xFF;
+        // Make zones much more visible - use full alpha for selected, high alpha for unselected
+        uint32_t selectedColor = IM_COL32(r, g, b, 255);
+        uint32_t normalColor = IM_COL32(r, g, b, 200);
+        
+        for (size_t i = 0; i < territory.zones.size(); ++i) {
+            const Zone& zone = territory.zones[i];
+            if (!zone.visible) continue;
+            
+            ImVec2 center(zoneScreenX_[territoryStart + i], zoneScreenY_[territoryStart + i]);
+            float radius = zone.r * radiusScale;
+            
+            // Cull zones entirely outside the canvas
+            float extent = std::max(radius, 3.0f) + 4.0f;
+            if (center.x + extent < canvasPos.x || center.x - extent > canvasPos.x + canvasSize.x ||
+                center.y + extent < canvasPos.y || center.y - extent > canvasPos.y + canvasSize.y) {
+                continue;
+            }
+            
+            TessellateZone(center, radius, zone.selected ? selectedColor : normalColor, zone.selected, whiteUv);
+        }
+    }
     
-    ImVec2 center = WorldToScreen(zone.x, zone.z, canvasPos, canvasSize);
+    ZoneMeshChunk& last = zoneChunks_.back();
+    last.vtxCount = zoneVertices_.size() - last.vtxStart;
+    last.idxCount = zoneIndices_.size() - last.idxStart;
+}
+
+static const float LABEL_CELL_SIZE = 8.0f;            // Occupancy grid cell, in pixels
+static const float LABEL_PADDING = 3.0f;              // Kept free around every label
+static const float TERRITORY_LABEL_MIN_EXTENT = 60.0f;  // Territory spread on screen before its name shows
+static const float ZONE_LABEL_MIN_RADIUS = 18.0f;     // Zone radius on screen before its name shows
+static const size_t MAX_LABELS = 1024;
+
+void MapView::RebuildLabels(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    labels_.clear();
+    if (!showLabels_) {
+        return;
+    }
     
-    // Calculate radius in screen space
-    float scaleX = canvasSize.x / currentMap_.worldSizeX;
-    float scaleZ = canvasSize.y / currentMap_.worldSizeZ;
-    float radius = zone.r * std::min(scaleX, scaleZ) * zoom_;
+    float fontSize = ImGui::GetFontSize();
+    if (fontSize != labelFontSize_) {
+        labelWidths_.clear();
+        labelFontSize_ = fontSize;
+    }
     
-    // Convert territory color from ARGB to RGBA
-    uint32_t color = territory.color;
-    uint8_t a = (color >> 24) & 0xFF;
-    uint8_t r = (color >> 16) & 0xFF;
-    uint8_t g = (color >> 8) & 0xFF;
-    uint8_t b = color & 0xFF;
-    // Make zones much more visible - use full alpha for selected, high alpha for unselected
-    uint32_t imguiColor = IM_COL32(r, g, b, zone.selected ? 255 : 200);
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float radiusScale = std::min(view.scaleX, -view.scaleZ);
+    float canvasMaxX = canvasPos.x + canvasSize.x;
+    float canvasMaxY = canvasPos.y + canvasSize.y;
+    
+    // Gather candidates from the screen positions UpdateZonePositions just computed. Zones
+    // too small to hold a label or off the canvas are culled here, so the sort and the grid
+    // only ever see what could actually be shown.
+    labelCandidates_.clear();
+    size_t flatIndex = 0;
+    for (const auto& territory : data.territories) {
+        size_t territoryStart = flatIndex;
+        flatIndex += territory.zones.size();
+        if (!territory.visible) continue;
+        
+        float minX = std::numeric_limits<float>::max();
+        float minY = std::numeric_limits<float>::max();
+        float maxX = -std::numeric_limits<float>::max();
+        float maxY = -std::numeric_limits<float>::max();
+        float sumX = 0.0f;
+        float sumY = 0.0f;
+        size_t count = 0;
+        for (size_t i = 0; i < territory.zones.size(); ++i) {
+            const Zone& zone = territory.zones[i];
+            if (!zone.visible) continue;
+            
+            float x = zoneScreenX_[territoryStart + i];
+            float y = zoneScreenY_[territoryStart + i];
+            float radius = zone.r * radiusScale;
+            minX = std::min(minX, x - radius);
+            minY = std::min(minY, y - radius);
+            maxX = std::max(maxX, x + radius);
+            maxY = std::max(maxY, y + radius);
+            sumX += x;
+            sumY += y;
+            ++count;
+            
+            if (radius >= ZONE_LABEL_MIN_RADIUS && x >= canvasPos.x && x <= canvasMaxX && y >= canvasPos.y && y <= canvasMaxY) {
+                LabelCandidate candidate;
+                candidate.rank = zone.selected ? 1 : 2;
+                candidate.size = radius;
+                candidate.center = ImVec2(x, y);
+                candidate.name = zone.name;
+                candidate.color = zone.selected ? IM_COL32(255, 255, 0, 255) : IM_COL32(220, 220, 220, 220);
+                labelCandidates_.push_back(candidate);
+            }
+        }
+        
+        float extent = std::max(maxX - minX, maxY - minY);
+        if (count == 0 || extent < TERRITORY_LABEL_MIN_EXTENT) continue;
+        if (maxX < canvasPos.x || minX > canvasMaxX || maxY < canvasPos.y || minY > canvasMaxY) continue;
+        
+        // Label the territory at the mean of its zone centers, brightened territory color
+        uint32_t color = territory.color;
+        uint8_t r = static_cast<uint8_t>(((color >> 16) & 0xFF) / 2 + 128);
+        uint8_t g = static_cast<uint8_t>(((color >> 8) & 0xFF) / 2 + 128);
+        uint8_t b = static_cast<uint8_t>((color & 0xFF) / 2 + 128);
+        LabelCandidate candidate;
+        candidate.rank = 0;
+        candidate.size = extent;
+        candidate.center = ImVec2(sumX / count, sumY / count);
+        candidate.name = territory.name;
+        candidate.color = IM_COL32(r, g, b, 255);
+        labelCandidates_.push_back(candidate);
+    }
+    
+    if (labelCandidates_.empty()) {
+        return;
+    }
+    std::sort(labelCandidates_.begin(), labelCandidates_.end(), [](const LabelCandidate& a, const LabelCandidate& b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.size > b.size;
+    });
     
-    // Draw circle outline
-    drawList->AddCircle(center, radius, imguiColor, 32, zone.selected ? 3.0f : 1.0f);
+    labelGridColumns_ = std::max(1, static_cast<int>(std::ceil(canvasSize.x / LABEL_CELL_SIZE)));
+    labelGridRows_ = std::max(1, static_cast<int>(std::ceil(canvasSize.y / LABEL_CELL_SIZE)));
+    labelGrid_.assign(static_cast<size_t>(labelGridColumns_) * labelGridRows_, 0);
     
-    // Draw center point
-    drawList->AddCircleFilled(center, 3.0f, imguiColor);
+    for (const auto& candidate : labelCandidates_) {
+        PlaceLabel(candidate, canvasPos, canvasSize);
+        if (labels_.size() >= MAX_LABELS) break;
+    }
+}
+
+float MapView::GetLabelWidth(NameId name) {
+    // Most zones share their territory's name, so measuring once per name covers the whole map
+    auto it = labelWidths_.find(name);
+    if (it != labelWidths_.end()) {
+        return it->second;
+    }
+    float width = ImGui::CalcTextSize(NameTable::CStr(name)).x;
+    labelWidths_.emplace(name, width);
+    return width;
+}
+
+bool MapView::PlaceLabel(const LabelCandidate& candidate, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    float width = GetLabelWidth(candidate.name);
+    ImVec2 min(candidate.center.x - width * 0.5f, candidate.center.y - labelFontSize_ * 0.5f);
+    
+    // Labels that would be cut off by the canvas edge are dropped rather than clipped
+    float left = min.x - LABEL_PADDING - canvasPos.x;
+    float top = min.y - LABEL_PADDING - canvasPos.y;
+    float right = min.x + width + LABEL_PADDING - canvasPos.x;
+    float bottom = min.y + labelFontSize_ + LABEL_PADDING - canvasPos.y;
+    if (left < 0.0f || top < 0.0f || right > canvasSize.x || bottom > canvasSize.y) {
+        return false;
+    }
+    
+    int column0 = static_cast<int>(left / LABEL_CELL_SIZE);
+    int row0 = static_cast<int>(top / LABEL_CELL_SIZE);
+    int column1 = std::min(static_cast<int>(right / LABEL_CELL_SIZE), labelGridColumns_ - 1);
+    int row1 = std::min(static_cast<int>(bottom / LABEL_CELL_SIZE), labelGridRows_ - 1);
+    for (int row = row0; row <= row1; ++row) {
+        const uint8_t* cells = labelGrid_.data() + static_cast<size_t>(row) * labelGridColumns_;
+        for (int column = column0; column <= column1; ++column) {
+            if (cells[column]) {
+                return false;
+            }
+        }
+    }
+    for (int row = row0; row <= row1; ++row) {
+        std::memset(labelGrid_.data() + static_cast<size_t>(row) * labelGridColumns_ + column0, 1, column1 - column0 + 1);
+    }
+    
+    MapLabel label;
+    label.pos = min;
+    label.name = candidate.name;
+    label.color = candidate.color;
+    labels_.push_back(label);
+    return true;
+}
+
+void MapView::DrawLabels(ImDrawList* drawList) const {
+    for (const auto& label : labels_) {
+        const char* text = NameTable::CStr(label.name);
+        drawList->AddText(ImVec2(label.pos.x + 1.0f, label.pos.y + 1.0f), IM_COL32(0, 0, 0, 200), text);
+        drawList->AddText(label.pos, label.color, text);
+    }
+}
+
+void MapView::TessellateZone(const ImVec2& center, float radius, uint32_t color, bool selected, const ImVec2& whiteUv) {
+    // Outline is an anti-aliased ring like ImDrawList::AddCircle: 4 vertices per point
+    // (outer fringe, outer edge, inner edge, inner fringe), fringes fade to transparent
+    bool hasOutline = radius >= 0.5f;
+    int segments = std::max(8, std::min(MAX_CIRCLE_SEGMENTS, static_cast<int>(radius * 0.5f) + 8));
+    size_t vtxNeeded = (hasOutline ? segments * 4 : 0) + DOT_SEGMENTS + 1;
+    
+    // Keep every chunk addressable with 16-bit indices
+    ZoneMeshChunk* chunk = &zoneChunks_.back();
+    if (zoneVertices_.size() - chunk->vtxStart + vtxNeeded > 0xFFFF) {
+        chunk->vtxCount = zoneVertices_.size() - chunk->vtxStart;
+        chunk->idxCount = zoneIndices_.size() - chunk->idxStart;
+        ZoneMeshChunk next;
+        next.vtxStart = zoneVertices_.size();
+        next.idxStart = zoneIndices_.size();
+        zoneChunks_.push_back(next);
+        chunk = &zoneChunks_.back();
+    }
+    
+    uint32_t transparent = color & ~IM_COL32(0, 0, 0, 255);
+    
+    if (hasOutline) {
+        const ImVec2* unit = UnitCircle(segments);
+        float halfCore = (selected ? 3.0f - 1.0f : 0.0f) * 0.5f;
+        const float radii[4] = { radius + halfCore + 1.0f, radius + halfCore, radius - halfCore, std::max(0.0f, radius - halfCore - 1.0f) };
+        const uint32_t colors[4] = { transparent, color, color, transparent };
+        
+        ImDrawIdx base = static_cast<ImDrawIdx>(zoneVertices_.size() - chunk->vtxStart);
+        for (int i = 0; i < segments; ++i) {
+            for (int ring = 0; ring < 4; ++ring) {
+                ImDrawVert vertex;
+                vertex.pos = ImVec2(center.x + unit[i].x * radii[ring], center.y + unit[i].y * radii[ring]);
+                vertex.uv = whiteUv;
+                vertex.col = colors[ring];
+                zoneVertices_.push_back(vertex);
+            }
+        }
+        for (int i = 0; i < segments; ++i) {
+            ImDrawIdx a = static_cast<ImDrawIdx>(base + i * 4);
+            ImDrawIdx b = static_cast<ImDrawIdx>(base + ((i + 1) % segments) * 4);
+            for (int ring = 0; ring < 3; ++ring) {
+                const ImDrawIdx quad[6] = {
+                    static_cast<ImDrawIdx>(a + ring), static_cast<ImDrawIdx>(b + ring), static_cast<ImDrawIdx>(b + ring + 1),
+                    static_cast<ImDrawIdx>(a + ring), static_cast<ImDrawIdx>(b + ring + 1), static_cast<ImDrawIdx>(a + ring + 1)
+                };
+                zoneIndices_.insert(zoneIndices_.end(), quad, quad + 6);
+            }
+        }
+    }
+    
+    // Center point as a small triangle fan
+    const ImVec2* unit = UnitCircle(DOT_SEGMENTS);
+    ImDrawIdx hub = static_cast<ImDrawIdx>(zoneVertices_.size() - chunk->vtxStart);
+    ImDrawVert vertex;
+    vertex.pos = center;
+    vertex.uv = whiteUv;
+    vertex.col = color;
+    zoneVertices_.push_back(vertex);
+    for (int i = 0; i < DOT_SEGMENTS; ++i) {
+        vertex.pos = ImVec2(center.x + unit[i].x * 3.0f, center.y + unit[i].y * 3.0f);
+        zoneVertices_.push_back(vertex);
+    }
+    for (int i = 0; i < DOT_SEGMENTS; ++i) {
+        zoneIndices_.push_back(hub);
+        zoneIndices_.push_back(static_cast<ImDrawIdx>(hub + 1 + i));
+        zoneIndices_.push_back(static_cast<ImDrawIdx>(hub + 1 + (i + 1) % DOT_SEGMENTS));
+    }
+}
+
+void MapView::AppendZoneCache(ImDrawList* drawList) const {
+    for (const auto& chunk : zoneChunks_) {
+        if (chunk.vtxCount == 0) continue;
+        
+        // Start each chunk at a fresh vertex offset so its chunk-relative indices can be copied as-is
+        bool freshOffset = sizeof(ImDrawIdx) == 2 && (drawList->Flags & ImDrawListFlags_AllowVtxOffset);
+        if (freshOffset) {
+            drawList->_CmdHeader.VtxOffset = drawList->VtxBuffer.Size;
+            drawList->_OnChangedVtxOffset();
+        }
+        
+        drawList->PrimReserve(static_cast<int>(chunk.idxCount), static_cast<int>(chunk.vtxCount));
+        unsigned int base = drawList->_VtxCurrentIdx;
+        
+        std::memcpy(drawList->_VtxWritePtr, zoneVertices_.data() + chunk.vtxStart, chunk.vtxCount * sizeof(ImDrawVert));
+        if (base == 0) {
+            std::memcpy(drawList->_IdxWritePtr, zoneIndices_.data() + chunk.idxStart, chunk.idxCount * sizeof(ImDrawIdx));
+        } else {
+            // No vertex offset support (or 32-bit indices): rebase indices while copying
+            for (size_t i = 0; i < chunk.idxCount; ++i) {
+                drawList->_IdxWritePtr[i] = static_cast<ImDrawIdx>(zoneIndices_[chunk.idxStart + i] + base);
+            }
+        }
+        
+        drawList->_VtxWritePtr += chunk.vtxCount;
+        drawList->_IdxWritePtr += chunk.idxCount;
+        drawList->_VtxCurrentIdx += static_cast<unsigned int>(chunk.vtxCount);
+    }
+}
+
+void MapView::DrawRegion(ImDrawList* drawList, const std::vector<RegionPoint>& points, bool closed, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    if (points.empty()) {
+        return;
+    }
+    
+    std::vector<ImVec2> screenPoints;
+    screenPoints.reserve(points.size() + 1);
+    for (const auto& point : points) {
+        screenPoints.push_back(WorldToScreen(point.x, point.z, canvasPos, canvasSize));
+    }
+    
+    ImU32 color = IM_COL32(255, 255, 0, 255);
+    if (!closed) {
+        // Rubber band from the last vertex to the cursor, and faintly back to the start
+        ImVec2 mousePos = ImGui::GetIO().MousePos;
+        drawList->AddLine(screenPoints.back(), mousePos, color, 1.0f);
+        if (screenPoints.size() >= 2) {
+            drawList->AddLine(mousePos, screenPoints.front(), IM_COL32(255, 255, 0, 80), 1.0f);
+        }
+        drawList->AddCircleFilled(screenPoints.front(), 4.0f, color);
+    }
+    drawList->AddPolyline(screenPoints.data(), static_cast<int>(screenPoints.size()), color, closed ? ImDrawFlags_Closed : 0, 2.0f);
+}
+
+void MapView::DrawHoveredZones(ImDrawList* drawList, const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float radiusScale = std::min(view.scaleX, -view.scaleZ);
+    for (const auto& hit : hoveredZones_) {
+        const Zone* zone = data.getZone(hit.ref);
+        if (!zone) continue;
+        ImVec2 center(view.ToScreenX(zone->x), view.ToScreenY(zone->z));
+        ImU32 color = hit.covers ? IM_COL32(255, 255, 255, 220) : IM_COL32(255, 255, 255, 110);
+        drawList->AddCircle(center, std::max(zone->r * radiusScale, 3.0f), color, 0, hit.covers ? 2.0f : 1.0f);
+    }
+}
+
+void MapView::DrawPreviewZones(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float radius = std::max(previewRadius_ * std::min(view.scaleX, -view.scaleZ), 2.0f);
+    float right = canvasPos.x + canvasSize.x;
+    float bottom = canvasPos.y + canvasSize.y;
+    ImU32 color = IM_COL32(120, 255, 120, 200);
+    for (const auto& center : previewZones_) {
+        float x = view.ToScreenX(center.x);
+        float y = view.ToScreenY(center.z);
+        if (x + radius < canvasPos.x || x - radius > right || y + radius < canvasPos.y || y - radius > bottom) continue;
+        drawList->AddCircle(ImVec2(x, y), radius, color, 12, 1.0f);
+    }
+}
+
+void MapView::DrawSnapGuide(ImDrawList* drawList, const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    ImVec2 point = WorldToScreen(snapGuide_.x, snapGuide_.z, canvasPos, canvasSize);
+    ImU32 color = IM_COL32(0, 255, 255, 255);
+    
+    // Grid snaps get a cross; zone snaps a line from the target's center
+    const Zone* target = data.getZone(snapGuide_.target);
+    if (snapGuide_.kind == SnapKind::Grid || !target) {
+        drawList->AddLine(ImVec2(point.x - 6.0f, point.y), ImVec2(point.x + 6.0f, point.y), color, 1.5f);
+        drawList->AddLine(ImVec2(point.x, point.y - 6.0f), ImVec2(point.x, point.y + 6.0f), color, 1.5f);
+        return;
+    }
+    ImVec2 targetCenter = WorldToScreen(target->x, target->z, canvasPos, canvasSize);
+    drawList->AddLine(targetCenter, point, color, 1.5f);
+    drawList->AddCircleFilled(point, 3.0f, color);
+}
+
+void MapView::SetCellOverlay(const std::vector<float>& values, int gridSize, float maxValue) {
+    cellOverlay_ = values;
+    cellOverlaySize_ = gridSize;
+    cellOverlayMax_ = std::max(maxValue, 1e-6f);
+}
+
+void MapView::DrawCellOverlay(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize) {
+    ViewTransform view = GetViewTransform(canvasPos, canvasSize);
+    float cellSizeX = currentMap_.worldSizeX / cellOverlaySize_;
+    float cellSizeZ = currentMap_.worldSizeZ / cellOverlaySize_;
+    
+    // Only the rows and columns that intersect the canvas
+    int minColumn = std::max(0, static_cast<int>(view.ToWorldX(canvasPos.x) / cellSizeX));
+    int maxColumn = std::min(cellOverlaySize_ - 1, static_cast<int>(view.ToWorldX(canvasPos.x + canvasSize.x) / cellSizeX));
+    int minRow = std::max(0, static_cast<int>(view.ToWorldZ(canvasPos.y + canvasSize.y) / cellSizeZ));
+    int maxRow = std::min(cellOverlaySize_ - 1, static_cast<int>(view.ToWorldZ(canvasPos.y) / cellSizeZ));
+    
+    for (int row = minRow; row <= maxRow; ++row) {
+        float top = view.ToScreenY((row + 1) * cellSizeZ);
+        float bottom = view.ToScreenY(row * cellSizeZ);
+        for (int column = minColumn; column <= maxColumn; ++column) {
+            float value = cellOverlay_[row * cellOverlaySize_ + column];
+            if (value <= 0.0f) continue;
+            
+            // Blue -> yellow -> red as the value approaches the maximum
+            float t = std::min(value / cellOverlayMax_, 1.0f);
+            int r = static_cast<int>(255 * std::min(t * 2.0f, 1.0f));
+            int g = static_cast<int>(255 * (t < 0.5f ? t * 2.0f : 2.0f - t * 2.0f));
+            int b = static_cast<int>(255 * std::max(1.0f - t * 2.0f, 0.0f));
+            drawList->AddRectFilled(ImVec2(view.ToScreenX(column * cellSizeX), top),
+                                    ImVec2(view.ToScreenX((column + 1) * cellSizeX), bottom),
+                                    IM_COL32(r, g, b, 60 + static_cast<int>(100 * t)));
+        }
+    }
 }
 
 void MapView::DrawMarquee(const ImVec2& canvasPos, const ImVec2& canvasSize) {
@@ -272,3 +829,16 @@ void MapView::DrawMarquee(const ImVec2& canvasPos, const ImVec2& canvasSize) {
     );
 }
 
+
+size_t MapView::GetCacheMemoryUsage() const {
+    size_t bytes = zoneIndex_.GetMemoryUsage();
+    bytes += (zoneWorldX_.capacity() + zoneWorldZ_.capacity() + zoneScreenX_.capacity() + zoneScreenY_.capacity()) * sizeof(float);
+    bytes += zoneVertices_.capacity() * sizeof(ImDrawVert) + zoneIndices_.capacity() * sizeof(ImDrawIdx);
+    bytes += zoneChunks_.capacity() * sizeof(ZoneMeshChunk);
+    bytes += labels_.capacity() * sizeof(MapLabel) + labelGrid_.capacity();
+    bytes += labelCandidates_.capacity() * sizeof(LabelCandidate);
+    bytes += labelWidths_.size() * (sizeof(std::pair<const NameId, float>) + 2 * sizeof(void*)) +
+             labelWidths_.bucket_count() * sizeof(void*);
+    bytes += cellOverlay_.capacity() * sizeof(float);
+    return bytes;
+}
@@ -1,19 +1,45 @@
 #pragma once
 
 #include "TerritoryData.h"
+#include "TextureCache.h"
+#include "ZoneIndex.h"
+#include "SelectionRegion.h"
+#include "ViewTransform.h"
+#include "ZoneSnapper.h"
 #include "imgui.h"
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 struct MapInfo {
     std::string name;
     std::string imagePath;
     float worldSizeX = 15360.0f;  // Chernarus world size
     float worldSizeZ = 15360.0f;
-    int imageWidth = 0;
-    int imageHeight = 0;
-    unsigned int textureId = 0;
+    
+    // Optional tiled imagery; used instead of imagePath when columns and rows are set.
+    // The pattern's {x}/{y} are replaced by the tile column/row, row 0 being the north edge.
+    std::string tilePattern;
+    int tileColumns = 0;
+    int tileRows = 0;
+    
+    std::string heightmapPath;
+    
+    std::string GetTilePath(int column, int row) const;
+};
+
+// A zone near a screen point, from MapView::GetZonesNear
+struct ZoneHit {
+    ZoneRef ref;
+    float distance = 0.0f;  // Screen pixels from the point to the zone center
+    bool covers = false;    // The point is inside the zone's drawn circle
+};
+
+enum class SelectionTool {
+    Marquee,
+    Lasso,    // Freehand outline while the mouse is held
+    Polygon   // Click to place vertices, close on the first vertex, double-click or Enter
 };
 
 class MapView {
@@ -21,6 +47,7 @@ public:
     MapView();
     ~MapView();
     
+    // Makes imagePath the current map image, decoding it now if it isn't cached yet
     bool LoadMapImage(const std::string& imagePath);
     void SetMapInfo(const MapInfo& info);
     const MapInfo& GetCurrentMap() const { return currentMap_; }
@@ -29,6 +56,7 @@ public:
     void Render(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize);
     
     // Coordinate conversion
+    ViewTransform GetViewTransform(const ImVec2& canvasPos, const ImVec2& canvasSize) const;
     ImVec2 WorldToScreen(float worldX, float worldZ, const ImVec2& canvasPos, const ImVec2& canvasSize) const;
     ImVec2 ScreenToWorld(float screenX, float screenY, const ImVec2& canvasPos, const ImVec2& canvasSize) const;
     
@@ -36,6 +64,7 @@ public:
     void Pan(float deltaX, float deltaY);
     void Zoom(float delta, float mouseX, float mouseY, const ImVec2& canvasPos, const ImVec2& canvasSize);
     void ResetView();
+    void CenterOn(float worldX, float worldZ);
     
     // Selection
     void StartMarqueeSelection(float x, float y);
@@ -45,9 +74,71 @@ public:
     ImVec2 GetMarqueeStart() const { return marqueeStart_; }
     ImVec2 GetMarqueeEnd() const { return marqueeEnd_; }
     
+    // Lasso / polygon selection, points in world coordinates
+    void StartRegionSelection();
+    void AddRegionPoint(float worldX, float worldZ);
+    void EndRegionSelection();
+    bool IsRegionSelecting() const { return isRegionSelecting_; }
+    const std::vector<RegionPoint>& GetRegionPoints() const { return regionPoints_; }
+    
+    // Outline drawn on top of the zones, e.g. a saved region; empty to hide
+    void SetHighlightedRegion(const std::vector<RegionPoint>& points) { highlightedRegion_ = points; }
+    
+    // Heat map of per-cell values (gridSize x gridSize, row 0 at world Z = 0) drawn under the zones
+    void SetCellOverlay(const std::vector<float>& values, int gridSize, float maxValue);
+    void ClearCellOverlay() { cellOverlay_.clear(); }
+    
+    // Call when zone data, selection or visibility changed so the cached zone geometry
+    // (and the spatial index, which only needs positions) is rebuilt
+    void InvalidateZoneCache() {
+        zoneCacheDirty_ = true;
+        zonePositionsDirty_ = true;
+        zoneIndex_.Invalidate();
+    }
+    
+    // Call when only selection flags changed; positions and the spatial index stay valid
+    void InvalidateZoneStyle() { zoneCacheDirty_ = true; }
+    
+    // Spatial index over all zones, rebuilt first if the document changed
+    const ZoneIndex& GetZoneIndex(const TerritoryData& data) {
+        zoneIndex_.Update(data);
+        return zoneIndex_;
+    }
+    
     // Zone selection
     std::vector<Zone*> GetZonesInRect(TerritoryData& data, float x1, float y1, float x2, float y2, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    std::vector<Zone*> GetZonesInPolygon(TerritoryData& data, const std::vector<RegionPoint>& polygon);
+    // Visible zone whose drawn circle contains the screen point (closest center wins), or nullptr
+    Zone* GetZoneAt(TerritoryData& data, float screenX, float screenY, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    // Visible zones whose drawn circle contains the screen point, closest center first, followed by
+    // up to maxNearby other zones with a center within tolerance pixels. Answered from the spatial index.
+    void GetZonesNear(const TerritoryData& data, float screenX, float screenY, float tolerance, size_t maxNearby,
+                      const ImVec2& canvasPos, const ImVec2& canvasSize, std::vector<ZoneHit>& out);
+    
+    // Zones outlined on top of everything else, e.g. the ones under the cursor
+    void SetHoveredZones(const std::vector<ZoneHit>& hits) { hoveredZones_ = hits; }
+    
+    // Outlines of zones not yet in the document, e.g. a generated fill awaiting confirmation
+    void SetPreviewZones(const std::vector<RegionPoint>& centers, float radius) {
+        previewZones_ = centers;
+        previewRadius_ = radius;
+    }
+    void ClearPreviewZones() { previewZones_.clear(); }
+    
+    // Marker for the snap applied to the zone being dragged; SnapKind::None hides it
+    void SetSnapGuide(const SnapResult& snap) { snapGuide_ = snap; }
     
+    // Territory and zone name labels, placed without overlap as the view zooms in
+    void SetShowLabels(bool show) {
+        showLabels_ = show;
+        zoneCacheDirty_ = true;
+    }
+    bool GetShowLabels() const { return showLabels_; }
+    
+    // Bytes held by the retained zone mesh, screen positions, labels and the spatial index
+    size_t GetCacheMemoryUsage() const;
+    const TextureCache& GetTextureCache() const { return textureCache_; }
+
 private:
     MapInfo currentMap_;
     
@@ -55,13 +146,119 @@ private:
     float panX_ = 0.0f;
     float panY_ = 0.0f;
     float zoom_ = 1.0f;
+    ImVec2 lastCanvasSize_ = ImVec2(1.0f, 1.0f);
     
     // Marquee selection
     bool isMarqueeSelecting_ = false;
     ImVec2 marqueeStart_;
     ImVec2 marqueeEnd_;
     
-    void DrawZone(const Zone& zone, const Territory& territory, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    // Lasso / polygon selection
+    bool isRegionSelecting_ = false;
+    std::vector<RegionPoint> regionPoints_;
+    std::vector<RegionPoint> highlightedRegion_;
+    std::vector<ZoneHit> hoveredZones_;
+    SnapResult snapGuide_;
+    std::vector<RegionPoint> previewZones_;
+    float previewRadius_ = 0.0f;
+    
+    // Cell overlay
+    std::vector<float> cellOverlay_;
+    int cellOverlaySize_ = 0;
+    float cellOverlayMax_ = 1.0f;
+    
+    ZoneIndex zoneIndex_;
+    
+    // Retained zone geometry in screen space for the cached view. Split into chunks
+    // of < 64k vertices so each chunk's 16-bit indices can be copied verbatim.
+    struct ZoneMeshChunk {
+        size_t vtxStart = 0;
+        size_t vtxCount = 0;
+        size_t idxStart = 0;
+        size_t idxCount = 0;
+    };
+    
+    struct ViewKey {
+        float panX = 0.0f;
+        float panY = 0.0f;
+        float zoom = 0.0f;
+        float canvasX = 0.0f;
+        float canvasY = 0.0f;
+        float canvasW = 0.0f;
+        float canvasH = 0.0f;
+        float worldSizeX = 0.0f;
+        float worldSizeZ = 0.0f;
+        
+        bool operator==(const ViewKey& other) const {
+            return panX == other.panX && panY == other.panY && zoom == other.zoom &&
+                   canvasX == other.canvasX && canvasY == other.canvasY &&
+                   canvasW == other.canvasW && canvasH == other.canvasH &&
+                   worldSizeX == other.worldSizeX && worldSizeZ == other.worldSizeZ;
+        }
+    };
+    
+    ViewKey MakeViewKey(const ImVec2& canvasPos, const ImVec2& canvasSize) const;
+    
+    // Zone centers flattened in document order (SoA), and their screen positions for
+    // positionsView_. Transformed in one batch when the view or the zones change, then
+    // shared by rendering and hit testing for the rest of the frame.
+    std::vector<float> zoneWorldX_;
+    std::vector<float> zoneWorldZ_;
+    std::vector<float> zoneScreenX_;
+    std::vector<float> zoneScreenY_;
+    bool zonePositionsDirty_ = true;
+    ViewKey positionsView_;
+    
+    void UpdateZonePositions(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    
+    std::vector<ImDrawVert> zoneVertices_;
+    std::vector<ImDrawIdx> zoneIndices_;
+    std::vector<ZoneMeshChunk> zoneChunks_;
+    bool zoneCacheDirty_ = true;
+    ViewKey cachedView_;
+    
+    void RebuildZoneCache(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize, const ImVec2& whiteUv);
+    
+    // Labels placed for cachedView_, rebuilt along with the zone mesh. Placement goes through
+    // a coarse screen-space occupancy grid: a label is kept only if all the cells under it are
+    // free, so labels never overlap and a dense view costs one grid test per candidate.
+    struct MapLabel {
+        ImVec2 pos;          // Top-left of the text
+        NameId name = 0;
+        uint32_t color = 0;
+    };
+    
+    bool showLabels_ = true;
+    std::vector<MapLabel> labels_;
+    std::vector<uint8_t> labelGrid_;
+    int labelGridColumns_ = 0;
+    int labelGridRows_ = 0;
+    struct LabelCandidate {
+        int rank = 0;            // Placed in rank order: territories, selected zones, other zones
+        float size = 0.0f;       // Then largest on screen first
+        ImVec2 center;
+        NameId name = 0;
+        uint32_t color = 0;
+    };
+    std::vector<LabelCandidate> labelCandidates_;
+    std::unordered_map<NameId, float> labelWidths_;           // Text width per name at labelFontSize_
+    float labelFontSize_ = 0.0f;
+    
+    void RebuildLabels(const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    float GetLabelWidth(NameId name);
+    bool PlaceLabel(const LabelCandidate& candidate, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawLabels(ImDrawList* drawList) const;
+    void AppendZoneCache(ImDrawList* drawList) const;
+    void TessellateZone(const ImVec2& center, float radius, uint32_t color, bool selected, const ImVec2& whiteUv);
     void DrawMarquee(const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawCellOverlay(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawPreviewZones(ImDrawList* drawList, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawSnapGuide(ImDrawList* drawList, const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawHoveredZones(ImDrawList* drawList, const TerritoryData& data, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawRegion(ImDrawList* drawList, const std::vector<RegionPoint>& points, bool closed, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    void DrawMapImage(ImDrawList* drawList, const std::string& imagePath, float minX, float minZ,
+                      float maxX, float maxZ, const ImVec2& canvasPos, const ImVec2& canvasSize);
+    
+    TextureCache textureCache_;
 };
 
@@ -0,0 +1,105 @@
+#include "MemoryStats.h"
+#include "imgui.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+// Every ImGui allocation carries its size in a header, so frees can be counted too.
+// 16 bytes keeps the returned pointer as aligned as malloc's.
+static const size_t ALLOCATION_HEADER = 16;
+static std::atomic<size_t> imguiHeapBytes{0};
+static std::atomic<size_t> imguiPeakHeapBytes{0};
+
+static void* CountingAlloc(size_t size, void*) {
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + ALLOCATION_HEADER));
+    if (!block) {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    size_t bytes = imguiHeapBytes += size;
+    size_t peak = imguiPeakHeapBytes;
+    while (bytes > peak && !imguiPeakHeapBytes.compare_exchange_weak(peak, bytes)) {
+        // A failed exchange reloads peak; retry while we still hold the larger value
+    }
+    return block + ALLOCATION_HEADER;
+}
+
+static void CountingFree(void* ptr, void*) {
+    if (!ptr) {
+        return;
+    }
+    unsigned char* block = static_cast<unsigned char*>(ptr) - ALLOCATION_HEADER;
+    imguiHeapBytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+void MemoryStats::InstallImGuiAllocator() {
+    ImGui::SetAllocatorFunctions(CountingAlloc, CountingFree, nullptr);
+}
+
+size_t MemoryStats::GetImGuiHeapBytes() {
+    return imguiHeapBytes;
+}
+
+size_t MemoryStats::GetImGuiPeakHeapBytes() {
+    return imguiPeakHeapBytes;
+}
+
+void MemoryStats::Set(const char* name, size_t bytes, size_t peak) {
+    auto it = std::find_if(entries_.begin(), entries_.end(), [name](const Entry& entry) { return entry.name == name; });
+    if (it == entries_.end()) {
+        entries_.push_back(Entry());
+        it = entries_.end() - 1;
+        it->name = name;
+    }
+    it->bytes = bytes;
+    it->peak = std::max(it->peak, std::max(bytes, peak));
+}
+
+void MemoryStats::FinishSample() {
+    total_ = 0;
+    for (const Entry& entry : entries_) {
+        total_ += entry.bytes;
+    }
+    peakTotal_ = std::max(peakTotal_, total_);
+    samples_++;
+}
+
+void MemoryStats::ResetPeaks() {
+    for (Entry& entry : entries_) {
+        entry.peak = entry.bytes;
+    }
+    peakTotal_ = total_;
+    imguiPeakHeapBytes = imguiHeapBytes.load();
+}
+
+std::string MemoryStats::ToJson() const {
+    // Category names are plain identifiers, so nothing needs escaping
+    std::string json = "{\n";
+    json += "  \"samples\": " + std::to_string(samples_) + ",\n";
+    json += "  \"total\": { \"bytes\": " + std::to_string(total_) + ", \"peak\": " + std::to_string(peakTotal_) + " },\n";
+    json += "  \"categories\": {";
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        const Entry& entry = entries_[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "    \"" + entry.name + "\": { \"bytes\": " + std::to_string(entry.bytes) +
+                ", \"peak\": " + std::to_string(entry.peak) + " }";
+    }
+    json += "\n  }\n}\n";
+    return json;
+}
+
+std::string MemoryStats::FormatBytes(size_t bytes) {
+    char text[32];
+    if (bytes >= 1024ull * 1024 * 1024) {
+        snprintf(text, sizeof(text), "%.2f GB", bytes / (1024.0 * 1024.0 * 1024.0));
+    } else if (bytes >= 1024 * 1024) {
+        snprintf(text, sizeof(text), "%.2f MB", bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024) {
+        snprintf(text, sizeof(text), "%.1f KB", bytes / 1024.0);
+    } else {
+        snprintf(text, sizeof(text), "%zu B", bytes);
+    }
+    return text;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Bytes held by each subsystem, as last reported by its owner, with the high-water
+// mark of every entry since the last ResetPeaks(). Owners report capacity-based
+// estimates; only the ImGui heap is counted exactly, through an allocator hook.
+class MemoryStats {
+public:
+    struct Entry {
+        std::string name;   // Dotted category, e.g. "cache.map_view"
+        size_t bytes = 0;
+        size_t peak = 0;
+    };
+    
+    // Adds or updates an entry; peak is for owners that track their own high-water mark
+    void Set(const char* name, size_t bytes, size_t peak = 0);
+    // Call after a full round of Set(): updates the total and its high-water mark
+    void FinishSample();
+    void ResetPeaks();
+    
+    const std::vector<Entry>& GetEntries() const { return entries_; }
+    size_t GetTotal() const { return total_; }
+    size_t GetPeakTotal() const { return peakTotal_; }
+    size_t GetSampleCount() const { return samples_; }
+    
+    // {"samples": n, "total": {"bytes": b, "peak": p}, "categories": {"name": {"bytes": b, "peak": p}, ...}}
+    std::string ToJson() const;
+    
+    static std::string FormatBytes(size_t bytes);
+    
+    // Routes ImGui's allocations through a byte counter; call before ImGui::CreateContext
+    static void InstallImGuiAllocator();
+    static size_t GetImGuiHeapBytes();
+    static size_t GetImGuiPeakHeapBytes();
+
+private:
+    std::vector<Entry> entries_;  // In the order they were first reported
+    size_t total_ = 0;
+    size_t peakTotal_ = 0;
+    size_t samples_ = 0;
+};
@@ -0,0 +1,72 @@
+#include "NameTable.h"
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+namespace {
+
+struct Table {
+    std::mutex mutex;
+    // deque never moves existing elements, so returned references and the
+    // string_view keys below stay valid as the table grows
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, NameId> ids;
+    
+    Table() {
+        names.emplace_back();
+        ids.emplace(std::string_view(names.back()), 0);
+    }
+};
+
+Table& GetTable() {
+    static Table table;
+    return table;
+}
+
+}
+
+NameId NameTable::Intern(std::string_view name) {
+    Table& table = GetTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    
+    auto it = table.ids.find(name);
+    if (it != table.ids.end()) {
+        return it->second;
+    }
+    
+    NameId id = static_cast<NameId>(table.names.size());
+    table.names.emplace_back(name);
+    table.ids.emplace(std::string_view(table.names.back()), id);
+    return id;
+}
+
+const std::string& NameTable::Resolve(NameId id) {
+    Table& table = GetTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (id >= table.names.size()) {
+        return table.names[0];
+    }
+    return table.names[id];
+}
+
+size_t NameTable::Size() {
+    Table& table = GetTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    return table.names.size();
+}
+
+size_t NameTable::GetMemoryUsage() {
+    Table& table = GetTable();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    size_t bytes = table.names.size() * sizeof(std::string);
+    for (const auto& name : table.names) {
+        // Short names live inside the std::string itself
+        if (name.capacity() >= sizeof(std::string)) {
+            bytes += name.capacity() + 1;
+        }
+    }
+    // One node (key, value, next pointer, cached hash) per name plus the bucket array
+    bytes += table.ids.size() * (sizeof(std::pair<const std::string_view, NameId>) + 2 * sizeof(void*));
+    bytes += table.ids.bucket_count() * sizeof(void*);
+    return bytes;
+}
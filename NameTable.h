@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// Compact handle to an interned zone/territory name. 0 is the empty string.
+typedef uint32_t NameId;
+
+// Process-wide, append-only table of interned names. Ids stay valid for the
+// lifetime of the process, so documents and undo snapshots can copy them
+// freely; resolve to text only for display and saving. Thread-safe, since
+// files are parsed on background threads.
+class NameTable {
+public:
+    static NameId Intern(std::string_view name);
+    static const std::string& Resolve(NameId id);
+    static const char* CStr(NameId id) { return Resolve(id).c_str(); }
+    static size_t Size();
+    // Approximate heap bytes held by the table: strings, deque blocks and the hash map
+    static size_t GetMemoryUsage();
+};
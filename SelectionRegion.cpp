@@ -0,0 +1,148 @@
+#include "SelectionRegion.h"
+#include "tinyxml2.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace tinyxml2;
+
+PolygonTester::PolygonTester(const std::vector<RegionPoint>& points) {
+    if (points.size() < 3) {
+        return;
+    }
+    
+    minX = maxX = points[0].x;
+    minZ = maxZ = points[0].z;
+    for (const auto& p : points) {
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minZ = std::min(minZ, p.z);
+        maxZ = std::max(maxZ, p.z);
+    }
+    
+    // Horizontal edges never cross a horizontal ray, so they are dropped
+    edges_.reserve(points.size());
+    for (size_t i = 0; i < points.size(); ++i) {
+        RegionPoint a = points[i];
+        RegionPoint b = points[(i + 1) % points.size()];
+        if (a.z == b.z) {
+            continue;
+        }
+        if (a.z > b.z) {
+            std::swap(a, b);
+        }
+        Edge edge;
+        edge.z0 = a.z;
+        edge.z1 = b.z;
+        edge.x0 = a.x;
+        edge.slope = (b.x - a.x) / (b.z - a.z);
+        edges_.push_back(edge);
+    }
+    if (edges_.empty()) {
+        return;
+    }
+    
+    // About two edges per band keeps every band short even for long lassos
+    bandCount_ = static_cast<int>(std::min<size_t>(std::max<size_t>(edges_.size() / 2, 1), 4096));
+    bandScale_ = bandCount_ / std::max(maxZ - minZ, 1e-6f);
+    
+    auto bandOf = [this](float z) {
+        int band = static_cast<int>((z - minZ) * bandScale_);
+        return std::min(std::max(band, 0), bandCount_ - 1);
+    };
+    
+    // Counting sort of edges into every band they overlap
+    bandStart_.assign(bandCount_ + 1, 0);
+    for (const auto& edge : edges_) {
+        for (int band = bandOf(edge.z0); band <= bandOf(edge.z1); ++band) {
+            bandStart_[band + 1]++;
+        }
+    }
+    for (int band = 0; band < bandCount_; ++band) {
+        bandStart_[band + 1] += bandStart_[band];
+    }
+    bandEdges_.resize(bandStart_[bandCount_]);
+    std::vector<uint32_t> fill(bandStart_.begin(), bandStart_.end() - 1);
+    for (uint32_t e = 0; e < edges_.size(); ++e) {
+        for (int band = bandOf(edges_[e].z0); band <= bandOf(edges_[e].z1); ++band) {
+            bandEdges_[fill[band]++] = e;
+        }
+    }
+}
+
+bool PolygonTester::Contains(float x, float z) const {
+    if (edges_.empty() || x < minX || x > maxX || z < minZ || z > maxZ) {
+        return false;
+    }
+    
+    int band = std::min(std::max(static_cast<int>((z - minZ) * bandScale_), 0), bandCount_ - 1);
+    
+    // Count crossings of a ray from the point towards -X; half-open in Z so shared vertices count once
+    bool inside = false;
+    for (uint32_t i = bandStart_[band]; i < bandStart_[band + 1]; ++i) {
+        const Edge& edge = edges_[bandEdges_[i]];
+        if (z >= edge.z0 && z < edge.z1 && edge.x0 + (z - edge.z0) * edge.slope < x) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+bool SelectionRegionStore::LoadFromFile(const std::string& filepath, std::vector<SelectionRegion>& regions) {
+    regions.clear();
+    
+    XMLDocument doc;
+    if (doc.LoadFile(filepath.c_str()) != XML_SUCCESS) {
+        return false;
+    }
+    
+    XMLElement* root = doc.FirstChildElement("regions");
+    if (!root) {
+        return false;
+    }
+    
+    for (XMLElement* regionElem = root->FirstChildElement("region"); regionElem; regionElem = regionElem->NextSiblingElement("region")) {
+        SelectionRegion region;
+        const char* name = regionElem->Attribute("name");
+        const char* mapName = regionElem->Attribute("map");
+        region.name = name ? name : "";
+        region.mapName = mapName ? mapName : "";
+        
+        for (XMLElement* pointElem = regionElem->FirstChildElement("point"); pointElem; pointElem = pointElem->NextSiblingElement("point")) {
+            RegionPoint point;
+            point.x = pointElem->FloatAttribute("x");
+            point.z = pointElem->FloatAttribute("z");
+            region.points.push_back(point);
+        }
+        
+        if (region.points.size() >= 3) {
+            regions.push_back(std::move(region));
+        }
+    }
+    
+    return true;
+}
+
+bool SelectionRegionStore::SaveToFile(const std::string& filepath, const std::vector<SelectionRegion>& regions) {
+    XMLDocument doc;
+    doc.InsertFirstChild(doc.NewDeclaration());
+    
+    XMLElement* root = doc.NewElement("regions");
+    doc.InsertEndChild(root);
+    
+    for (const auto& region : regions) {
+        XMLElement* regionElem = doc.NewElement("region");
+        regionElem->SetAttribute("name", region.name.c_str());
+        regionElem->SetAttribute("map", region.mapName.c_str());
+        
+        for (const auto& point : region.points) {
+            XMLElement* pointElem = doc.NewElement("point");
+            pointElem->SetAttribute("x", point.x);
+            pointElem->SetAttribute("z", point.z);
+            regionElem->InsertEndChild(pointElem);
+        }
+        
+        root->InsertEndChild(regionElem);
+    }
+    
+    return doc.SaveFile(filepath.c_str()) == XML_SUCCESS;
+}
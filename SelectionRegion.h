@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct RegionPoint {
+    float x = 0.0f;
+    float z = 0.0f;
+};
+
+// A lasso or polygon outline in world coordinates, saved for reuse
+struct SelectionRegion {
+    std::string name;
+    std::string mapName;
+    std::vector<RegionPoint> points;
+};
+
+// Even-odd point-in-polygon test. Edges are bucketed into horizontal bands
+// over the polygon's Z extent, so each test only crosses the few edges that
+// span the query's band instead of the whole outline.
+class PolygonTester {
+public:
+    explicit PolygonTester(const std::vector<RegionPoint>& points);
+    
+    bool IsValid() const { return !edges_.empty(); }
+    bool Contains(float x, float z) const;
+    
+    // Bounding box, for pre-filtering candidates through a spatial index
+    float minX = 0.0f;
+    float minZ = 0.0f;
+    float maxX = 0.0f;
+    float maxZ = 0.0f;
+    
+private:
+    struct Edge {
+        float z0 = 0.0f;     // z0 < z1
+        float z1 = 0.0f;
+        float x0 = 0.0f;     // X at z0
+        float slope = 0.0f;  // dX/dZ
+    };
+    
+    std::vector<Edge> edges_;
+    std::vector<uint32_t> bandStart_;  // bandEdges_ range of band i is [bandStart_[i], bandStart_[i + 1])
+    std::vector<uint32_t> bandEdges_;
+    float bandScale_ = 0.0f;
+    int bandCount_ = 0;
+};
+
+class SelectionRegionStore {
+public:
+    static const char* DefaultPath() { return "TerritoryEditor.regions.xml"; }
+    
+    static bool LoadFromFile(const std::string& filepath, std::vector<SelectionRegion>& regions);
+    static bool SaveToFile(const std::string& filepath, const std::vector<SelectionRegion>& regions);
+};
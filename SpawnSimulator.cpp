@@ -0,0 +1,246 @@
+#include "SpawnSimulator.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+
+// Rounds simulated together before their cell rows are folded into the running statistics;
+// bounds the per-round cell memory to this many rows however many rounds are run
+static const size_t ROUNDS_PER_BATCH = 32;
+
+// SplitMix64: tiny, fast, and good enough for spawn counts
+struct SimRandom {
+    uint64_t state;
+    
+    explicit SimRandom(uint64_t seed) : state(seed) {}
+    
+    uint64_t Next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    
+    // Uniform in [0, range)
+    uint32_t Below(uint32_t range) {
+        return static_cast<uint32_t>(((Next() >> 32) * range) >> 32);
+    }
+};
+
+SpawnSimulator::Input SpawnSimulator::Capture(const TerritoryData& data, const SpawnSimSettings& settings) {
+    Input input;
+    input.settings = settings;
+    input.settings.rounds = std::min(std::max(settings.rounds, 1), MAX_ROUNDS);
+    input.settings.gridSize = std::min(std::max(settings.gridSize, 1), MAX_GRID_SIZE);
+    
+    input.zones.reserve(data.getTotalZoneCount());
+    input.territoryNames.reserve(data.territories.size());
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        input.territoryNames.push_back(data.territories[t].name);
+        
+        for (const Zone& zone : data.territories[t].zones) {
+            Input::SimZone sim;
+            sim.territory = t;
+            sim.x = zone.x;
+            sim.z = zone.z;
+            sim.r = std::max(zone.r, 0.0f);
+            sim.staticMin = std::max(zone.smin, 0);
+            sim.staticRange = std::max(zone.smax - sim.staticMin, 0) + 1;
+            sim.dynamicMin = std::max(zone.dmin, 0);
+            sim.dynamicRange = std::max(zone.dmax - sim.dynamicMin, 0) + 1;
+            input.zones.push_back(sim);
+        }
+    }
+    
+    return input;
+}
+
+void SpawnSimulator::BuildCellTable(const Input& input, CellTable& table) {
+    int grid = input.settings.gridSize;
+    float cellSizeX = input.settings.worldSizeX / grid;
+    float cellSizeZ = input.settings.worldSizeZ / grid;
+    auto cellOf = [&](float x, float z) {
+        int cx = std::min(std::max(static_cast<int>(x / cellSizeX), 0), grid - 1);
+        int cz = std::min(std::max(static_cast<int>(z / cellSizeZ), 0), grid - 1);
+        return static_cast<uint32_t>(cz * grid + cx);
+    };
+    
+    // Circles spanning several cells are split by an 8x8 lattice over their bounds; a spawn
+    // then lands in the cell of a uniformly picked lattice point inside the circle
+    const int SAMPLES = 8;
+    
+    table.zones.resize(input.zones.size());
+    for (size_t i = 0; i < input.zones.size(); ++i) {
+        const Input::SimZone& zone = input.zones[i];
+        CellTable::Range& range = table.zones[i];
+        range.cellStart = static_cast<uint32_t>(table.cells.size());
+        
+        uint32_t minCell = cellOf(zone.x - zone.r, zone.z - zone.r);
+        uint32_t maxCell = cellOf(zone.x + zone.r, zone.z + zone.r);
+        if (minCell == maxCell) {
+            table.cells.push_back(minCell);
+            continue;
+        }
+        
+        range.sampleStart = static_cast<uint32_t>(table.samples.size());
+        for (int a = 0; a < SAMPLES; ++a) {
+            for (int b = 0; b < SAMPLES; ++b) {
+                float dx = ((a + 0.5f) / SAMPLES * 2.0f - 1.0f) * zone.r;
+                float dz = ((b + 0.5f) / SAMPLES * 2.0f - 1.0f) * zone.r;
+                if (dx * dx + dz * dz > zone.r * zone.r) continue;
+                
+                uint32_t cell = cellOf(zone.x + dx, zone.z + dz);
+                auto first = table.cells.begin() + range.cellStart;
+                auto it = std::find(first, table.cells.end(), cell);
+                if (it == table.cells.end()) {
+                    table.cells.push_back(cell);
+                    it = table.cells.end() - 1;
+                    first = table.cells.begin() + range.cellStart;
+                }
+                table.samples.push_back(static_cast<uint8_t>(it - first));
+            }
+        }
+        range.sampleCount = static_cast<uint32_t>(table.samples.size()) - range.sampleStart;
+    }
+}
+
+// Index of the lower of the two samples a percentile interpolates between
+static size_t PercentileIndex(size_t count, float p) {
+    return static_cast<size_t>(p * (count - 1));
+}
+
+// Linear-interpolated percentile of count sorted samples, of which only the largest
+// tailSize are given (ascending); the tail has to reach PercentileIndex(count, p)
+static float Percentile(const uint32_t* tail, size_t tailSize, size_t count, float p) {
+    if (count == 0) return 0.0f;
+    float pos = p * (count - 1);
+    size_t lo = static_cast<size_t>(pos);
+    size_t hi = std::min(lo + 1, count - 1);
+    float frac = pos - lo;
+    size_t first = count - tailSize;
+    return tail[lo - first] * (1.0f - frac) + tail[hi - first] * frac;
+}
+
+SpawnSimResult SpawnSimulator::Run(const Input& input) {
+    auto start = std::chrono::steady_clock::now();
+    
+    SpawnSimResult result;
+    result.settings = input.settings;
+    size_t rounds = input.settings.rounds;
+    size_t cellCount = static_cast<size_t>(input.settings.gridSize) * input.settings.gridSize;
+    size_t territoryCount = input.territoryNames.size();
+    
+    CellTable table;
+    BuildCellTable(input, table);
+    
+    // Per-round territory samples, round-major; every round writes only its own row
+    std::vector<uint32_t> territoryTotals(rounds * territoryCount, 0);
+    
+    // Cells only keep running statistics: the sum, and the largest samples down to the one p95
+    // reads (a min-heap per cell), so memory grows with the grid and not with the rounds. The
+    // heaps start out as zeros, which counts can't go below, so they hold the exact top samples.
+    const float CELL_PERCENTILE = 0.95f;
+    size_t keep = rounds - PercentileIndex(rounds, CELL_PERCENTILE);
+    std::vector<uint64_t> cellSums(cellCount, 0);
+    std::vector<uint32_t> cellTop(cellCount * keep, 0);
+    std::vector<uint32_t> cellRows(std::min(rounds, ROUNDS_PER_BATCH) * cellCount);
+    
+    for (size_t batchStart = 0; batchStart < rounds; batchStart += ROUNDS_PER_BATCH) {
+        size_t batchRounds = std::min(ROUNDS_PER_BATCH, rounds - batchStart);
+        std::fill(cellRows.begin(), cellRows.begin() + batchRounds * cellCount, 0);
+        
+        JobSystem::ParallelFor("Simulate rounds", batchRounds, 1, [&](size_t, size_t beginRow, size_t endRow) {
+            for (size_t row = beginRow; row < endRow; ++row) {
+                size_t round = batchStart + row;
+                SimRandom rng(input.settings.seed * 0x100000001B3ull + round);
+                uint32_t* territoryRow = territoryTotals.data() + round * territoryCount;
+                uint32_t* cellRow = cellRows.data() + row * cellCount;
+                
+                for (size_t i = 0; i < input.zones.size(); ++i) {
+                    const Input::SimZone& zone = input.zones[i];
+                    const CellTable::Range& range = table.zones[i];
+                    uint32_t spawns = zone.staticMin + rng.Below(zone.staticRange) +
+                                      zone.dynamicMin + rng.Below(zone.dynamicRange);
+                    territoryRow[zone.territory] += spawns;
+                    
+                    if (range.sampleCount == 0) {
+                        cellRow[table.cells[range.cellStart]] += spawns;
+                        continue;
+                    }
+                    // Each 64-bit draw places four spawns, 16 bits apiece
+                    const uint8_t* samples = table.samples.data() + range.sampleStart;
+                    const uint32_t* cells = table.cells.data() + range.cellStart;
+                    uint64_t bits = 0;
+                    for (uint32_t s = 0; s < spawns; ++s) {
+                        if ((s & 3) == 0) {
+                            bits = rng.Next();
+                        }
+                        uint32_t pick = static_cast<uint32_t>(((bits & 0xFFFF) * range.sampleCount) >> 16);
+                        bits >>= 16;
+                        cellRow[cells[samples[pick]]]++;
+                    }
+                }
+            }
+        });
+        
+        // Fold the batch into the running cell statistics, cells split across cores
+        JobSystem::ParallelFor("Fold simulated cells", cellCount, 256, [&](size_t, size_t beginCell, size_t endCell) {
+            for (size_t cell = beginCell; cell < endCell; ++cell) {
+                uint32_t* top = cellTop.data() + cell * keep;
+                for (size_t row = 0; row < batchRounds; ++row) {
+                    uint32_t value = cellRows[row * cellCount + cell];
+                    cellSums[cell] += value;
+                    if (value > top[0]) {
+                        std::pop_heap(top, top + keep, std::greater<uint32_t>());
+                        top[keep - 1] = value;
+                        std::push_heap(top, top + keep, std::greater<uint32_t>());
+                    }
+                }
+            }
+        });
+    }
+    
+    // Territory statistics
+    result.territories.resize(territoryCount);
+    std::vector<uint32_t> samples(rounds);
+    for (size_t t = 0; t < territoryCount; ++t) {
+        uint64_t sum = 0;
+        for (size_t round = 0; round < rounds; ++round) {
+            samples[round] = territoryTotals[round * territoryCount + t];
+            sum += samples[round];
+        }
+        std::sort(samples.begin(), samples.end());
+        
+        TerritoryPopulation& population = result.territories[t];
+        population.name = input.territoryNames[t];
+        population.mean = static_cast<float>(sum) / rounds;
+        population.p5 = Percentile(samples.data(), rounds, rounds, 0.05f);
+        population.p50 = Percentile(samples.data(), rounds, rounds, 0.5f);
+        population.p95 = Percentile(samples.data(), rounds, rounds, 0.95f);
+        result.totalMean += population.mean;
+    }
+    for (const auto& zone : input.zones) {
+        result.territories[zone.territory].zoneCount++;
+    }
+    
+    // Cell statistics, cells split across cores
+    result.cellMean.assign(cellCount, 0.0f);
+    result.cellP95.assign(cellCount, 0.0f);
+    JobSystem::ParallelFor("Simulation cell statistics", cellCount, 64, [&](size_t, size_t beginCell, size_t endCell) {
+        for (size_t cell = beginCell; cell < endCell; ++cell) {
+            if (cellSums[cell] == 0) continue;
+            uint32_t* top = cellTop.data() + cell * keep;
+            std::sort(top, top + keep);
+            result.cellMean[cell] = static_cast<float>(cellSums[cell]) / rounds;
+            result.cellP95[cell] = Percentile(top, keep, rounds, CELL_PERCENTILE);
+        }
+    });
+    for (size_t cell = 0; cell < cellCount; ++cell) {
+        result.maxCellMean = std::max(result.maxCellMean, result.cellMean[cell]);
+        result.maxCellP95 = std::max(result.maxCellP95, result.cellP95[cell]);
+    }
+    
+    result.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
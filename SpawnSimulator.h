@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <vector>
+#include <cstdint>
+
+struct SpawnSimSettings {
+    int rounds = 256;
+    int gridSize = 128;  // Cells per side of the population grid
+    float worldSizeX = 15360.0f;
+    float worldSizeZ = 15360.0f;
+    uint64_t seed = 1;
+};
+
+struct TerritoryPopulation {
+    NameId name = 0;
+    size_t zoneCount = 0;
+    float mean = 0.0f;
+    float p5 = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+};
+
+struct SpawnSimResult {
+    SpawnSimSettings settings;
+    std::vector<TerritoryPopulation> territories;  // Same order as the document
+    std::vector<float> cellMean;                   // gridSize * gridSize, row 0 at world Z = 0
+    std::vector<float> cellP95;
+    float maxCellMean = 0.0f;
+    float maxCellP95 = 0.0f;
+    float totalMean = 0.0f;
+    double elapsedMs = 0.0;
+};
+
+// Monte Carlo estimate of how many spawns exist where. Each round draws every
+// zone's static (smin..smax) and dynamic (dmin..dmax) count uniformly and
+// scatters the spawns uniformly over the zone's circle. Rounds are spread over
+// all cores; each round has its own seed, so results don't depend on the
+// thread count.
+class SpawnSimulator {
+public:
+    // Compact copy of what the simulation needs, taken on the main thread so
+    // Run() can work in the background while the document keeps changing
+    struct Input {
+        struct SimZone {
+            uint32_t territory = 0;
+            float x = 0.0f;
+            float z = 0.0f;
+            float r = 0.0f;
+            int staticMin = 0;
+            int staticRange = 1;   // Number of possible values
+            int dynamicMin = 0;
+            int dynamicRange = 1;
+        };
+        
+        SpawnSimSettings settings;
+        std::vector<NameId> territoryNames;
+        std::vector<SimZone> zones;
+    };
+    
+    static const int MAX_ROUNDS = 1024;
+    static const int MAX_GRID_SIZE = 256;
+    
+    static Input Capture(const TerritoryData& data, const SpawnSimSettings& settings);
+    static SpawnSimResult Run(const Input& input);
+    
+private:
+    // Which grid cells each zone's spawns can land in
+    struct CellTable {
+        struct Range {
+            uint32_t cellStart = 0;    // Range in cells
+            uint32_t sampleStart = 0;  // Range in samples; empty if the zone lies in one cell
+            uint32_t sampleCount = 0;
+        };
+        
+        std::vector<Range> zones;
+        std::vector<uint32_t> cells;
+        std::vector<uint8_t> samples;  // Lattice points inside the circle, as indices into the zone's cells
+    };
+    
+    static void BuildCellTable(const Input& input, CellTable& table);
+};
@@ -0,0 +1,72 @@
+#include "TerritoryData.h"
+#include <new>
+#include <cstddef>
+
+// Per-allocation slack for alignment in the monotonic arena
+static const size_t ARENA_ALLOCATION_SLACK = alignof(std::max_align_t);
+
+TerritoryData::TerritoryData()
+    : arena_(std::make_unique<std::pmr::unsynchronized_pool_resource>()),
+      territories(arena_.get()) {
+}
+
+TerritoryData::TerritoryData(const TerritoryData& other)
+    : arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(other.getStorageSize())),
+      territories(arena_.get()) {
+    territories.reserve(other.territories.size());
+    for (const auto& territory : other.territories) {
+        territories.push_back(territory);
+    }
+}
+
+TerritoryData::TerritoryData(TerritoryData&& other) noexcept
+    : arena_(std::move(other.arena_)),
+      territories(std::move(other.territories)) {
+    other.ResetStorage();
+}
+
+TerritoryData& TerritoryData::operator=(const TerritoryData& other) {
+    if (this != &other) {
+        // Copies into our own arena; the pool reuses the blocks we release here
+        territories.assign(other.territories.begin(), other.territories.end());
+    }
+    return *this;
+}
+
+TerritoryData& TerritoryData::operator=(TerritoryData&& other) noexcept {
+    if (this == &other) {
+        return *this;
+    }
+    
+    // A pmr vector's allocator is fixed at construction, so adopt other's arena by
+    // rebuilding the vector in place around it instead of moving element by element
+    territories.~TerritoryList();
+    arena_ = std::move(other.arena_);
+    new (&territories) TerritoryList(std::move(other.territories));
+    
+    other.ResetStorage();
+    return *this;
+}
+
+void TerritoryData::ResetStorage() {
+    // Leaves the document empty and independent of any arena it shared before
+    territories.~TerritoryList();
+    arena_ = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+    new (&territories) TerritoryList(arena_.get());
+}
+
+size_t TerritoryData::getStorageSize() const {
+    size_t bytes = territories.size() * sizeof(Territory) + ARENA_ALLOCATION_SLACK;
+    for (const auto& territory : territories) {
+        bytes += territory.zones.size() * sizeof(Zone) + ARENA_ALLOCATION_SLACK;
+    }
+    return bytes;
+}
+
+size_t TerritoryData::getMemoryUsage() const {
+    size_t bytes = territories.capacity() * sizeof(Territory);
+    for (const auto& territory : territories) {
+        bytes += territory.zones.capacity() * sizeof(Zone);
+    }
+    return bytes;
+}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include "NameTable.h"
 #include <string>
 #include <vector>
+#include <memory>
+#include <memory_resource>
 #include <cstdint>
 
 struct Zone {
-    std::string name;
+    NameId name = 0;  // Interned; usually the same id as the territory
     int smin = 0;
     int smax = 0;
     int dmin = 0;
@@ -17,24 +20,77 @@ struct Zone {
     
     bool selected = false;
     bool visible = true;
+    uint32_t sourceId = UINT32_MAX;  // Element in the loaded file (see TerritorySource); UINT32_MAX if new
 };
 
+// Zone storage comes from the owning document's memory resource (see TerritoryData)
+using ZoneList = std::pmr::vector<Zone>;
+
 struct Territory {
-    std::string name;  // Will be extracted from zone names or set to "Territory N"
+    // Allocator-aware, so containers construct territories (and their zone lists) in their own arena
+    using allocator_type = std::pmr::polymorphic_allocator<Zone>;
+    
+    NameId name = 0;  // Will be extracted from zone names or set to "Territory N"
     uint32_t color = 0xFFFFFFFF;
-    std::vector<Zone> zones;
+    ZoneList zones;
     
     bool visible = true;
     bool expanded = true;
+    uint32_t sourceId = UINT32_MAX;  // Element in the loaded file (see TerritorySource); UINT32_MAX if new
+    
+    Territory() = default;
+    explicit Territory(const allocator_type& alloc) : zones(alloc) {}
+    Territory(const Territory& other, const allocator_type& alloc = {})
+        : name(other.name), color(other.color), zones(other.zones, alloc),
+          visible(other.visible), expanded(other.expanded), sourceId(other.sourceId) {}
+    Territory(Territory&& other) = default;
+    Territory(Territory&& other, const allocator_type& alloc)
+        : name(other.name), color(other.color), zones(std::move(other.zones), alloc),
+          visible(other.visible), expanded(other.expanded), sourceId(other.sourceId) {}
+    Territory& operator=(const Territory& other) = default;
+    Territory& operator=(Territory&& other) = default;
+};
+
+using TerritoryList = std::pmr::vector<Territory>;
+
+// Index-based handle to a zone. Unlike Zone*, it stays meaningful across copies
+// of the document, but is invalidated by inserting or removing zones.
+struct ZoneRef {
+    uint32_t territory = UINT32_MAX;
+    uint32_t zone = UINT32_MAX;
+    
+    bool valid() const { return territory != UINT32_MAX && zone != UINT32_MAX; }
 };
 
+// A document owns the memory resource behind all of its territories and zones.
+// The live document uses a pool so edits reuse freed blocks and fragmentation
+// stays flat; copies (undo snapshots) get a monotonic arena sized to fit in one
+// block. Dropping a document or moving another into it releases its arena
+// wholesale instead of freeing every zone list.
 struct TerritoryData {
-    std::vector<Territory> territories;
+private:
+    std::unique_ptr<std::pmr::memory_resource> arena_;  // Declared first: outlives territories
+    
+    void ResetStorage();
+    
+public:
+    TerritoryList territories;
+    
+    TerritoryData();
+    TerritoryData(const TerritoryData& other);
+    TerritoryData(TerritoryData&& other) noexcept;
+    TerritoryData& operator=(const TerritoryData& other);
+    TerritoryData& operator=(TerritoryData&& other) noexcept;
     
     void clear() {
-        territories.clear();
+        *this = TerritoryData();
     }
     
+    // Bytes needed to hold a copy of this document's territories and zones
+    size_t getStorageSize() const;
+    // Bytes of territory and zone storage currently allocated (capacity, not size)
+    size_t getMemoryUsage() const;
+    
     size_t getTotalZoneCount() const {
         size_t count = 0;
         for (const auto& territory : territories) {
@@ -42,5 +98,27 @@ struct TerritoryData {
         }
         return count;
     }
+    
+    Zone* getZone(ZoneRef ref) {
+        if (ref.territory >= territories.size() || ref.zone >= territories[ref.territory].zones.size()) {
+            return nullptr;
+        }
+        return &territories[ref.territory].zones[ref.zone];
+    }
+    
+    const Zone* getZone(ZoneRef ref) const {
+        return const_cast<TerritoryData*>(this)->getZone(ref);
+    }
+    
+    // Reverse lookup of a zone pointer; O(territories)
+    ZoneRef findZone(const Zone* zone) const {
+        for (size_t t = 0; t < territories.size(); ++t) {
+            const auto& zones = territories[t].zones;
+            if (!zones.empty() && zone >= zones.data() && zone < zones.data() + zones.size()) {
+                return { static_cast<uint32_t>(t), static_cast<uint32_t>(zone - zones.data()) };
+            }
+        }
+        return ZoneRef();
+    }
 };
 
@@ -0,0 +1,356 @@
+#include "TerritoryDiff.h"
+#include "KdTree.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Positions closer than this are considered unchanged (float round trip through XML)
+static const float POSITION_EPSILON = 0.01f;
+
+static std::vector<ZoneRef> FlattenZones(const TerritoryData& data) {
+    std::vector<ZoneRef> refs;
+    refs.reserve(data.getTotalZoneCount());
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        for (uint32_t z = 0; z < data.territories[t].zones.size(); ++z) {
+            refs.push_back({ t, z });
+        }
+    }
+    return refs;
+}
+
+static float ZoneDistance(const Zone& a, const Zone& b) {
+    float dx = a.x - b.x;
+    float dz = a.z - b.z;
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+bool TerritoryDiff::SameParams(const Zone& a, const Zone& b) {
+    return a.smin == b.smin && a.smax == b.smax && a.dmin == b.dmin && a.dmax == b.dmax &&
+           a.r == b.r && a.h == b.h;
+}
+
+bool TerritoryDiff::SamePosition(const Zone& a, const Zone& b) {
+    return ZoneDistance(a, b) <= POSITION_EPSILON;
+}
+
+std::vector<ZoneRef> TerritoryDiff::MatchZones(const TerritoryData& oldData, const TerritoryData& newData,
+                                               float tolerance, std::vector<ZoneRef>& unmatchedNew) {
+    std::vector<ZoneRef> oldRefs = FlattenZones(oldData);
+    std::vector<ZoneRef> newRefs = FlattenZones(newData);
+    
+    // Pair territories by name, and repeated names (herds) by occurrence: the second "Wolf"
+    // of one file pairs with the second "Wolf" of the other. Zones are only matched within a
+    // pair, so a zone moved to another territory of the same name is removed and added.
+    std::unordered_map<NameId, std::vector<uint32_t>> newByName;
+    for (uint32_t t = 0; t < newData.territories.size(); ++t) {
+        newByName[newData.territories[t].name].push_back(t);
+    }
+    std::unordered_map<NameId, size_t> oldOccurrence;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (uint32_t t = 0; t < oldData.territories.size(); ++t) {
+        size_t occurrence = oldOccurrence[oldData.territories[t].name]++;
+        auto it = newByName.find(oldData.territories[t].name);
+        if (it != newByName.end() && occurrence < it->second.size()) {
+            pairs.push_back({ t, it->second[occurrence] });
+        }
+    }
+    
+    // Flat index of each territory's first zone; FlattenZones keeps a territory's zones together
+    auto territoryStarts = [](const TerritoryData& data) {
+        std::vector<uint32_t> starts(data.territories.size() + 1, 0);
+        for (size_t t = 0; t < data.territories.size(); ++t) {
+            starts[t + 1] = starts[t] + static_cast<uint32_t>(data.territories[t].zones.size());
+        }
+        return starts;
+    };
+    std::vector<uint32_t> oldStart = territoryStarts(oldData);
+    std::vector<uint32_t> newStart = territoryStarts(newData);
+    
+    std::vector<ZoneRef> matches(oldRefs.size());
+    std::vector<bool> newUsed(newRefs.size(), false);
+    auto accept = [&](uint32_t id) { return !newUsed[id]; };
+    
+    KdTree tree;
+    std::vector<KdTree::Point> points;
+    for (const auto& pair : pairs) {
+        uint32_t oldBegin = oldStart[pair.first];
+        uint32_t oldEnd = oldStart[pair.first + 1];
+        uint32_t newBegin = newStart[pair.second];
+        uint32_t newEnd = newStart[pair.second + 1];
+        if (oldBegin == oldEnd || newBegin == newEnd) continue;
+        
+        points.clear();
+        points.reserve(newEnd - newBegin);
+        for (uint32_t i = newBegin; i < newEnd; ++i) {
+            const Zone* zone = newData.getZone(newRefs[i]);
+            points.push_back({ zone->x, zone->z, i });
+        }
+        tree.Build(std::move(points));
+        points = std::vector<KdTree::Point>();
+        
+        // Exact positions first so a moved zone can't steal an untouched neighbour's match
+        std::vector<uint32_t> pending;
+        KdTree::Hit hit;
+        for (uint32_t i = oldBegin; i < oldEnd; ++i) {
+            const Zone* zone = oldData.getZone(oldRefs[i]);
+            if (tree.Nearest(zone->x, zone->z, POSITION_EPSILON, accept, hit)) {
+                newUsed[hit.id] = true;
+                matches[i] = newRefs[hit.id];
+            } else {
+                pending.push_back(i);
+            }
+        }
+        
+        for (uint32_t i : pending) {
+            const Zone* zone = oldData.getZone(oldRefs[i]);
+            if (tree.Nearest(zone->x, zone->z, tolerance, accept, hit)) {
+                newUsed[hit.id] = true;
+                matches[i] = newRefs[hit.id];
+            }
+        }
+    }
+    
+    unmatchedNew.clear();
+    for (uint32_t i = 0; i < newRefs.size(); ++i) {
+        if (!newUsed[i]) {
+            unmatchedNew.push_back(newRefs[i]);
+        }
+    }
+    
+    return matches;
+}
+
+TerritoryDiffResult TerritoryDiff::Compare(const TerritoryData& oldData, const TerritoryData& newData, float tolerance) {
+    TerritoryDiffResult result;
+    
+    std::vector<ZoneRef> added;
+    std::vector<ZoneRef> matches = MatchZones(oldData, newData, tolerance, added);
+    std::vector<ZoneRef> oldRefs = FlattenZones(oldData);
+    
+    for (size_t i = 0; i < oldRefs.size(); ++i) {
+        ZoneDiffEntry entry;
+        entry.oldRef = oldRefs[i];
+        entry.newRef = matches[i];
+        
+        if (!entry.newRef.valid()) {
+            entry.flags = ZoneChange_Removed;
+            result.removedCount++;
+            result.entries.push_back(entry);
+            continue;
+        }
+        
+        const Zone& oldZone = *oldData.getZone(entry.oldRef);
+        const Zone& newZone = *newData.getZone(entry.newRef);
+        entry.distance = ZoneDistance(oldZone, newZone);
+        if (entry.distance > POSITION_EPSILON) {
+            entry.flags |= ZoneChange_Moved;
+            result.movedCount++;
+        }
+        if (!SameParams(oldZone, newZone)) {
+            entry.flags |= ZoneChange_Params;
+            result.changedCount++;
+        }
+        
+        if (entry.flags == ZoneChange_None) {
+            result.unchangedCount++;
+        } else {
+            result.entries.push_back(entry);
+        }
+    }
+    
+    for (const ZoneRef& ref : added) {
+        ZoneDiffEntry entry;
+        entry.flags = ZoneChange_Added;
+        entry.newRef = ref;
+        result.entries.push_back(entry);
+    }
+    result.addedCount = added.size();
+    
+    return result;
+}
+
+TerritoryMergeResult TerritoryDiff::Merge(const TerritoryData& base, const TerritoryData& ours,
+                                          const TerritoryData& theirs, float tolerance) {
+    TerritoryMergeResult result;
+    result.merged = ours;
+    TerritoryData& merged = result.merged;
+    
+    std::vector<ZoneRef> oursAdded;
+    std::vector<ZoneRef> theirsAdded;
+    std::vector<ZoneRef> toOurs = MatchZones(base, ours, tolerance, oursAdded);
+    std::vector<ZoneRef> toTheirs = MatchZones(base, theirs, tolerance, theirsAdded);
+    std::vector<ZoneRef> baseRefs = FlattenZones(base);
+    
+    auto changedFromBase = [](const Zone& baseZone, const Zone* zone) {
+        return !zone || !SamePosition(baseZone, *zone) || !SameParams(baseZone, *zone);
+    };
+    
+    // Zones removed from the merge result, per territory
+    std::vector<std::vector<bool>> removed(merged.territories.size());
+    for (size_t t = 0; t < merged.territories.size(); ++t) {
+        removed[t].assign(merged.territories[t].zones.size(), false);
+    }
+    
+    // Where each of their territories lands in the merged document
+    std::vector<uint32_t> theirsTerritoryTarget(theirs.territories.size(), UINT32_MAX);
+    
+    for (size_t i = 0; i < baseRefs.size(); ++i) {
+        const Zone& baseZone = *base.getZone(baseRefs[i]);
+        const Zone* ourZone = ours.getZone(toOurs[i]);
+        const Zone* theirZone = theirs.getZone(toTheirs[i]);
+        
+        if (ourZone && theirZone && theirsTerritoryTarget[toTheirs[i].territory] == UINT32_MAX) {
+            theirsTerritoryTarget[toTheirs[i].territory] = toOurs[i].territory;
+        }
+        
+        bool oursChanged = changedFromBase(baseZone, ourZone);
+        bool theirsChanged = changedFromBase(baseZone, theirZone);
+        if (!theirsChanged) {
+            continue;
+        }
+        
+        NameId territoryName = base.territories[baseRefs[i].territory].name;
+        
+        if (!oursChanged) {
+            if (!ourZone) continue;
+            if (theirZone) {
+                Zone& target = merged.territories[toOurs[i].territory].zones[toOurs[i].zone];
+                target.smin = theirZone->smin;
+                target.smax = theirZone->smax;
+                target.dmin = theirZone->dmin;
+                target.dmax = theirZone->dmax;
+                target.x = theirZone->x;
+                target.z = theirZone->z;
+                target.r = theirZone->r;
+                target.h = theirZone->h;
+            } else {
+                removed[toOurs[i].territory][toOurs[i].zone] = true;
+            }
+            result.appliedFromTheirs++;
+            continue;
+        }
+        
+        // Changed on both sides: fine if both made the same change
+        if (!ourZone && !theirZone) continue;
+        if (ourZone && theirZone && SamePosition(*ourZone, *theirZone) && SameParams(*ourZone, *theirZone)) continue;
+        
+        MergeConflict conflict;
+        conflict.territoryName = NameTable::Resolve(territoryName);
+        conflict.x = ourZone ? ourZone->x : theirZone->x;
+        conflict.z = ourZone ? ourZone->z : theirZone->z;
+        if (!ourZone) {
+            conflict.description = "removed in ours, changed in theirs";
+        } else if (!theirZone) {
+            conflict.description = "changed in ours, removed in theirs";
+        } else {
+            conflict.description = "changed differently on both sides";
+        }
+        result.conflicts.push_back(conflict);
+    }
+    
+    // Their additions. Skip zones we added identically ourselves.
+    KdTree oursAddedTree;
+    std::vector<KdTree::Point> points;
+    points.reserve(oursAdded.size());
+    for (uint32_t i = 0; i < oursAdded.size(); ++i) {
+        const Zone* zone = ours.getZone(oursAdded[i]);
+        points.push_back({ zone->x, zone->z, i });
+    }
+    oursAddedTree.Build(std::move(points));
+    
+    for (const ZoneRef& ref : theirsAdded) {
+        const Zone& zone = *theirs.getZone(ref);
+        const Territory& theirTerritory = theirs.territories[ref.territory];
+        
+        bool duplicate = false;
+        oursAddedTree.QueryRadius(zone.x, zone.z, POSITION_EPSILON, [&](uint32_t id, float) {
+            const ZoneRef& ourRef = oursAdded[id];
+            if (ours.territories[ourRef.territory].name == theirTerritory.name &&
+                SameParams(*ours.getZone(ourRef), zone)) {
+                duplicate = true;
+            }
+        });
+        if (duplicate) continue;
+        
+        // New territories (herds) from their side stay separate territories
+        uint32_t& target = theirsTerritoryTarget[ref.territory];
+        if (target == UINT32_MAX) {
+            Territory territory = theirTerritory;
+            territory.zones.clear();
+            merged.territories.push_back(territory);
+            removed.emplace_back();
+            target = static_cast<uint32_t>(merged.territories.size() - 1);
+        }
+        
+        Zone newZone = zone;
+        newZone.selected = false;
+        merged.territories[target].zones.push_back(newZone);
+        removed[target].push_back(false);
+        result.appliedFromTheirs++;
+    }
+    
+    // Apply removals and drop emptied territories
+    size_t writeTerritory = 0;
+    for (size_t t = 0; t < merged.territories.size(); ++t) {
+        Territory& territory = merged.territories[t];
+        size_t writeZone = 0;
+        for (size_t z = 0; z < territory.zones.size(); ++z) {
+            if (!removed[t][z]) {
+                territory.zones[writeZone++] = std::move(territory.zones[z]);
+            }
+        }
+        territory.zones.resize(writeZone);
+        
+        if (!territory.zones.empty()) {
+            if (writeTerritory != t) {
+                merged.territories[writeTerritory] = std::move(territory);
+            }
+            writeTerritory++;
+        }
+    }
+    merged.territories.resize(writeTerritory);
+    
+    return result;
+}
+
+std::string TerritoryDiff::FormatEntry(const ZoneDiffEntry& entry, const TerritoryData& oldData,
+                                       const TerritoryData& newData) {
+    const Zone* oldZone = oldData.getZone(entry.oldRef);
+    const Zone* newZone = newData.getZone(entry.newRef);
+    const std::string& name = NameTable::Resolve(oldZone ? oldData.territories[entry.oldRef.territory].name
+                                                         : newData.territories[entry.newRef.territory].name);
+    char buffer[512];
+    
+    if (entry.flags & ZoneChange_Added) {
+        snprintf(buffer, sizeof(buffer), "+ %s (%.1f, %.1f) r=%.1f", name.c_str(), newZone->x, newZone->z, newZone->r);
+        return buffer;
+    }
+    if (entry.flags & ZoneChange_Removed) {
+        snprintf(buffer, sizeof(buffer), "- %s (%.1f, %.1f) r=%.1f", name.c_str(), oldZone->x, oldZone->z, oldZone->r);
+        return buffer;
+    }
+    
+    std::string text = "~ " + name;
+    snprintf(buffer, sizeof(buffer), " (%.1f, %.1f)", oldZone->x, oldZone->z);
+    text += buffer;
+    if (entry.flags & ZoneChange_Moved) {
+        snprintf(buffer, sizeof(buffer), " moved %.1fm to (%.1f, %.1f)", entry.distance, newZone->x, newZone->z);
+        text += buffer;
+    }
+    if (entry.flags & ZoneChange_Params) {
+        auto field = [&](const char* label, float before, float after) {
+            if (before != after) {
+                snprintf(buffer, sizeof(buffer), " %s %g->%g", label, before, after);
+                text += buffer;
+            }
+        };
+        field("smin", static_cast<float>(oldZone->smin), static_cast<float>(newZone->smin));
+        field("smax", static_cast<float>(oldZone->smax), static_cast<float>(newZone->smax));
+        field("dmin", static_cast<float>(oldZone->dmin), static_cast<float>(newZone->dmin));
+        field("dmax", static_cast<float>(oldZone->dmax), static_cast<float>(newZone->dmax));
+        field("r", oldZone->r, newZone->r);
+        field("h", oldZone->h, newZone->h);
+    }
+    return text;
+}
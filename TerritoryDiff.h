@@ -0,0 +1,77 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Change flags for a zone in a diff. A matched zone can be both moved and changed.
+enum ZoneChangeFlags : uint8_t {
+    ZoneChange_None    = 0,
+    ZoneChange_Added   = 1 << 0,
+    ZoneChange_Removed = 1 << 1,
+    ZoneChange_Moved   = 1 << 2,
+    ZoneChange_Params  = 1 << 3,  // smin/smax/dmin/dmax/r/h changed
+};
+
+struct ZoneDiffEntry {
+    uint8_t flags = ZoneChange_None;
+    ZoneRef oldRef;     // Invalid for added zones
+    ZoneRef newRef;     // Invalid for removed zones
+    float distance = 0.0f;
+};
+
+struct TerritoryDiffResult {
+    std::vector<ZoneDiffEntry> entries;  // Changed zones only
+    size_t unchangedCount = 0;
+    size_t addedCount = 0;
+    size_t removedCount = 0;
+    size_t movedCount = 0;
+    size_t changedCount = 0;
+    
+    bool empty() const { return entries.empty(); }
+};
+
+struct MergeConflict {
+    std::string territoryName;
+    float x = 0.0f;     // Position of the conflicting zone (ours if present)
+    float z = 0.0f;
+    std::string description;
+};
+
+struct TerritoryMergeResult {
+    TerritoryData merged;
+    std::vector<MergeConflict> conflicts;
+    size_t appliedFromTheirs = 0;
+};
+
+// Semantic comparison of territory files. Territories are paired by name, and by
+// occurrence where a name repeats; zones are matched within each pair by nearest
+// position (k-d tree, exact positions first, then within the distance tolerance),
+// so reordering zones does not show up as a change. A zone moved to another
+// territory shows up as removed from one and added to the other.
+class TerritoryDiff {
+public:
+    static constexpr float DEFAULT_TOLERANCE = 25.0f;  // World units
+    
+    static TerritoryDiffResult Compare(const TerritoryData& oldData, const TerritoryData& newData,
+                                       float tolerance = DEFAULT_TOLERANCE);
+    
+    // Three-way merge: ours is the base of the result, with changes made in theirs
+    // (relative to base) applied on top. Zones changed differently on both sides
+    // keep our version and are reported as conflicts.
+    static TerritoryMergeResult Merge(const TerritoryData& base, const TerritoryData& ours,
+                                      const TerritoryData& theirs, float tolerance = DEFAULT_TOLERANCE);
+    
+    // One-line human readable description, used by the diff panel and --diff
+    static std::string FormatEntry(const ZoneDiffEntry& entry, const TerritoryData& oldData,
+                                   const TerritoryData& newData);
+    
+    static bool SameParams(const Zone& a, const Zone& b);
+    static bool SamePosition(const Zone& a, const Zone& b);
+    
+    // For every zone of oldData (flattened in file order), the matching zone in newData
+    // (invalid if none); newData zones nobody matched go to unmatchedNew
+    static std::vector<ZoneRef> MatchZones(const TerritoryData& oldData, const TerritoryData& newData,
+                                           float tolerance, std::vector<ZoneRef>& unmatchedNew);
+};
@@ -5,24 +5,78 @@
 
 using namespace tinyxml2;
 
-bool TerritoryParser::LoadFromFile(const std::string& filepath, TerritoryData& data) {
+void LoadProgress::Publish(const Territory& territory) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_.push_back(territory);
+}
+
+void LoadProgress::TakeFinished(TerritoryData& data) {
+    std::vector<Territory> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished.swap(finished_);
+    }
+    for (const auto& territory : finished) {
+        data.territories.push_back(territory);
+    }
+}
+
+bool TerritoryParser::LoadFromFile(const std::string& filepath, TerritoryData& data, LoadProgress* progress) {
     data.clear();
     
     XMLDocument doc;
     if (doc.LoadFile(filepath.c_str()) != XML_SUCCESS) {
         return false;
     }
+    return LoadFromDocument(doc, data, progress);
+}
+
+bool TerritoryParser::LoadFromString(const std::string& xml, TerritoryData& data) {
+    data.clear();
     
+    XMLDocument doc;
+    if (doc.Parse(xml.c_str(), xml.size()) == XML_SUCCESS && doc.FirstChildElement("territory-type")) {
+        return LoadFromDocument(doc, data, nullptr);
+    }
+    
+    // A snippet: wrap it in the elements it is missing
+    std::string wrapped;
+    if (xml.find("<territory") != std::string::npos) {
+        wrapped = "<territory-type>" + xml + "</territory-type>";
+    } else {
+        wrapped = "<territory-type><territory>" + xml + "</territory></territory-type>";
+    }
+    if (doc.Parse(wrapped.c_str(), wrapped.size()) != XML_SUCCESS) {
+        return false;
+    }
+    return LoadFromDocument(doc, data, nullptr);
+}
+
+bool TerritoryParser::LoadFromDocument(XMLDocument& doc, TerritoryData& data, LoadProgress* progress) {
     XMLElement* root = doc.FirstChildElement("territory-type");
     if (!root) {
         return false;
     }
     
+    if (progress) {
+        if (progress->IsCancelled()) {
+            return false;
+        }
+        size_t territoryCount = 0;
+        for (XMLElement* e = root->FirstChildElement("territory"); e; e = e->NextSiblingElement("territory")) {
+            territoryCount++;
+        }
+        progress->territoryCount_ = territoryCount;
+    }
+    
     XMLElement* territoryElem = root->FirstChildElement("territory");
     int territoryIndex = 0;
+    std::string lastZoneName;
+    NameId lastZoneNameId = 0;
     
     while (territoryElem) {
-        Territory territory;
+        // Build in the document's arena so moving it into the list below doesn't copy zones
+        Territory territory(data.territories.get_allocator());
         
         // Get color attribute
         const char* colorStr = territoryElem->Attribute("color");
@@ -33,16 +87,30 @@ bool TerritoryParser::LoadFromFile(const std::string& filepath, TerritoryData& d
         // Get name attribute if present
         const char* nameStr = territoryElem->Attribute("name");
         if (nameStr) {
-            territory.name = nameStr;
+            territory.name = NameTable::Intern(nameStr);
         }
         
+        // Size the zone list up front so it is allocated once
+        size_t zoneCount = 0;
+        for (XMLElement* e = territoryElem->FirstChildElement("zone"); e; e = e->NextSiblingElement("zone")) {
+            zoneCount++;
+        }
+        territory.zones.reserve(zoneCount);
+        
         // Parse zones
         XMLElement* zoneElem = territoryElem->FirstChildElement("zone");
         while (zoneElem) {
             Zone zone;
             
+            // Zones in a territory almost always repeat the same name, so skip the table lookup for repeats
             const char* name = zoneElem->Attribute("name");
-            if (name) zone.name = name;
+            if (name) {
+                if (lastZoneName != name) {
+                    lastZoneName = name;
+                    lastZoneNameId = NameTable::Intern(lastZoneName);
+                }
+                zone.name = lastZoneNameId;
+            }
             
             zoneElem->QueryIntAttribute("smin", &zone.smin);
             zoneElem->QueryIntAttribute("smax", &zone.smax);
@@ -59,23 +127,33 @@ bool TerritoryParser::LoadFromFile(const std::string& filepath, TerritoryData& d
         
         if (!territory.zones.empty()) {
             // If no name was set, use the name from the first zone
-            if (territory.name.empty() && !territory.zones[0].name.empty()) {
+            if (territory.name == 0 && territory.zones[0].name != 0) {
                 territory.name = territory.zones[0].name;
-            } else if (territory.name.empty()) {
-                territory.name = "Territory " + std::to_string(territoryIndex);
+            } else if (territory.name == 0) {
+                territory.name = NameTable::Intern("Territory " + std::to_string(territoryIndex));
             }
-            data.territories.push_back(territory);
+            if (progress) {
+                progress->Publish(territory);
+                progress->zonesDone_ += territory.zones.size();
+            }
+            data.territories.push_back(std::move(territory));
         }
         
         territoryElem = territoryElem->NextSiblingElement("territory");
         territoryIndex++;
+        
+        if (progress) {
+            progress->territoriesDone_++;
+            if (progress->IsCancelled()) {
+                return false;
+            }
+        }
     }
     
     return true;
 }
 
-bool TerritoryParser::SaveToFile(const std::string& filepath, const TerritoryData& data) {
-    XMLDocument doc;
+static void BuildDocument(XMLDocument& doc, const TerritoryData& data) {
     doc.InsertFirstChild(doc.NewDeclaration());
     
     XMLElement* root = doc.NewElement("territory-type");
@@ -85,13 +163,13 @@ bool TerritoryParser::SaveToFile(const std::string& filepath, const TerritoryDat
         XMLElement* territoryElem = doc.NewElement("territory");
         territoryElem->SetAttribute("color", static_cast<int64_t>(territory.color));
         
-        if (!territory.name.empty()) {
-            territoryElem->SetAttribute("name", territory.name.c_str());
+        if (territory.name != 0) {
+            territoryElem->SetAttribute("name", NameTable::CStr(territory.name));
         }
         
         for (const auto& zone : territory.zones) {
             XMLElement* zoneElem = doc.NewElement("zone");
-            zoneElem->SetAttribute("name", zone.name.c_str());
+            zoneElem->SetAttribute("name", NameTable::CStr(zone.name));
             zoneElem->SetAttribute("smin", zone.smin);
             zoneElem->SetAttribute("smax", zone.smax);
             zoneElem->SetAttribute("dmin", zone.dmin);
@@ -108,13 +186,25 @@ bool TerritoryParser::SaveToFile(const std::string& filepath, const TerritoryDat
         
         root->InsertEndChild(territoryElem);
     }
-    
+}
+
+bool TerritoryParser::SaveToFile(const std::string& filepath, const TerritoryData& data) {
+    XMLDocument doc;
+    BuildDocument(doc, data);
     return doc.SaveFile(filepath.c_str()) == XML_SUCCESS;
 }
 
+std::string TerritoryParser::SaveToString(const TerritoryData& data) {
+    XMLDocument doc;
+    BuildDocument(doc, data);
+    XMLPrinter printer;
+    doc.Print(&printer);
+    return std::string(printer.CStr(), printer.CStrSize() > 0 ? printer.CStrSize() - 1 : 0);
+}
+
 std::string TerritoryParser::ExtractTerritoryName(const Territory& territory) {
     if (!territory.zones.empty()) {
-        return territory.zones[0].name;
+        return NameTable::Resolve(territory.zones[0].name);
     }
     return "Unknown";
 }
@@ -2,13 +2,56 @@
 
 #include "TerritoryData.h"
 #include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+namespace tinyxml2 {
+class XMLDocument;
+}
+
+// Shared between a background LoadFromFile and the UI thread. Each territory is
+// published as soon as it is parsed, so the UI can show the partial document,
+// and the parser stops at the next territory once Cancel() is called.
+class LoadProgress {
+public:
+    void Cancel() { cancelled_ = true; }
+    bool IsCancelled() const { return cancelled_; }
+    
+    size_t GetTerritoriesDone() const { return territoriesDone_; }
+    size_t GetTerritoryCount() const { return territoryCount_; }  // 0 while the file is still being read
+    size_t GetZonesDone() const { return zonesDone_; }
+    
+    // Appends the territories published since the last call to data (UI thread)
+    void TakeFinished(TerritoryData& data);
+    
+private:
+    friend class TerritoryParser;
+    
+    void Publish(const Territory& territory);
+    
+    std::atomic<bool> cancelled_{ false };
+    std::atomic<size_t> territoriesDone_{ 0 };
+    std::atomic<size_t> territoryCount_{ 0 };
+    std::atomic<size_t> zonesDone_{ 0 };
+    std::mutex mutex_;
+    std::vector<Territory> finished_;
+};
 
 class TerritoryParser {
 public:
-    static bool LoadFromFile(const std::string& filepath, TerritoryData& data);
+    // Replaces data with the file's contents. With progress, reports each finished territory
+    // and returns false early if cancelled.
+    static bool LoadFromFile(const std::string& filepath, TerritoryData& data, LoadProgress* progress = nullptr);
     static bool SaveToFile(const std::string& filepath, const TerritoryData& data);
     
+    // Same format as the files. Text without a <territory-type> root is read as a list of
+    // <territory> elements, or as the zones of a single territory (a snippet copied from a file).
+    static bool LoadFromString(const std::string& xml, TerritoryData& data);
+    static std::string SaveToString(const TerritoryData& data);
+    
 private:
+    static bool LoadFromDocument(tinyxml2::XMLDocument& doc, TerritoryData& data, LoadProgress* progress);
     static std::string ExtractTerritoryName(const Territory& territory);
 };
 
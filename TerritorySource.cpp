@@ -0,0 +1,476 @@
+#include "TerritorySource.h"
+#include "TerritoryParser.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+    
+    std::string FormatFloat(float value) {
+        // Shortest text that reads back as the same float
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return std::string(buffer, result.ptr);
+    }
+    
+    std::string EscapeAttribute(const std::string& text) {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text) {
+            switch (c) {
+                case '&': escaped += "&amp;"; break;
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                case '"': escaped += "&quot;"; break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+    
+    struct AttributeValue {
+        std::string name;
+        size_t valueBegin = 0;  // Offsets into the tag text, excluding quotes
+        size_t valueEnd = 0;
+    };
+    
+    // Attributes of the start tag at the beginning of tag; tagEnd receives the offset of its '>'
+    std::vector<AttributeValue> ParseAttributes(const std::string& tag, size_t& tagEnd) {
+        std::vector<AttributeValue> attributes;
+        size_t i = 1;
+        while (i < tag.size() && !IsSpace(tag[i]) && tag[i] != '>' && tag[i] != '/') ++i;  // Element name
+        tagEnd = tag.size();
+        while (i < tag.size()) {
+            if (tag[i] == '>') {
+                tagEnd = i;
+                break;
+            }
+            if (IsSpace(tag[i]) || tag[i] == '/') {
+                ++i;
+                continue;
+            }
+            size_t nameBegin = i;
+            while (i < tag.size() && tag[i] != '=' && !IsSpace(tag[i]) && tag[i] != '>') ++i;
+            AttributeValue attribute;
+            attribute.name = tag.substr(nameBegin, i - nameBegin);
+            while (i < tag.size() && tag[i] != '"' && tag[i] != '\'' && tag[i] != '>') ++i;
+            if (i >= tag.size() || tag[i] == '>') continue;
+            char quote = tag[i];
+            attribute.valueBegin = ++i;
+            while (i < tag.size() && tag[i] != quote) ++i;
+            attribute.valueEnd = i;
+            ++i;
+            attributes.push_back(std::move(attribute));
+        }
+        return attributes;
+    }
+    
+    // Rewrites or appends attribute values in a start tag; changes are (name, new value) pairs
+    std::string PatchAttributes(const std::string& tag, const std::vector<std::pair<const char*, std::string>>& changes) {
+        size_t tagEnd = 0;
+        std::vector<AttributeValue> attributes = ParseAttributes(tag, tagEnd);
+        
+        std::vector<std::pair<size_t, std::pair<size_t, std::string>>> replacements;  // begin -> (end, text)
+        std::string appended;
+        for (const auto& change : changes) {
+            auto it = std::find_if(attributes.begin(), attributes.end(), [&change](const AttributeValue& a) {
+                return a.name == change.first;
+            });
+            if (it != attributes.end()) {
+                replacements.push_back({ it->valueBegin, { it->valueEnd, change.second } });
+            } else {
+                appended += std::string(" ") + change.first + "=\"" + change.second + "\"";
+            }
+        }
+        std::sort(replacements.begin(), replacements.end());
+        
+        // New attributes go before "/>" or ">"
+        size_t insertAt = tagEnd;
+        if (insertAt > 0 && tag[insertAt - 1] == '/') {
+            insertAt--;
+        }
+        
+        std::string patched;
+        size_t cursor = 0;
+        for (const auto& replacement : replacements) {
+            patched.append(tag, cursor, replacement.first - cursor);
+            patched += replacement.second.second;
+            cursor = replacement.second.first;
+        }
+        patched.append(tag, cursor, insertAt - cursor);
+        patched += appended;
+        patched.append(tag, insertAt, std::string::npos);
+        return patched;
+    }
+    
+    bool SameFileData(const Zone& a, const Zone& b) {
+        return a.name == b.name && a.smin == b.smin && a.smax == b.smax && a.dmin == b.dmin &&
+               a.dmax == b.dmax && a.x == b.x && a.z == b.z && a.r == b.r && a.h == b.h;
+    }
+}
+
+bool TerritorySource::Attach(const std::string& filepath, TerritoryData& data) {
+    Detach();
+    
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    
+    path_ = filepath;
+    return AttachText(contents.str(), data);
+}
+
+void TerritorySource::Detach() {
+    attached_ = false;
+    text_.clear();
+    territories_.clear();
+    zones_.clear();
+}
+
+size_t TerritorySource::GetMemoryUsage() const {
+    size_t bytes = text_.capacity() + territories_.capacity() * sizeof(SourceTerritory) + zones_.capacity() * sizeof(SourceZone);
+    for (const SourceTerritory& territory : territories_) {
+        bytes += territory.zones.capacity() * sizeof(Span);
+    }
+    return bytes;
+}
+
+bool TerritorySource::AttachText(std::string text, TerritoryData& data) {
+    text_ = std::move(text);
+    newline_ = text_.find("\r\n") != std::string::npos ? "\r\n" : "\n";
+    if (!Scan(text_)) {
+        Detach();
+        return false;
+    }
+    
+    // Pair document territories with the file's non-empty territory elements, in order, like the
+    // parser does; the document must be exactly what was read (empty territories never load)
+    size_t next = 0;
+    for (auto& territory : data.territories) {
+        territory.sourceId = UINT32_MAX;
+        if (territory.zones.empty()) continue;
+        while (next < territories_.size() && territories_[next].zones.empty()) ++next;
+        if (next == territories_.size() || territories_[next].zones.size() != territory.zones.size()) {
+            Detach();
+            return false;
+        }
+        territory.sourceId = static_cast<uint32_t>(next++);
+    }
+    while (next < territories_.size() && territories_[next].zones.empty()) ++next;
+    if (next != territories_.size()) {
+        Detach();
+        return false;
+    }
+    
+    zones_.clear();
+    for (auto& territory : data.territories) {
+        if (territory.sourceId == UINT32_MAX) continue;
+        SourceTerritory& source = territories_[territory.sourceId];
+        source.inDocument = true;
+        source.name = territory.name;
+        source.color = territory.color;
+        source.firstZone = static_cast<uint32_t>(zones_.size());
+        for (size_t z = 0; z < territory.zones.size(); ++z) {
+            SourceZone zone;
+            zone.element = source.zones[z];
+            zone.territory = territory.sourceId;
+            zone.values = territory.zones[z];
+            territory.zones[z].sourceId = static_cast<uint32_t>(zones_.size());
+            zones_.push_back(zone);
+        }
+    }
+    
+    attached_ = true;
+    return true;
+}
+
+bool TerritorySource::Scan(const std::string& text) {
+    territories_.clear();
+    rootStartTagEnd_ = 0;
+    
+    // Element names from the root down; only <territory-type> > <territory> > <zone> is recorded
+    std::vector<std::string> stack;
+    bool inRoot = false;
+    size_t zoneBegin = 0;
+    size_t i = 0;
+    while ((i = text.find('<', i)) != std::string::npos) {
+        if (text.compare(i, 4, "<!--") == 0) {
+            size_t end = text.find("-->", i + 4);
+            if (end == std::string::npos) return false;
+            i = end + 3;
+            continue;
+        }
+        if (text.compare(i, 9, "<![CDATA[") == 0) {
+            size_t end = text.find("]]>", i + 9);
+            if (end == std::string::npos) return false;
+            i = end + 3;
+            continue;
+        }
+        if (text.compare(i, 2, "<?") == 0 || text.compare(i, 2, "<!") == 0) {
+            size_t end = text.find('>', i + 2);
+            if (end == std::string::npos) return false;
+            i = end + 1;
+            continue;
+        }
+        
+        bool closing = i + 1 < text.size() && text[i + 1] == '/';
+        size_t nameBegin = i + (closing ? 2 : 1);
+        size_t nameEnd = nameBegin;
+        while (nameEnd < text.size() && !IsSpace(text[nameEnd]) && text[nameEnd] != '>' && text[nameEnd] != '/') ++nameEnd;
+        std::string name = text.substr(nameBegin, nameEnd - nameBegin);
+        
+        // Find the end of the tag, skipping quoted attribute values
+        size_t end = nameEnd;
+        char quote = 0;
+        while (end < text.size() && (quote || text[end] != '>')) {
+            if (quote) {
+                if (text[end] == quote) quote = 0;
+            } else if (text[end] == '"' || text[end] == '\'') {
+                quote = text[end];
+            }
+            ++end;
+        }
+        if (end >= text.size()) return false;
+        bool selfClosing = !closing && text[end - 1] == '/';
+        size_t tagEnd = end + 1;
+        
+        if (closing) {
+            if (stack.empty() || stack.back() != name) return false;
+            stack.pop_back();
+            if (inRoot && stack.size() == 1 && name == "territory") {
+                SourceTerritory& territory = territories_.back();
+                territory.closeTag = i;
+                territory.element.end = tagEnd;
+            } else if (inRoot && stack.size() == 2 && stack[1] == "territory" && name == "zone") {
+                territories_.back().zones.push_back({ zoneBegin, tagEnd });
+            } else if (inRoot && stack.empty()) {
+                return true;  // Root closed; the rest is ignored like the parser does
+            }
+        } else {
+            if (!inRoot && stack.empty() && name == "territory-type") {
+                inRoot = true;
+                rootStartTagEnd_ = tagEnd;
+                if (selfClosing) return true;
+            } else if (inRoot && stack.size() == 1 && name == "territory") {
+                SourceTerritory territory;
+                territory.element.begin = i;
+                territory.startTagEnd = tagEnd;
+                territory.element.end = tagEnd;
+                territories_.push_back(territory);
+            } else if (inRoot && stack.size() == 2 && stack[1] == "territory" && name == "zone") {
+                if (selfClosing) {
+                    territories_.back().zones.push_back({ i, tagEnd });
+                }
+                zoneBegin = i;
+            }
+            if (!selfClosing) {
+                stack.push_back(name);
+            }
+        }
+        i = tagEnd;
+    }
+    return inRoot && stack.empty();
+}
+
+TerritorySource::Span TerritorySource::LineSpan(const Span& element) const {
+    // Widen to whole lines when the element is alone on its line(s), so removal leaves no blank line
+    size_t begin = element.begin;
+    while (begin > 0 && (text_[begin - 1] == ' ' || text_[begin - 1] == '\t')) --begin;
+    size_t end = element.end;
+    while (end < text_.size() && (text_[end] == ' ' || text_[end] == '\t' || text_[end] == '\r')) ++end;
+    bool lineStart = begin == 0 || text_[begin - 1] == '\n';
+    bool lineEnd = end == text_.size() || text_[end] == '\n';
+    if (lineStart && lineEnd) {
+        return { begin, std::min(end + 1, text_.size()) };
+    }
+    return element;
+}
+
+std::string TerritorySource::IndentBefore(size_t position, const char* fallback) const {
+    size_t begin = position;
+    while (begin > 0 && (text_[begin - 1] == ' ' || text_[begin - 1] == '\t')) --begin;
+    if (begin == 0 || text_[begin - 1] == '\n') {
+        return text_.substr(begin, position - begin);
+    }
+    return fallback;
+}
+
+std::string TerritorySource::FormatZone(const Zone& zone) const {
+    // Same attributes, in the same order, as TerritoryParser::SaveToFile
+    std::string text = "<zone name=\"" + EscapeAttribute(NameTable::Resolve(zone.name)) + "\"";
+    text += " smin=\"" + std::to_string(zone.smin) + "\"";
+    text += " smax=\"" + std::to_string(zone.smax) + "\"";
+    text += " dmin=\"" + std::to_string(zone.dmin) + "\"";
+    text += " dmax=\"" + std::to_string(zone.dmax) + "\"";
+    text += " x=\"" + FormatFloat(zone.x) + "\"";
+    text += " z=\"" + FormatFloat(zone.z) + "\"";
+    text += " r=\"" + FormatFloat(zone.r) + "\"";
+    if (zone.h != 0.0f) {
+        text += " h=\"" + FormatFloat(zone.h) + "\"";
+    }
+    return text + "/>";
+}
+
+std::string TerritorySource::PatchZone(const SourceZone& source, const Zone& zone) const {
+    const Zone& old = source.values;
+    std::vector<std::pair<const char*, std::string>> changes;
+    if (zone.name != old.name) changes.push_back({ "name", EscapeAttribute(NameTable::Resolve(zone.name)) });
+    if (zone.smin != old.smin) changes.push_back({ "smin", std::to_string(zone.smin) });
+    if (zone.smax != old.smax) changes.push_back({ "smax", std::to_string(zone.smax) });
+    if (zone.dmin != old.dmin) changes.push_back({ "dmin", std::to_string(zone.dmin) });
+    if (zone.dmax != old.dmax) changes.push_back({ "dmax", std::to_string(zone.dmax) });
+    if (zone.x != old.x) changes.push_back({ "x", FormatFloat(zone.x) });
+    if (zone.z != old.z) changes.push_back({ "z", FormatFloat(zone.z) });
+    if (zone.r != old.r) changes.push_back({ "r", FormatFloat(zone.r) });
+    if (zone.h != old.h) changes.push_back({ "h", FormatFloat(zone.h) });
+    
+    const Span& span = source.element;
+    return PatchAttributes(text_.substr(span.begin, span.end - span.begin), changes);
+}
+
+std::string TerritorySource::PatchTerritoryTag(const SourceTerritory& source, const Territory& territory) const {
+    std::vector<std::pair<const char*, std::string>> changes;
+    if (territory.color != source.color) changes.push_back({ "color", std::to_string(territory.color) });
+    if (territory.name != source.name) changes.push_back({ "name", EscapeAttribute(NameTable::Resolve(territory.name)) });
+    return PatchAttributes(text_.substr(source.element.begin, source.startTagEnd - source.element.begin), changes);
+}
+
+bool TerritorySource::BuildEdits(TerritoryData& data, std::vector<Edit>& edits, SourceSaveStats& stats) const {
+    std::vector<bool> territoryKept(territories_.size(), false);
+    std::vector<bool> zoneKept(zones_.size(), false);
+    
+    std::string territoryIndent = "    ";
+    std::string zoneIndent = "        ";
+    for (const auto& territory : territories_) {
+        territoryIndent = IndentBefore(territory.element.begin, territoryIndent.c_str());
+        if (!territory.zones.empty()) {
+            zoneIndent = IndentBefore(territory.zones.front().begin, zoneIndent.c_str());
+            break;
+        }
+    }
+    
+    size_t territoryAnchor = rootStartTagEnd_;  // New territories go after the last kept one
+    for (const auto& territory : data.territories) {
+        uint32_t id = territory.sourceId;
+        bool kept = id < territories_.size() && territories_[id].inDocument && !territoryKept[id] &&
+                    territories_[id].closeTag != SIZE_MAX;
+        
+        if (!kept) {
+            // Whole new element; empty territories are dropped on load anyway, so skip them
+            if (territory.zones.empty()) continue;
+            std::string text = newline_ + territoryIndent + "<territory color=\"" + std::to_string(territory.color) + "\"";
+            if (territory.name != 0) {
+                text += " name=\"" + EscapeAttribute(NameTable::Resolve(territory.name)) + "\"";
+            }
+            text += ">";
+            for (const auto& zone : territory.zones) {
+                text += newline_ + zoneIndent + FormatZone(zone);
+            }
+            text += newline_ + territoryIndent + "</territory>";
+            stats.addedZones += territory.zones.size();
+            edits.push_back({ territoryAnchor, territoryAnchor, std::move(text) });
+            continue;
+        }
+        
+        territoryKept[id] = true;
+        const SourceTerritory& source = territories_[id];
+        territoryAnchor = source.element.end;
+        if (territory.name != source.name || territory.color != source.color) {
+            edits.push_back({ source.element.begin, source.startTagEnd, PatchTerritoryTag(source, territory) });
+        }
+        
+        size_t zoneAnchor = source.startTagEnd;  // New zones go after the last kept zone
+        for (const auto& zone : territory.zones) {
+            uint32_t zoneId = zone.sourceId;
+            if (zoneId < zones_.size() && zones_[zoneId].territory == id && !zoneKept[zoneId]) {
+                zoneKept[zoneId] = true;
+                const SourceZone& sourceZone = zones_[zoneId];
+                zoneAnchor = sourceZone.element.end;
+                if (!SameFileData(zone, sourceZone.values)) {
+                    edits.push_back({ sourceZone.element.begin, sourceZone.element.end, PatchZone(sourceZone, zone) });
+                    stats.changedZones++;
+                }
+            } else {
+                edits.push_back({ zoneAnchor, zoneAnchor, newline_ + zoneIndent + FormatZone(zone) });
+                stats.addedZones++;
+            }
+        }
+        
+        for (size_t z = 0; z < source.zones.size(); ++z) {
+            if (!zoneKept[source.firstZone + z]) {
+                edits.push_back({ LineSpan(source.zones[z]).begin, LineSpan(source.zones[z]).end, std::string() });
+                stats.removedZones++;
+            }
+        }
+    }
+    
+    for (size_t id = 0; id < territories_.size(); ++id) {
+        if (territories_[id].inDocument && !territoryKept[id]) {
+            Span line = LineSpan(territories_[id].element);
+            edits.push_back({ line.begin, line.end, std::string() });
+            stats.removedZones += territories_[id].zones.size();
+        }
+    }
+    
+    // Insertions at the same spot keep their order; anything overlapping means the tables are off
+    std::stable_sort(edits.begin(), edits.end(), [](const Edit& a, const Edit& b) { return a.begin < b.begin; });
+    size_t cursor = 0;
+    for (const auto& edit : edits) {
+        if (edit.begin < cursor || edit.end < edit.begin) {
+            return false;
+        }
+        cursor = edit.end;
+        stats.bytesRewritten += edit.text.size();
+    }
+    return true;
+}
+
+bool TerritorySource::Save(const std::string& filepath, TerritoryData& data, SourceSaveStats* stats) {
+    SourceSaveStats localStats;
+    std::vector<Edit> edits;
+    if (!attached_ || !BuildEdits(data, edits, localStats)) {
+        // Regenerate the whole file and start over from what was written
+        localStats = SourceSaveStats();
+        localStats.regenerated = true;
+        if (stats) *stats = localStats;
+        if (!TerritoryParser::SaveToFile(filepath, data)) {
+            Detach();
+            return false;
+        }
+        Attach(filepath, data);
+        return true;
+    }
+    
+    std::string output;
+    output.reserve(text_.size() + localStats.bytesRewritten);
+    size_t cursor = 0;
+    for (const auto& edit : edits) {
+        output.append(text_, cursor, edit.begin - cursor);
+        output += edit.text;
+        cursor = edit.end;
+    }
+    output.append(text_, cursor, std::string::npos);
+    
+    if (!edits.empty() || filepath != path_) {
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        if (!file.write(output.data(), static_cast<std::streamsize>(output.size()))) {
+            return false;
+        }
+    }
+    
+    if (stats) *stats = localStats;
+    path_ = filepath;
+    if (!AttachText(std::move(output), data)) {
+        std::cerr << "Saved file no longer matches the document; formatting will be regenerated on the next save" << std::endl;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct SourceSaveStats {
+    size_t changedZones = 0;
+    size_t addedZones = 0;
+    size_t removedZones = 0;
+    size_t bytesRewritten = 0;  // Bytes of replaced or inserted text
+    bool regenerated = false;   // Fell back to writing the whole file
+};
+
+// The text of the file a document was loaded from, with the position of every
+// territory and zone element in it. Territories and zones carry a sourceId into
+// these tables, so saving copies the original text and patches only changed,
+// added and removed elements: comments, attribute order, number formatting and
+// whitespace survive, and a one-zone edit is a one-line diff.
+class TerritorySource {
+public:
+    // Reads filepath and ties it to data, which must hold what LoadFromFile read from it.
+    // Gives every territory and zone a sourceId; returns false (detached) if they don't line up.
+    bool Attach(const std::string& filepath, TerritoryData& data);
+    void Detach();
+    bool IsAttachedTo(const std::string& filepath) const { return attached_ && filepath == path_; }
+    
+    // Writes data to filepath by patching the original text, then re-attaches to the result.
+    // Falls back to TerritoryParser::SaveToFile if the text can't be patched.
+    bool Save(const std::string& filepath, TerritoryData& data, SourceSaveStats* stats = nullptr);
+    
+    // Bytes held by the file text and the element tables
+    size_t GetMemoryUsage() const;
+
+private:
+    struct Span {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    
+    struct SourceTerritory {
+        Span element;
+        size_t startTagEnd = 0;       // Just past '>' of the start tag
+        size_t closeTag = SIZE_MAX;   // '<' of </territory>; SIZE_MAX if self-closing
+        std::vector<Span> zones;
+        uint32_t firstZone = 0;       // sourceId of zones[0]
+        bool inDocument = false;      // Tied to a document territory; empty ones never are
+        NameId name = 0;
+        uint32_t color = 0;
+    };
+    
+    struct SourceZone {
+        Span element;
+        uint32_t territory = 0;
+        Zone values;                  // As last loaded or saved
+    };
+    
+    struct Edit {
+        size_t begin = 0;
+        size_t end = 0;
+        std::string text;
+    };
+    
+    bool Scan(const std::string& text);
+    bool AttachText(std::string text, TerritoryData& data);
+    bool BuildEdits(TerritoryData& data, std::vector<Edit>& edits, SourceSaveStats& stats) const;
+    
+    Span LineSpan(const Span& element) const;
+    std::string IndentBefore(size_t position, const char* fallback) const;
+    std::string FormatZone(const Zone& zone) const;
+    std::string PatchZone(const SourceZone& source, const Zone& zone) const;
+    std::string PatchTerritoryTag(const SourceTerritory& source, const Territory& territory) const;
+    
+    std::string path_;
+    std::string text_;
+    std::string newline_ = "\n";
+    size_t rootStartTagEnd_ = 0;
+    std::vector<SourceTerritory> territories_;
+    std::vector<SourceZone> zones_;
+    bool attached_ = false;
+};
@@ -0,0 +1,243 @@
+#include "TerritoryStats.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+
+static const int FIELD_COUNT = static_cast<int>(ZoneField::Count);
+
+ZoneValues ZoneValues::FromZone(const Zone& zone) {
+    ZoneValues values;
+    values.value[static_cast<int>(ZoneField::Smin)] = static_cast<float>(zone.smin);
+    values.value[static_cast<int>(ZoneField::Smax)] = static_cast<float>(zone.smax);
+    values.value[static_cast<int>(ZoneField::Dmin)] = static_cast<float>(zone.dmin);
+    values.value[static_cast<int>(ZoneField::Dmax)] = static_cast<float>(zone.dmax);
+    values.value[static_cast<int>(ZoneField::X)] = zone.x;
+    values.value[static_cast<int>(ZoneField::Z)] = zone.z;
+    values.value[static_cast<int>(ZoneField::R)] = zone.r;
+    values.value[static_cast<int>(ZoneField::H)] = zone.h;
+    return values;
+}
+
+void ZoneAggregate::Add(const ZoneValues& values) {
+    float x = values.value[static_cast<int>(ZoneField::X)];
+    float z = values.value[static_cast<int>(ZoneField::Z)];
+    float r = values.value[static_cast<int>(ZoneField::R)];
+    if (count == 0) {
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            min[f] = max[f] = values.value[f];
+        }
+        boundsMinX = x - r;
+        boundsMinZ = z - r;
+        boundsMaxX = x + r;
+        boundsMaxZ = z + r;
+    } else {
+        // fmin/fmax skip NaN, so one broken zone doesn't poison the range
+        for (int f = 0; f < FIELD_COUNT; ++f) {
+            min[f] = std::fmin(min[f], values.value[f]);
+            max[f] = std::fmax(max[f], values.value[f]);
+        }
+        boundsMinX = std::fmin(boundsMinX, x - r);
+        boundsMinZ = std::fmin(boundsMinZ, z - r);
+        boundsMaxX = std::fmax(boundsMaxX, x + r);
+        boundsMaxZ = std::fmax(boundsMaxZ, z + r);
+    }
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        sum[f] += values.value[f];
+    }
+    count++;
+}
+
+void ZoneAggregate::Add(const ZoneAggregate& other) {
+    if (other.count == 0) {
+        return;
+    }
+    if (count == 0) {
+        *this = other;
+        return;
+    }
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        sum[f] += other.sum[f];
+        min[f] = std::fmin(min[f], other.min[f]);
+        max[f] = std::fmax(max[f], other.max[f]);
+    }
+    boundsMinX = std::fmin(boundsMinX, other.boundsMinX);
+    boundsMinZ = std::fmin(boundsMinZ, other.boundsMinZ);
+    boundsMaxX = std::fmax(boundsMaxX, other.boundsMaxX);
+    boundsMaxZ = std::fmax(boundsMaxZ, other.boundsMaxZ);
+    count += other.count;
+}
+
+bool ZoneAggregate::Remove(const ZoneValues& values) {
+    float x = values.value[static_cast<int>(ZoneField::X)];
+    float z = values.value[static_cast<int>(ZoneField::Z)];
+    float r = values.value[static_cast<int>(ZoneField::R)];
+    bool extreme = count <= 1 ||
+                   x - r <= boundsMinX || z - r <= boundsMinZ || x + r >= boundsMaxX || z + r >= boundsMaxZ;
+    for (int f = 0; f < FIELD_COUNT; ++f) {
+        float value = values.value[f];
+        // A NaN was never summed in a way that can be taken back out
+        if (!std::isfinite(value) || value <= min[f] || value >= max[f]) {
+            extreme = true;
+        }
+        sum[f] -= value;
+    }
+    count--;
+    return !extreme;
+}
+
+void TerritoryStats::MarkDirty(ZoneRef ref) {
+    if (ref.valid()) {
+        dirty_.push_back(ref);
+    }
+}
+
+void TerritoryStats::Update(const TerritoryData& data, const std::vector<Zone*>& selection) {
+    // A different layout means zones were added or removed without InvalidateAll
+    bool layoutChanged = territoryStart_.size() != data.territories.size() ||
+                         values_.size() != data.getTotalZoneCount();
+    if (rebuildNeeded_ || layoutChanged) {
+        Rebuild(data);
+    } else if (!dirty_.empty()) {
+        bool totalStale = false;
+        for (const ZoneRef& ref : dirty_) {
+            const Zone* zone = data.getZone(ref);
+            if (!zone) {
+                continue;
+            }
+            ZoneValues& cached = values_[territoryStart_[ref.territory] + ref.zone];
+            ZoneValues current = ZoneValues::FromZone(*zone);
+            ZoneAggregate& territory = territories_[ref.territory];
+            if (current.value[static_cast<int>(ZoneField::Smax)] != cached.value[static_cast<int>(ZoneField::Smax)]) {
+                MarkOrderStale(TerritorySortKey::Smax);
+            }
+            if (current.value[static_cast<int>(ZoneField::X)] != cached.value[static_cast<int>(ZoneField::X)] ||
+                current.value[static_cast<int>(ZoneField::Z)] != cached.value[static_cast<int>(ZoneField::Z)] ||
+                current.value[static_cast<int>(ZoneField::R)] != cached.value[static_cast<int>(ZoneField::R)]) {
+                MarkOrderStale(TerritorySortKey::Area);
+            }
+            if (!territory.Remove(cached)) {
+                staleTerritories_.push_back(ref.territory);
+            }
+            territory.Add(current);
+            if (!total_.Remove(cached)) {
+                totalStale = true;
+            }
+            total_.Add(current);
+            cached = current;
+            if (zone->selected) {
+                selectionDirty_ = true;
+            }
+        }
+        dirty_.clear();
+        
+        // Re-sum what lost an extreme, from the values applied above
+        std::sort(staleTerritories_.begin(), staleTerritories_.end());
+        staleTerritories_.erase(std::unique(staleTerritories_.begin(), staleTerritories_.end()), staleTerritories_.end());
+        for (uint32_t t : staleTerritories_) {
+            RebuildTerritory(t);
+        }
+        staleTerritories_.clear();
+        if (totalStale) {
+            total_.Clear();
+            for (const ZoneAggregate& territory : territories_) {
+                total_.Add(territory);
+            }
+        }
+    }
+    
+    // The selection is small next to the document and changes as a whole, so it's summed again
+    if (selectionDirty_) {
+        selection_.Clear();
+        for (const Zone* zone : selection) {
+            selection_.Add(ZoneValues::FromZone(*zone));
+        }
+        selectionDirty_ = false;
+    }
+}
+
+void TerritoryStats::Rebuild(const TerritoryData& data) {
+    values_.clear();
+    values_.reserve(data.getTotalZoneCount());
+    territoryStart_.clear();
+    territoryStart_.reserve(data.territories.size());
+    territories_.assign(data.territories.size(), ZoneAggregate());
+    territoryNames_.clear();
+    territoryNames_.reserve(data.territories.size());
+    total_.Clear();
+    
+    for (size_t t = 0; t < data.territories.size(); ++t) {
+        territoryStart_.push_back(static_cast<uint32_t>(values_.size()));
+        territoryNames_.push_back(data.territories[t].name);
+        ZoneAggregate& territory = territories_[t];
+        for (const Zone& zone : data.territories[t].zones) {
+            values_.push_back(ZoneValues::FromZone(zone));
+            territory.Add(values_.back());
+        }
+        total_.Add(territory);
+    }
+    
+    dirty_.clear();
+    rebuildNeeded_ = false;
+    selectionDirty_ = true;
+    staleOrders_ = ~0u;
+    orderRevision_++;
+}
+
+void TerritoryStats::RebuildTerritory(size_t territory) {
+    uint32_t begin = territoryStart_[territory];
+    uint32_t end = territory + 1 < territoryStart_.size() ? territoryStart_[territory + 1] : static_cast<uint32_t>(values_.size());
+    ZoneAggregate& aggregate = territories_[territory];
+    aggregate.Clear();
+    for (uint32_t i = begin; i < end; ++i) {
+        aggregate.Add(values_[i]);
+    }
+}
+
+const std::vector<uint32_t>& TerritoryStats::GetOrder(TerritorySortKey key) {
+    std::vector<uint32_t>& order = orders_[static_cast<int>(key)];
+    uint32_t bit = 1u << static_cast<int>(key);
+    if (!(staleOrders_ & bit)) {
+        return order;
+    }
+    
+    order.resize(territories_.size());
+    for (uint32_t t = 0; t < order.size(); ++t) {
+        order[t] = t;
+    }
+    if (key == TerritorySortKey::Name) {
+        std::vector<const std::string*> names(territoryNames_.size());
+        for (size_t t = 0; t < names.size(); ++t) {
+            names[t] = &NameTable::Resolve(territoryNames_[t]);
+        }
+        std::stable_sort(order.begin(), order.end(), [&names](uint32_t a, uint32_t b) { return *names[a] < *names[b]; });
+    } else {
+        // NaN sorts first, so the comparison stays a strict weak order
+        std::vector<double> keys(territories_.size());
+        for (size_t t = 0; t < keys.size(); ++t) {
+            const ZoneAggregate& territory = territories_[t];
+            double value = key == TerritorySortKey::ZoneCount ? static_cast<double>(territory.count) :
+                           key == TerritorySortKey::Smax ? territory.GetSum(ZoneField::Smax) :
+                           territory.GetBoundsArea();
+            keys[t] = std::isnan(value) ? -std::numeric_limits<double>::infinity() : value;
+        }
+        std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    }
+    staleOrders_ &= ~bit;
+    orderRevision_++;
+    return order;
+}
+
+size_t TerritoryStats::GetMemoryUsage() const {
+    size_t bytes = 0;
+    for (const auto& order : orders_) {
+        bytes += order.capacity() * sizeof(uint32_t);
+    }
+    return bytes +
+           values_.capacity() * sizeof(ZoneValues) +
+           territoryStart_.capacity() * sizeof(uint32_t) +
+           territories_.capacity() * sizeof(ZoneAggregate) +
+           dirty_.capacity() * sizeof(ZoneRef) +
+           staleTerritories_.capacity() * sizeof(uint32_t) +
+           territoryNames_.capacity() * sizeof(NameId);
+}
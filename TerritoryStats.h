@@ -0,0 +1,98 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include "ZoneAttributeIndex.h"
+#include <vector>
+#include <cstdint>
+
+// A zone's numeric fields, in ZoneField order
+struct ZoneValues {
+    float value[static_cast<int>(ZoneField::Count)] = {};
+    
+    static ZoneValues FromZone(const Zone& zone);
+};
+
+// Count, sum and min/max of every field over a set of zones, plus the bounding box of
+// their circles. Adding is exact; removing can't restore a min/max, so it reports when
+// the removed zone was an extreme and the aggregate has to be rebuilt.
+struct ZoneAggregate {
+    size_t count = 0;
+    double sum[static_cast<int>(ZoneField::Count)] = {};
+    float min[static_cast<int>(ZoneField::Count)] = {};
+    float max[static_cast<int>(ZoneField::Count)] = {};
+    float boundsMinX = 0.0f;  // Circle extents: x - r .. x + r
+    float boundsMinZ = 0.0f;
+    float boundsMaxX = 0.0f;
+    float boundsMaxZ = 0.0f;
+    
+    void Clear() { *this = ZoneAggregate(); }
+    void Add(const ZoneValues& values);
+    void Add(const ZoneAggregate& other);
+    // Returns false if values held a min/max (or a non-finite value); the aggregate is then stale
+    bool Remove(const ZoneValues& values);
+    
+    bool IsEmpty() const { return count == 0; }
+    double GetSum(ZoneField field) const { return sum[static_cast<int>(field)]; }
+    float GetMin(ZoneField field) const { return min[static_cast<int>(field)]; }
+    float GetMax(ZoneField field) const { return max[static_cast<int>(field)]; }
+    double GetMean(ZoneField field) const { return count > 0 ? sum[static_cast<int>(field)] / count : 0.0; }
+    float GetBoundsArea() const { return count > 0 ? (boundsMaxX - boundsMinX) * (boundsMaxZ - boundsMinZ) : 0.0f; }
+};
+
+// Keys the hierarchy can order territories by
+enum class TerritorySortKey {
+    Name,
+    ZoneCount,
+    Smax,   // Total smax
+    Area,   // Bounding box area
+    Count
+};
+
+// Per-territory, document and selection aggregates, kept up to date from the same
+// notifications as TerritoryValidator: an edited zone moves its old values out of
+// its territory and the total and its new values in, so panels read the stats in
+// O(1) per frame. A territory is only re-summed when an edit removes its min or max.
+// Territory orderings are cached per sort key and only redone once that key changed.
+class TerritoryStats {
+public:
+    // Zone values changed; applied on the next Update
+    void MarkDirty(ZoneRef ref);
+    // Zones were added, removed or replaced wholesale; everything is rebuilt on the next Update
+    void InvalidateAll() { rebuildNeeded_ = true; }
+    // The selection changed, or selected zones moved without MarkDirty (dragging)
+    void MarkSelectionDirty() { selectionDirty_ = true; }
+    
+    void Update(const TerritoryData& data, const std::vector<Zone*>& selection);
+    
+    // Valid after Update; territory indices as in the document
+    const ZoneAggregate& GetTerritory(size_t territory) const { return territories_[territory]; }
+    size_t GetTerritoryCount() const { return territories_.size(); }
+    const ZoneAggregate& GetTotal() const { return total_; }
+    const ZoneAggregate& GetSelection() const { return selection_; }
+    
+    // Territory indices ordered by key, ascending (ties in document order); valid after Update
+    const std::vector<uint32_t>& GetOrder(TerritorySortKey key);
+    // Bumped whenever the layout or one of the cached orders changes
+    uint64_t GetOrderRevision() const { return orderRevision_; }
+    
+    size_t GetMemoryUsage() const;
+
+private:
+    void Rebuild(const TerritoryData& data);
+    void RebuildTerritory(size_t territory);
+    void MarkOrderStale(TerritorySortKey key) { staleOrders_ |= 1u << static_cast<int>(key); }
+    
+    std::vector<ZoneValues> values_;  // Last applied values per zone, flat in document order
+    std::vector<uint32_t> territoryStart_;  // Index of each territory's first zone in values_
+    std::vector<ZoneAggregate> territories_;
+    ZoneAggregate total_;
+    ZoneAggregate selection_;
+    std::vector<ZoneRef> dirty_;
+    std::vector<uint32_t> staleTerritories_;
+    std::vector<NameId> territoryNames_;
+    std::vector<uint32_t> orders_[static_cast<int>(TerritorySortKey::Count)];
+    uint32_t staleOrders_ = ~0u;  // Bit per key whose order has to be redone
+    uint64_t orderRevision_ = 0;
+    bool rebuildNeeded_ = true;
+    bool selectionDirty_ = true;
+};
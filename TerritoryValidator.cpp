@@ -0,0 +1,206 @@
+#include "TerritoryValidator.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+
+static const uint32_t ERROR_RULES = Rule_NonFinite | Rule_SpawnRange | Rule_DespawnRange |
+                                    Rule_NegativeCount | Rule_NegativeRadius | Rule_OutsideWorld;
+
+static int CountBits(uint32_t value) {
+    int count = 0;
+    for (; value; value &= value - 1) {
+        count++;
+    }
+    return count;
+}
+
+void TerritoryValidator::SetWorldSize(float worldSizeX, float worldSizeZ) {
+    if (worldSizeX != worldSizeX_ || worldSizeZ != worldSizeZ_) {
+        worldSizeX_ = worldSizeX;
+        worldSizeZ_ = worldSizeZ;
+        fullPassNeeded_ = true;
+    }
+}
+
+void TerritoryValidator::MarkDirty(ZoneRef ref) {
+    if (ref.valid()) {
+        dirty_.push_back(ref);
+    }
+}
+
+uint32_t TerritoryValidator::CheckZone(const Zone& zone, float worldSizeX, float worldSizeZ) {
+    if (!std::isfinite(zone.x) || !std::isfinite(zone.z) || !std::isfinite(zone.r)) {
+        return Rule_NonFinite;
+    }
+    
+    uint32_t mask = 0;
+    if (zone.smin > zone.smax) mask |= Rule_SpawnRange;
+    if (zone.dmin > zone.dmax) mask |= Rule_DespawnRange;
+    if (zone.smin < 0 || zone.smax < 0 || zone.dmin < 0 || zone.dmax < 0) mask |= Rule_NegativeCount;
+    if (zone.r < 0.0f) mask |= Rule_NegativeRadius;
+    if (zone.r == 0.0f) mask |= Rule_ZeroRadius;
+    if (zone.smax == 0 && zone.dmax == 0) mask |= Rule_NoSpawns;
+    if (worldSizeX > 0.0f && worldSizeZ > 0.0f &&
+        (zone.x < 0.0f || zone.x > worldSizeX || zone.z < 0.0f || zone.z > worldSizeZ)) {
+        mask |= Rule_OutsideWorld;
+    }
+    return mask;
+}
+
+ValidationSeverity TerritoryValidator::GetSeverity(ValidationRule rule) {
+    return (rule & ERROR_RULES) ? ValidationSeverity::Error : ValidationSeverity::Warning;
+}
+
+const char* TerritoryValidator::Describe(ValidationRule rule) {
+    switch (rule) {
+        case Rule_NonFinite:      return "position or radius is not a number";
+        case Rule_SpawnRange:     return "smin is greater than smax";
+        case Rule_DespawnRange:   return "dmin is greater than dmax";
+        case Rule_NegativeCount:  return "negative spawn count";
+        case Rule_NegativeRadius: return "negative radius";
+        case Rule_OutsideWorld:   return "center is outside the map";
+        case Rule_ZeroRadius:     return "radius is zero";
+        case Rule_NoSpawns:       return "smax and dmax are both zero";
+        default:                  return "unknown rule";
+    }
+}
+
+std::string TerritoryValidator::FormatIssue(const ValidationIssue& issue, const TerritoryData& data) {
+    std::ostringstream out;
+    out << (GetSeverity(issue.rule) == ValidationSeverity::Error ? "error: " : "warning: ");
+    const Zone* zone = data.getZone(issue.ref);
+    if (zone) {
+        out << NameTable::Resolve(data.territories[issue.ref.territory].name)
+            << " zone " << issue.ref.zone
+            << " (" << zone->x << ", " << zone->z << "): ";
+    }
+    out << Describe(issue.rule);
+    return out.str();
+}
+
+void TerritoryValidator::SetMask(size_t flatIndex, uint32_t mask) {
+    uint32_t old = zoneMasks_[flatIndex];
+    if (old == mask) {
+        return;
+    }
+    errorCount_ -= CountBits(old & ERROR_RULES);
+    warningCount_ -= CountBits(old & ~ERROR_RULES);
+    errorCount_ += CountBits(mask & ERROR_RULES);
+    warningCount_ += CountBits(mask & ~ERROR_RULES);
+    zoneMasks_[flatIndex] = mask;
+    issuesDirty_ = true;
+}
+
+void TerritoryValidator::RunFullPass(const TerritoryData& data) {
+    territoryStart_.resize(data.territories.size());
+    size_t total = 0;
+    for (size_t t = 0; t < data.territories.size(); ++t) {
+        territoryStart_[t] = static_cast<uint32_t>(total);
+        total += data.territories[t].zones.size();
+    }
+    zoneMasks_.assign(total, 0);
+    
+    // Split territories into contiguous groups of roughly equal zone counts, a few per thread.
+    // Each group writes a disjoint slice of zoneMasks_ and counts its own issues.
+    size_t perGroup = std::max<size_t>(total / JobSystem::GetRangeCount(total, 1) + 1, 1024);
+    
+    struct Counts {
+        size_t errors = 0;
+        size_t warnings = 0;
+    };
+    auto checkRange = [this, &data](size_t beginTerritory, size_t endTerritory) {
+        Counts counts;
+        for (size_t t = beginTerritory; t < endTerritory; ++t) {
+            const auto& zones = data.territories[t].zones;
+            uint32_t* masks = zoneMasks_.data() + territoryStart_[t];
+            for (size_t z = 0; z < zones.size(); ++z) {
+                uint32_t mask = CheckZone(zones[z], worldSizeX_, worldSizeZ_);
+                masks[z] = mask;
+                counts.errors += CountBits(mask & ERROR_RULES);
+                counts.warnings += CountBits(mask & ~ERROR_RULES);
+            }
+        }
+        return counts;
+    };
+    
+    std::vector<size_t> groupStart(1, 0);
+    size_t groupZones = 0;
+    for (size_t t = 0; t < data.territories.size(); ++t) {
+        groupZones += data.territories[t].zones.size();
+        if (groupZones >= perGroup && t + 1 < data.territories.size()) {
+            groupStart.push_back(t + 1);
+            groupZones = 0;
+        }
+    }
+    groupStart.push_back(data.territories.size());
+    
+    size_t groupCount = groupStart.size() - 1;
+    std::vector<Counts> groupCounts(groupCount);
+    JobSystem::ParallelFor("Validate", groupCount, 1, [&](size_t, size_t begin, size_t end) {
+        for (size_t g = begin; g < end; ++g) {
+            groupCounts[g] = checkRange(groupStart[g], groupStart[g + 1]);
+        }
+    });
+    Counts counts;
+    for (const Counts& group : groupCounts) {
+        counts.errors += group.errors;
+        counts.warnings += group.warnings;
+    }
+    
+    errorCount_ = counts.errors;
+    warningCount_ = counts.warnings;
+    issuesDirty_ = true;
+    fullPassNeeded_ = false;
+    dirty_.clear();
+}
+
+void TerritoryValidator::Update(const TerritoryData& data) {
+    // A different layout means zones were added or removed without InvalidateAll
+    bool layoutChanged = territoryStart_.size() != data.territories.size() ||
+                         zoneMasks_.size() != data.getTotalZoneCount();
+    if (fullPassNeeded_ || layoutChanged) {
+        RunFullPass(data);
+        return;
+    }
+    
+    for (const ZoneRef& ref : dirty_) {
+        const Zone* zone = data.getZone(ref);
+        if (zone) {
+            SetMask(territoryStart_[ref.territory] + ref.zone, CheckZone(*zone, worldSizeX_, worldSizeZ_));
+        }
+    }
+    dirty_.clear();
+}
+
+const std::vector<ValidationIssue>& TerritoryValidator::GetIssues() {
+    if (!issuesDirty_) {
+        return issues_;
+    }
+    
+    issues_.clear();
+    issues_.reserve(errorCount_ + warningCount_);
+    for (uint32_t t = 0; t < territoryStart_.size(); ++t) {
+        uint32_t end = t + 1 < territoryStart_.size() ? territoryStart_[t + 1] : static_cast<uint32_t>(zoneMasks_.size());
+        for (uint32_t i = territoryStart_[t]; i < end; ++i) {
+            for (uint32_t mask = zoneMasks_[i]; mask; mask &= mask - 1) {
+                ValidationIssue issue;
+                issue.ref = { t, i - territoryStart_[t] };
+                issue.rule = static_cast<ValidationRule>(mask & (~mask + 1));
+                issues_.push_back(issue);
+            }
+        }
+    }
+    
+    // Errors first, then by zone order
+    std::stable_sort(issues_.begin(), issues_.end(), [](const ValidationIssue& a, const ValidationIssue& b) {
+        return GetSeverity(a.rule) == ValidationSeverity::Error && GetSeverity(b.rule) != ValidationSeverity::Error;
+    });
+    issuesDirty_ = false;
+    return issues_;
+}
+
+size_t TerritoryValidator::GetMemoryUsage() const {
+    return zoneMasks_.capacity() * sizeof(uint32_t) + territoryStart_.capacity() * sizeof(uint32_t) +
+           dirty_.capacity() * sizeof(ZoneRef) + issues_.capacity() * sizeof(ValidationIssue);
+}
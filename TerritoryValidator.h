@@ -0,0 +1,73 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+enum ValidationRule : uint32_t {
+    Rule_NonFinite      = 1 << 0,  // Position or radius is NaN/inf
+    Rule_SpawnRange     = 1 << 1,  // smin > smax
+    Rule_DespawnRange   = 1 << 2,  // dmin > dmax
+    Rule_NegativeCount  = 1 << 3,  // A spawn count below zero
+    Rule_NegativeRadius = 1 << 4,
+    Rule_OutsideWorld   = 1 << 5,  // Center outside 0..worldSize (only when the world size is known)
+    Rule_ZeroRadius     = 1 << 6,
+    Rule_NoSpawns       = 1 << 7,  // smax and dmax are both zero
+};
+
+enum class ValidationSeverity {
+    Warning,
+    Error
+};
+
+struct ValidationIssue {
+    ZoneRef ref;
+    ValidationRule rule = Rule_NonFinite;
+};
+
+// Rule-based checks of every zone. The full pass runs in parallel; after that,
+// edited zones are re-checked individually, so validating after an edit costs
+// a few zones rather than the whole document. Results are kept as one rule
+// bitmask per zone.
+class TerritoryValidator {
+public:
+    // worldSizeX/Z <= 0 disables the outside-world rule
+    void SetWorldSize(float worldSizeX, float worldSizeZ);
+    
+    // Zone values changed; re-checked on the next Update
+    void MarkDirty(ZoneRef ref);
+    // Zones were added, removed or replaced wholesale; everything is re-checked on the next Update
+    void InvalidateAll() { fullPassNeeded_ = true; }
+    
+    // Brings the results up to date with the document
+    void Update(const TerritoryData& data);
+    
+    size_t GetErrorCount() const { return errorCount_; }
+    size_t GetWarningCount() const { return warningCount_; }
+    // Errors first, then in document order; rebuilt only when results changed
+    const std::vector<ValidationIssue>& GetIssues();
+    size_t GetMemoryUsage() const;
+    
+    static uint32_t CheckZone(const Zone& zone, float worldSizeX, float worldSizeZ);
+    static ValidationSeverity GetSeverity(ValidationRule rule);
+    static const char* Describe(ValidationRule rule);
+    static std::string FormatIssue(const ValidationIssue& issue, const TerritoryData& data);
+    
+private:
+    void RunFullPass(const TerritoryData& data);
+    void SetMask(size_t flatIndex, uint32_t mask);
+    
+    float worldSizeX_ = 0.0f;
+    float worldSizeZ_ = 0.0f;
+    
+    std::vector<uint32_t> zoneMasks_;        // Flattened in document order
+    std::vector<uint32_t> territoryStart_;   // Flat index of each territory's first zone
+    std::vector<ZoneRef> dirty_;
+    bool fullPassNeeded_ = true;
+    
+    size_t errorCount_ = 0;
+    size_t warningCount_ = 0;
+    std::vector<ValidationIssue> issues_;
+    bool issuesDirty_ = true;
+};
@@ -0,0 +1,178 @@
+#include "TextureCache.h"
+#include "JobSystem.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <algorithm>
+#include <vector>
+#include <iostream>
+
+// OpenGL function declarations (avoiding Windows GL/gl.h conflicts)
+// These functions are provided by opengl32.dll on Windows
+#ifdef _WIN32
+extern "C" {
+    typedef unsigned int GLuint;
+    typedef unsigned int GLenum;
+    typedef int GLint;
+    typedef int GLsizei;
+    
+    void __stdcall glGenTextures(GLsizei n, GLuint* textures);
+    void __stdcall glDeleteTextures(GLsizei n, const GLuint* textures);
+    void __stdcall glBindTexture(GLenum target, GLuint texture);
+    void __stdcall glTexParameteri(GLenum target, GLenum pname, GLint param);
+    void __stdcall glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels);
+    
+    #define GL_TEXTURE_2D         0x0DE1
+    #define GL_TEXTURE_MIN_FILTER 0x2801
+    #define GL_TEXTURE_MAG_FILTER 0x2800
+    #define GL_TEXTURE_WRAP_S     0x2802
+    #define GL_TEXTURE_WRAP_T     0x2803
+    #define GL_LINEAR             0x2601
+    #define GL_CLAMP_TO_EDGE      0x812F
+    #define GL_RGBA               0x1908
+    #define GL_UNSIGNED_BYTE      0x1401
+}
+#else
+#include <GL/gl.h>
+#endif
+
+TextureCache::TextureCache(size_t budgetBytes)
+    : budgetBytes_(budgetBytes), self_(std::make_shared<TextureCache*>(this)) {
+}
+
+std::atomic<size_t> TextureCache::decodedBytes_{0};
+
+TextureCache::~TextureCache() {
+    Clear();
+}
+
+TextureCache::DecodedImage TextureCache::Decode(const std::string& path) {
+    DecodedImage image;
+    int channels;
+    image.pixels = stbi_load(path.c_str(), &image.width, &image.height, &channels, 4);
+    if (image.pixels) {
+        decodedBytes_ += static_cast<size_t>(image.width) * image.height * 4;
+    }
+    return image;
+}
+
+void TextureCache::Discard(DecodedImage image) {
+    if (image.pixels) {
+        stbi_image_free(image.pixels);
+        decodedBytes_ -= static_cast<size_t>(image.width) * image.height * 4;
+    }
+}
+
+const TextureCache::Texture* TextureCache::Request(const std::string& path) {
+    Entry& entry = entries_[path];
+    entry.lastUsedFrame = frame_;
+    
+    if (entry.texture.id != 0) {
+        return &entry.texture;
+    }
+    
+    // Start decoding on first request, or again after the texture was evicted
+    if (!entry.failed && !entry.decoding) {
+        entry.decoding = true;
+        std::weak_ptr<TextureCache*> cache = self_;
+        JobSystem::Submit("Decode image", [cache, path]() {
+            DecodedImage image = Decode(path);
+            // GL calls only work on the main thread
+            JobSystem::RunOnMainThread([cache, path, image]() {
+                if (std::shared_ptr<TextureCache*> self = cache.lock()) {
+                    (*self)->FinishDecode(path, image);
+                } else {
+                    Discard(image);
+                }
+            });
+        });
+    }
+    return nullptr;
+}
+
+void TextureCache::FinishDecode(const std::string& path, DecodedImage image) {
+    auto it = entries_.find(path);
+    if (it == entries_.end() || it->second.texture.id != 0) {
+        // Cleared meanwhile, or Load() got there first
+        if (it != entries_.end()) {
+            it->second.decoding = false;
+        }
+        Discard(image);
+        return;
+    }
+    it->second.decoding = false;
+    Upload(path, it->second, image);
+}
+
+const TextureCache::Texture* TextureCache::Load(const std::string& path) {
+    Entry& entry = entries_[path];
+    entry.lastUsedFrame = frame_;
+    
+    // A background decode still in flight is discarded when it lands
+    if (entry.texture.id == 0 && !entry.failed) {
+        Upload(path, entry, Decode(path));
+    }
+    return entry.texture.id != 0 ? &entry.texture : nullptr;
+}
+
+void TextureCache::Upload(const std::string& path, Entry& entry, DecodedImage image) {
+    if (!image.pixels) {
+        // Remember the failure so a missing file isn't re-read every frame
+        std::cerr << "Failed to load image: " << path << "\n";
+        entry.failed = true;
+        return;
+    }
+    
+    glGenTextures(1, &entry.texture.id);
+    glBindTexture(GL_TEXTURE_2D, entry.texture.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
+    Discard(image);
+    
+    entry.texture.width = image.width;
+    entry.texture.height = image.height;
+    entry.bytes = static_cast<size_t>(image.width) * image.height * 4;
+    residentBytes_ += entry.bytes;
+}
+
+void TextureCache::Evict(Entry& entry) {
+    if (entry.texture.id != 0) {
+        glDeleteTextures(1, &entry.texture.id);
+        residentBytes_ -= entry.bytes;
+    }
+    entry.texture = Texture();
+    entry.bytes = 0;
+}
+
+void TextureCache::Update() {
+    // Over budget: evict least recently used textures, but never ones drawn this frame
+    if (residentBytes_ > budgetBytes_) {
+        std::vector<Entry*> candidates;
+        for (auto& pair : entries_) {
+            if (pair.second.texture.id != 0 && pair.second.lastUsedFrame < frame_) {
+                candidates.push_back(&pair.second);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Entry* a, const Entry* b) {
+            return a->lastUsedFrame < b->lastUsedFrame;
+        });
+        for (Entry* entry : candidates) {
+            if (residentBytes_ <= budgetBytes_) {
+                break;
+            }
+            Evict(*entry);
+        }
+    }
+    
+    ++frame_;
+}
+
+void TextureCache::Clear() {
+    // Decodes still in flight find their entry gone and free their pixels
+    for (auto& pair : entries_) {
+        Evict(pair.second);
+    }
+    entries_.clear();
+}
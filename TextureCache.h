@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// GL textures keyed by image path, shared by everything that draws map imagery.
+// Images are decoded as jobs and uploaded by a main-thread continuation (see
+// JobSystem::RunMainThreadTasks). Textures stay resident until the total exceeds
+// the VRAM budget, at which point the least recently used ones are evicted.
+class TextureCache {
+public:
+    struct Texture {
+        unsigned int id = 0;
+        int width = 0;
+        int height = 0;
+    };
+    
+    static const size_t DEFAULT_BUDGET_BYTES = 512ull * 1024 * 1024;
+    
+    explicit TextureCache(size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+    ~TextureCache();
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+    
+    // Returns the texture if it is resident; otherwise starts decoding it and returns nullptr
+    const Texture* Request(const std::string& path);
+    // Blocks until the texture is resident; nullptr if the image can't be loaded
+    const Texture* Load(const std::string& path);
+    
+    // Call once per frame with the GL context current: enforces the budget
+    void Update();
+    
+    void SetBudget(size_t bytes) { budgetBytes_ = bytes; }
+    size_t GetBudget() const { return budgetBytes_; }
+    size_t GetResidentBytes() const { return residentBytes_; }
+    // Decoded pixels waiting on the CPU side for upload (all caches; decodes run on worker threads)
+    static size_t GetDecodedBytes() { return decodedBytes_; }
+    size_t GetTextureCount() const { return entries_.size(); }
+    void Clear();
+
+private:
+    struct DecodedImage {
+        unsigned char* pixels = nullptr;  // stbi-owned, RGBA8
+        int width = 0;
+        int height = 0;
+    };
+    
+    struct Entry {
+        Texture texture;
+        size_t bytes = 0;
+        uint64_t lastUsedFrame = 0;
+        bool decoding = false;
+        bool failed = false;
+    };
+    
+    static DecodedImage Decode(const std::string& path);
+    static void Discard(DecodedImage image);
+    // Main thread, once a background decode finished
+    void FinishDecode(const std::string& path, DecodedImage image);
+    void Upload(const std::string& path, Entry& entry, DecodedImage image);
+    void Evict(Entry& entry);
+    
+    std::unordered_map<std::string, Entry> entries_;
+    size_t budgetBytes_;
+    size_t residentBytes_ = 0;
+    uint64_t frame_ = 1;
+    // Decodes finishing after the cache is gone see it expire and just free their pixels
+    std::shared_ptr<TextureCache*> self_;
+    
+    static std::atomic<size_t> decodedBytes_;
+};
@@ -0,0 +1,49 @@
+#include "ViewTransform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VIEW_TRANSFORM_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define VIEW_TRANSFORM_NEON
+#endif
+
+ViewTransform ViewTransform::Create(float worldSizeX, float worldSizeZ, float zoom, float panX, float panY,
+                                    float canvasX, float canvasY, float canvasWidth, float canvasHeight) {
+    ViewTransform view;
+    view.scaleX = canvasWidth / worldSizeX * zoom;
+    view.scaleZ = -(canvasHeight / worldSizeZ * zoom);
+    view.offsetX = panX + canvasX;
+    // screenY = (worldSizeZ - worldZ) * scale + panY + canvasY
+    view.offsetY = worldSizeZ * -view.scaleZ + panY + canvasY;
+    return view;
+}
+
+void ViewTransform::Apply(const float* worldX, const float* worldZ, size_t count, float* screenX, float* screenY) const {
+    size_t i = 0;
+    
+#if defined(VIEW_TRANSFORM_SSE2)
+    __m128 sx = _mm_set1_ps(scaleX);
+    __m128 sz = _mm_set1_ps(scaleZ);
+    __m128 ox = _mm_set1_ps(offsetX);
+    __m128 oy = _mm_set1_ps(offsetY);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(screenX + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(worldX + i), sx), ox));
+        _mm_storeu_ps(screenY + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(worldZ + i), sz), oy));
+    }
+#elif defined(VIEW_TRANSFORM_NEON)
+    float32x4_t sx = vdupq_n_f32(scaleX);
+    float32x4_t sz = vdupq_n_f32(scaleZ);
+    float32x4_t ox = vdupq_n_f32(offsetX);
+    float32x4_t oy = vdupq_n_f32(offsetY);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(screenX + i, vaddq_f32(vmulq_f32(vld1q_f32(worldX + i), sx), ox));
+        vst1q_f32(screenY + i, vaddq_f32(vmulq_f32(vld1q_f32(worldZ + i), sz), oy));
+    }
+#endif
+    
+    for (; i < count; ++i) {
+        screenX[i] = ToScreenX(worldX[i]);
+        screenY[i] = ToScreenY(worldZ[i]);
+    }
+}
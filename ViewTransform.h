@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+// World (X/Z) to screen mapping of one view, reduced to a scale and offset per
+// axis so converting a point is one multiply-add per coordinate. Z is flipped
+// (world Z grows upwards, screen Y downwards) by a negative scaleZ.
+struct ViewTransform {
+    float scaleX = 1.0f;
+    float scaleZ = -1.0f;
+    float offsetX = 0.0f;
+    float offsetY = 0.0f;
+    
+    static ViewTransform Create(float worldSizeX, float worldSizeZ, float zoom, float panX, float panY,
+                                float canvasX, float canvasY, float canvasWidth, float canvasHeight);
+    
+    float ToScreenX(float worldX) const { return worldX * scaleX + offsetX; }
+    float ToScreenY(float worldZ) const { return worldZ * scaleZ + offsetY; }
+    float ToWorldX(float screenX) const { return (screenX - offsetX) / scaleX; }
+    float ToWorldZ(float screenY) const { return (screenY - offsetY) / scaleZ; }
+    
+    // Transforms count points from separate X and Z arrays; SSE2/NEON when available
+    void Apply(const float* worldX, const float* worldZ, size_t count, float* screenX, float* screenY) const;
+};
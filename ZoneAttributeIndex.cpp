@@ -0,0 +1,80 @@
+#include "ZoneAttributeIndex.h"
+#include <algorithm>
+#include <cmath>
+
+void ZoneAttributeIndex::Update(const TerritoryData& data) {
+    if (!dirty_) {
+        return;
+    }
+    
+    size_t count = data.getTotalZoneCount();
+    refs_.clear();
+    refs_.reserve(count);
+    zoneNames_.clear();
+    zoneNames_.reserve(count);
+    territoryNames_.clear();
+    for (auto& column : columns_) {
+        column.clear();
+        column.reserve(count);
+    }
+    for (auto& order : sortedOrder_) {
+        order.clear();
+    }
+    sortedFields_ = 0;
+    
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        const Territory& territory = data.territories[t];
+        territoryNames_.push_back(territory.name);
+        
+        for (uint32_t z = 0; z < territory.zones.size(); ++z) {
+            const Zone& zone = territory.zones[z];
+            refs_.push_back({ t, z });
+            zoneNames_.push_back(zone.name);
+            columns_[static_cast<int>(ZoneField::Smin)].push_back(static_cast<float>(zone.smin));
+            columns_[static_cast<int>(ZoneField::Smax)].push_back(static_cast<float>(zone.smax));
+            columns_[static_cast<int>(ZoneField::Dmin)].push_back(static_cast<float>(zone.dmin));
+            columns_[static_cast<int>(ZoneField::Dmax)].push_back(static_cast<float>(zone.dmax));
+            columns_[static_cast<int>(ZoneField::X)].push_back(zone.x);
+            columns_[static_cast<int>(ZoneField::Z)].push_back(zone.z);
+            columns_[static_cast<int>(ZoneField::R)].push_back(zone.r);
+            columns_[static_cast<int>(ZoneField::H)].push_back(zone.h);
+        }
+    }
+    dirty_ = false;
+}
+
+const std::vector<uint32_t>& ZoneAttributeIndex::GetSortedOrder(ZoneField field) {
+    std::vector<uint32_t>& order = sortedOrder_[static_cast<int>(field)];
+    const std::vector<float>& column = columns_[static_cast<int>(field)];
+    uint32_t bit = 1u << static_cast<int>(field);
+    if (!(sortedFields_ & bit)) {
+        order.clear();
+        order.reserve(column.size());
+        for (uint32_t i = 0; i < column.size(); ++i) {
+            if (!std::isnan(column[i])) {
+                order.push_back(i);
+            }
+        }
+        std::sort(order.begin(), order.end(), [&column](uint32_t a, uint32_t b) {
+            return column[a] < column[b];
+        });
+        sortedFields_ |= bit;
+    }
+    return order;
+}
+
+size_t ZoneAttributeIndex::LowerBound(const std::vector<float>& column, const std::vector<uint32_t>& order, float value, bool inclusive) {
+    auto it = inclusive
+        ? std::lower_bound(order.begin(), order.end(), value, [&column](uint32_t i, float v) { return column[i] < v; })
+        : std::upper_bound(order.begin(), order.end(), value, [&column](float v, uint32_t i) { return v < column[i]; });
+    return static_cast<size_t>(it - order.begin());
+}
+
+size_t ZoneAttributeIndex::GetMemoryUsage() const {
+    size_t bytes = refs_.capacity() * sizeof(ZoneRef) + zoneNames_.capacity() * sizeof(NameId) +
+                   territoryNames_.capacity() * sizeof(NameId);
+    for (int field = 0; field < static_cast<int>(ZoneField::Count); ++field) {
+        bytes += columns_[field].capacity() * sizeof(float) + sortedOrder_[field].capacity() * sizeof(uint32_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <vector>
+#include <cstdint>
+
+enum class ZoneField {
+    Smin,
+    Smax,
+    Dmin,
+    Dmax,
+    X,
+    Z,
+    R,
+    H,
+    Count
+};
+
+// Column copy of every zone's attributes, indexed by flat zone index (document
+// order, territory by territory). Each numeric field gets a sorted permutation
+// on first use, so range predicates are a binary search plus the matches.
+class ZoneAttributeIndex {
+public:
+    void Invalidate() { dirty_ = true; }
+    void Update(const TerritoryData& data);
+    
+    size_t Size() const { return refs_.size(); }
+    size_t GetMemoryUsage() const;
+    ZoneRef GetRef(uint32_t flatIndex) const { return refs_[flatIndex]; }
+    NameId GetZoneName(uint32_t flatIndex) const { return zoneNames_[flatIndex]; }
+    NameId GetTerritoryName(uint32_t flatIndex) const { return territoryNames_[refs_[flatIndex].territory]; }
+    float GetValue(ZoneField field, uint32_t flatIndex) const { return columns_[static_cast<int>(field)][flatIndex]; }
+    
+    // Calls visit(flatIndex) for every zone whose field lies in [lo, hi] (bounds optionally exclusive).
+    // NaN values are left out of the sorted order and never match.
+    template<typename Visit>
+    void ForEachInRange(ZoneField field, float lo, bool loInclusive, float hi, bool hiInclusive, Visit visit) {
+        const std::vector<float>& column = columns_[static_cast<int>(field)];
+        const std::vector<uint32_t>& order = GetSortedOrder(field);
+        size_t begin = LowerBound(column, order, lo, loInclusive);
+        size_t end = LowerBound(column, order, hi, !hiInclusive);
+        for (size_t i = begin; i < end; ++i) {
+            visit(order[i]);
+        }
+    }
+    
+private:
+    const std::vector<uint32_t>& GetSortedOrder(ZoneField field);
+    // First position in order whose value is >= value (or > value when !inclusive)
+    static size_t LowerBound(const std::vector<float>& column, const std::vector<uint32_t>& order, float value, bool inclusive);
+    
+    std::vector<ZoneRef> refs_;
+    std::vector<NameId> zoneNames_;
+    std::vector<NameId> territoryNames_;
+    std::vector<float> columns_[static_cast<int>(ZoneField::Count)];
+    std::vector<uint32_t> sortedOrder_[static_cast<int>(ZoneField::Count)];
+    uint32_t sortedFields_ = 0;  // Bit per field whose sortedOrder_ is built
+    bool dirty_ = true;
+};
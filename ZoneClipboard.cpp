@@ -0,0 +1,292 @@
+#include "ZoneClipboard.h"
+#include "TerritoryParser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+static const char PAYLOAD_MAGIC[4] = { 'T', 'E', 'Z', 'C' };
+static const uint32_t PAYLOAD_VERSION = 1;
+static const char PAYLOAD_PREFIX[] = "<!-- territory-editor-zones:";
+static const char PAYLOAD_SUFFIX[] = " -->";
+
+static const char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static std::string EncodeBase64(const std::vector<uint8_t>& bytes) {
+    std::string text;
+    text.reserve((bytes.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < bytes.size(); i += 3) {
+        uint32_t chunk = static_cast<uint32_t>(bytes[i]) << 16;
+        if (i + 1 < bytes.size()) chunk |= static_cast<uint32_t>(bytes[i + 1]) << 8;
+        if (i + 2 < bytes.size()) chunk |= bytes[i + 2];
+        text += BASE64_CHARS[(chunk >> 18) & 63];
+        text += BASE64_CHARS[(chunk >> 12) & 63];
+        text += i + 1 < bytes.size() ? BASE64_CHARS[(chunk >> 6) & 63] : '=';
+        text += i + 2 < bytes.size() ? BASE64_CHARS[chunk & 63] : '=';
+    }
+    return text;
+}
+
+static bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& bytes) {
+    int8_t values[256];
+    std::memset(values, -1, sizeof(values));
+    for (int i = 0; i < 64; ++i) {
+        values[static_cast<uint8_t>(BASE64_CHARS[i])] = static_cast<int8_t>(i);
+    }
+    
+    bytes.clear();
+    bytes.reserve(length / 4 * 3);
+    uint32_t chunk = 0;
+    int bits = 0;
+    for (size_t i = 0; i < length; ++i) {
+        if (text[i] == '=') {
+            break;
+        }
+        int8_t value = values[static_cast<uint8_t>(text[i])];
+        if (value < 0) {
+            return false;
+        }
+        chunk = (chunk << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            bytes.push_back(static_cast<uint8_t>(chunk >> bits));
+        }
+    }
+    return true;
+}
+
+template<typename T>
+static void Put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+struct PayloadReader {
+    const uint8_t* ptr;
+    const uint8_t* end;
+    bool ok = true;
+    
+    template<typename T>
+    T Get() {
+        T value{};
+        if (static_cast<size_t>(end - ptr) < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, ptr, sizeof(T));
+        ptr += sizeof(T);
+        return value;
+    }
+};
+
+ZoneClipboardContent ZoneClipboard::CopySelected(const TerritoryData& data) {
+    ZoneClipboardContent content;
+    float minX = 0.0f, minZ = 0.0f, maxX = 0.0f, maxZ = 0.0f;
+    bool first = true;
+    for (const auto& territory : data.territories) {
+        Territory* copy = nullptr;
+        for (const auto& zone : territory.zones) {
+            if (!zone.selected) {
+                continue;
+            }
+            if (!copy) {
+                content.data.territories.emplace_back();
+                copy = &content.data.territories.back();
+                copy->name = territory.name;
+                copy->color = territory.color;
+            }
+            Zone& added = copy->zones.emplace_back(zone);
+            added.selected = false;
+            added.visible = true;
+            added.sourceId = UINT32_MAX;
+            
+            minX = first ? zone.x : std::min(minX, zone.x);
+            minZ = first ? zone.z : std::min(minZ, zone.z);
+            maxX = first ? zone.x : std::max(maxX, zone.x);
+            maxZ = first ? zone.z : std::max(maxZ, zone.z);
+            first = false;
+        }
+    }
+    
+    content.anchorX = (minX + maxX) * 0.5f;
+    content.anchorZ = (minZ + maxZ) * 0.5f;
+    for (auto& territory : content.data.territories) {
+        for (auto& zone : territory.zones) {
+            zone.x -= content.anchorX;
+            zone.z -= content.anchorZ;
+        }
+    }
+    return content;
+}
+
+std::string ZoneClipboard::ToText(const ZoneClipboardContent& content) {
+    std::vector<uint8_t> payload;
+    EncodePayload(content, payload);
+    
+    // The XML carries absolute positions, as a territory file would
+    TerritoryData absolute = content.data;
+    for (auto& territory : absolute.territories) {
+        for (auto& zone : territory.zones) {
+            zone.x += content.anchorX;
+            zone.z += content.anchorZ;
+        }
+    }
+    return PAYLOAD_PREFIX + EncodeBase64(payload) + PAYLOAD_SUFFIX + "\n" + TerritoryParser::SaveToString(absolute);
+}
+
+bool ZoneClipboard::FromText(const std::string& text, ZoneClipboardContent& content, std::string& error) {
+    content = ZoneClipboardContent();
+    
+    size_t prefix = text.find(PAYLOAD_PREFIX);
+    if (prefix != std::string::npos) {
+        size_t begin = prefix + sizeof(PAYLOAD_PREFIX) - 1;
+        size_t end = text.find(PAYLOAD_SUFFIX, begin);
+        std::vector<uint8_t> payload;
+        if (end != std::string::npos && DecodeBase64(text.data() + begin, end - begin, payload) &&
+            DecodePayload(payload, content)) {
+            if (content.GetZoneCount() == 0) {
+                error = "The clipboard holds no zones";
+                content = ZoneClipboardContent();
+                return false;
+            }
+            return true;
+        }
+        // A damaged payload; the XML after it may still be intact
+        content = ZoneClipboardContent();
+    }
+    
+    if (!TerritoryParser::LoadFromString(text, content.data) || content.data.getTotalZoneCount() == 0) {
+        error = "The clipboard holds no zones";
+        content = ZoneClipboardContent();
+        return false;
+    }
+    
+    // Anchor XML zones on the centre of their bounds, like a copy from the editor
+    float minX = INFINITY, minZ = INFINITY, maxX = -INFINITY, maxZ = -INFINITY;
+    for (const auto& territory : content.data.territories) {
+        for (const auto& zone : territory.zones) {
+            minX = std::min(minX, zone.x);
+            minZ = std::min(minZ, zone.z);
+            maxX = std::max(maxX, zone.x);
+            maxZ = std::max(maxZ, zone.z);
+        }
+    }
+    content.anchorX = std::isfinite(minX + maxX) ? (minX + maxX) * 0.5f : 0.0f;
+    content.anchorZ = std::isfinite(minZ + maxZ) ? (minZ + maxZ) * 0.5f : 0.0f;
+    for (auto& territory : content.data.territories) {
+        for (auto& zone : territory.zones) {
+            zone.x -= content.anchorX;
+            zone.z -= content.anchorZ;
+        }
+    }
+    return true;
+}
+
+void ZoneClipboard::EncodePayload(const ZoneClipboardContent& content, std::vector<uint8_t>& out) {
+    // Names are written once and referred to by index; most zones share their territory's name
+    std::vector<NameId> names;
+    std::unordered_map<NameId, uint32_t> nameIndex;
+    auto indexOf = [&](NameId name) {
+        auto inserted = nameIndex.emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted.second) {
+            names.push_back(name);
+        }
+        return inserted.first->second;
+    };
+    
+    std::vector<uint8_t> body;
+    body.reserve(content.GetZoneCount() * 36 + content.data.territories.size() * 12);
+    Put<uint32_t>(body, static_cast<uint32_t>(content.data.territories.size()));
+    for (const auto& territory : content.data.territories) {
+        Put<uint32_t>(body, indexOf(territory.name));
+        Put<uint32_t>(body, territory.color);
+        Put<uint32_t>(body, static_cast<uint32_t>(territory.zones.size()));
+        for (const auto& zone : territory.zones) {
+            Put<uint32_t>(body, indexOf(zone.name));
+            Put<int32_t>(body, zone.smin);
+            Put<int32_t>(body, zone.smax);
+            Put<int32_t>(body, zone.dmin);
+            Put<int32_t>(body, zone.dmax);
+            Put<float>(body, zone.x);
+            Put<float>(body, zone.z);
+            Put<float>(body, zone.r);
+            Put<float>(body, zone.h);
+        }
+    }
+    
+    out.clear();
+    out.insert(out.end(), PAYLOAD_MAGIC, PAYLOAD_MAGIC + sizeof(PAYLOAD_MAGIC));
+    Put<uint32_t>(out, PAYLOAD_VERSION);
+    Put<float>(out, content.anchorX);
+    Put<float>(out, content.anchorZ);
+    Put<uint32_t>(out, static_cast<uint32_t>(names.size()));
+    for (NameId name : names) {
+        const std::string& text = NameTable::Resolve(name);
+        Put<uint32_t>(out, static_cast<uint32_t>(text.size()));
+        out.insert(out.end(), text.begin(), text.end());
+    }
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+bool ZoneClipboard::DecodePayload(const std::vector<uint8_t>& bytes, ZoneClipboardContent& content) {
+    if (bytes.size() < sizeof(PAYLOAD_MAGIC) || std::memcmp(bytes.data(), PAYLOAD_MAGIC, sizeof(PAYLOAD_MAGIC)) != 0) {
+        return false;
+    }
+    PayloadReader reader{ bytes.data() + sizeof(PAYLOAD_MAGIC), bytes.data() + bytes.size() };
+    if (reader.Get<uint32_t>() != PAYLOAD_VERSION) {
+        return false;
+    }
+    content.anchorX = reader.Get<float>();
+    content.anchorZ = reader.Get<float>();
+    
+    // Counts are checked against the bytes left, so a corrupt payload can't ask for huge allocations
+    uint32_t nameCount = reader.Get<uint32_t>();
+    if (!reader.ok || nameCount > static_cast<size_t>(reader.end - reader.ptr) / sizeof(uint32_t)) {
+        return false;
+    }
+    std::vector<NameId> names(nameCount);
+    for (uint32_t i = 0; i < nameCount; ++i) {
+        uint32_t length = reader.Get<uint32_t>();
+        if (!reader.ok || length > static_cast<size_t>(reader.end - reader.ptr)) {
+            return false;
+        }
+        names[i] = NameTable::Intern(std::string_view(reinterpret_cast<const char*>(reader.ptr), length));
+        reader.ptr += length;
+    }
+    auto nameAt = [&](uint32_t index) {
+        if (index >= names.size()) {
+            reader.ok = false;
+            return NameId(0);
+        }
+        return names[index];
+    };
+    
+    const size_t ZONE_BYTES = 9 * 4;
+    uint32_t territoryCount = reader.Get<uint32_t>();
+    for (uint32_t t = 0; t < territoryCount && reader.ok; ++t) {
+        Territory territory(content.data.territories.get_allocator());
+        territory.name = nameAt(reader.Get<uint32_t>());
+        territory.color = reader.Get<uint32_t>();
+        uint32_t zoneCount = reader.Get<uint32_t>();
+        if (!reader.ok || zoneCount > static_cast<size_t>(reader.end - reader.ptr) / ZONE_BYTES) {
+            return false;
+        }
+        territory.zones.reserve(zoneCount);
+        for (uint32_t z = 0; z < zoneCount; ++z) {
+            Zone zone;
+            zone.name = nameAt(reader.Get<uint32_t>());
+            zone.smin = reader.Get<int32_t>();
+            zone.smax = reader.Get<int32_t>();
+            zone.dmin = reader.Get<int32_t>();
+            zone.dmax = reader.Get<int32_t>();
+            zone.x = reader.Get<float>();
+            zone.z = reader.Get<float>();
+            zone.r = reader.Get<float>();
+            zone.h = reader.Get<float>();
+            territory.zones.push_back(zone);
+        }
+        content.data.territories.push_back(std::move(territory));
+    }
+    return reader.ok;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Zones on the clipboard, grouped by the territory they were copied from. Positions
+// are relative to the anchor (the centre of the copied zones' bounds), so a paste can
+// place the group anywhere and keep its layout.
+struct ZoneClipboardContent {
+    TerritoryData data;
+    float anchorX = 0.0f;
+    float anchorZ = 0.0f;
+    
+    size_t GetZoneCount() const { return data.getTotalZoneCount(); }
+};
+
+// Clipboard text is the zones as territory XML, so they can be pasted into a file or
+// another tool, preceded by a comment carrying the same zones as a compact binary
+// payload (base64). Editors read the payload: exact values, no XML parsing. Text
+// without one, e.g. zones copied out of a territory file, is read as XML.
+//
+// Payload layout (little endian): "TEZC", uint32 version, float anchorX, float anchorZ,
+// uint32 nameCount, names (uint32 length + bytes), uint32 territoryCount, then per
+// territory: uint32 name, uint32 color, uint32 zoneCount, and per zone: uint32 name,
+// int32 smin, smax, dmin, dmax, float x, z, r, h (x and z relative to the anchor).
+class ZoneClipboard {
+public:
+    // The selected zones of data, in document order
+    static ZoneClipboardContent CopySelected(const TerritoryData& data);
+    
+    static std::string ToText(const ZoneClipboardContent& content);
+    static bool FromText(const std::string& text, ZoneClipboardContent& content, std::string& error);
+
+private:
+    static void EncodePayload(const ZoneClipboardContent& content, std::vector<uint8_t>& out);
+    static bool DecodePayload(const std::vector<uint8_t>& bytes, ZoneClipboardContent& content);
+};
@@ -0,0 +1,285 @@
+#include "ZoneDeduplicator.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+// Cell coordinates are packed into 20 bits each, centered on 0; smaller cells would push
+// ordinary map coordinates past the edge cells
+static const float MIN_CELL_SIZE = 0.1f;
+static const int CELL_BITS = 20;
+static const int64_t CELL_LIMIT = int64_t(1) << CELL_BITS;
+static const uint64_t NO_CELL = UINT64_MAX;  // Non-finite positions never match
+
+// Items per sorted run; smaller runs cost more merge passes than they save
+static const size_t MIN_SORT_RUN = 4096;
+
+struct KeyedZone {
+    uint64_t key;
+    uint32_t index;  // Flat document-order index
+    
+    bool operator<(const KeyedZone& other) const {
+        return key != other.key ? key < other.key : index < other.index;
+    }
+};
+
+// Sorts runs in parallel, then merges neighbouring runs pairwise (also in parallel) until one is left
+static void ParallelSort(std::vector<KeyedZone>& items) {
+    if (items.size() < 2) {
+        return;
+    }
+    size_t runs = std::min(JobSystem::GetWorkerCount() + 1, std::max<size_t>(items.size() / MIN_SORT_RUN, 1));
+    size_t perRun = (items.size() + runs - 1) / runs;
+    std::vector<size_t> bounds;
+    for (size_t begin = 0; begin < items.size(); begin += perRun) {
+        bounds.push_back(begin);
+    }
+    bounds.push_back(items.size());
+    
+    JobSystem::ParallelFor("Sort duplicate keys", bounds.size() - 1, 1, [&items, &bounds](size_t, size_t begin, size_t end) {
+        for (size_t run = begin; run < end; ++run) {
+            std::sort(items.begin() + bounds[run], items.begin() + bounds[run + 1]);
+        }
+    });
+    
+    while (bounds.size() > 2) {
+        size_t pairs = (bounds.size() - 1) / 2;
+        JobSystem::ParallelFor("Merge duplicate keys", pairs, 1, [&items, &bounds](size_t, size_t begin, size_t end) {
+            for (size_t pair = begin; pair < end; ++pair) {
+                std::inplace_merge(items.begin() + bounds[pair * 2], items.begin() + bounds[pair * 2 + 1],
+                                   items.begin() + bounds[pair * 2 + 2]);
+            }
+        });
+        std::vector<size_t> merged;
+        for (size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != items.size()) {
+            merged.push_back(items.size());
+        }
+        bounds.swap(merged);
+    }
+}
+
+static uint64_t MakeKey(uint32_t territory, int64_t cellX, int64_t cellZ) {
+    return (static_cast<uint64_t>(territory) << (2 * CELL_BITS)) |
+           (static_cast<uint64_t>(cellX) << CELL_BITS) | static_cast<uint64_t>(cellZ);
+}
+
+static int64_t CellCoordinate(float value, float cellSize) {
+    int64_t cell = static_cast<int64_t>(std::floor(value / cellSize)) + CELL_LIMIT / 2;
+    return std::min(std::max<int64_t>(cell, 0), CELL_LIMIT - 1);
+}
+
+// Union-find where the smaller index is always the root, so a group's root is its first zone
+static uint32_t FindRoot(std::vector<uint32_t>& parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void ZoneDeduplicator::FindDuplicates(const TerritoryData& data, const DedupSettings& settings, DuplicateGroups& out) {
+    out.clear();
+    
+    // Flatten positions (SoA) and remember where each zone came from
+    size_t count = data.getTotalZoneCount();
+    std::vector<float> xs(count);
+    std::vector<float> zs(count);
+    std::vector<float> rs(count);
+    std::vector<ZoneRef> refs(count);
+    size_t flatIndex = 0;
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        const auto& zones = data.territories[t].zones;
+        for (uint32_t z = 0; z < zones.size(); ++z) {
+            xs[flatIndex] = zones[z].x;
+            zs[flatIndex] = zones[z].z;
+            rs[flatIndex] = zones[z].r;
+            refs[flatIndex] = { t, z };
+            ++flatIndex;
+        }
+    }
+    
+    float distance = std::max(settings.distance, 0.0f);
+    float cellSize = std::max(distance, MIN_CELL_SIZE);
+    std::vector<KeyedZone> keyed(count);
+    JobSystem::ParallelFor("Key zones", count, 4096, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            bool finite = std::isfinite(xs[i]) && std::isfinite(zs[i]);
+            keyed[i].key = finite ? MakeKey(refs[i].territory, CellCoordinate(xs[i], cellSize), CellCoordinate(zs[i], cellSize)) : NO_CELL;
+            keyed[i].index = static_cast<uint32_t>(i);
+        }
+    });
+    ParallelSort(keyed);
+    
+    // Runs of equal keys are the occupied cells, in key order
+    struct Cell {
+        uint64_t key;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Cell> cells;
+    for (size_t i = 0; i < count && keyed[i].key != NO_CELL;) {
+        size_t end = i + 1;
+        while (end < count && keyed[end].key == keyed[i].key) ++end;
+        cells.push_back({ keyed[i].key, static_cast<uint32_t>(i), static_cast<uint32_t>(end) });
+        i = end;
+    }
+    
+    auto isDuplicate = [&](uint32_t a, uint32_t b) {
+        float dx = xs[a] - xs[b];
+        float dz = zs[a] - zs[b];
+        if (dx * dx + dz * dz > distance * distance || std::fabs(rs[a] - rs[b]) > settings.radiusTolerance) {
+            return false;
+        }
+        if (settings.matchCounts) {
+            const Zone& za = data.territories[refs[a].territory].zones[refs[a].zone];
+            const Zone& zb = data.territories[refs[b].territory].zones[refs[b].zone];
+            return za.smin == zb.smin && za.smax == zb.smax && za.dmin == zb.dmin && za.dmax == zb.dmax;
+        }
+        return true;
+    };
+    
+    // Each pair of neighbouring cells is visited once: the cell itself plus the four
+    // neighbours that come after it. Ranges collect matching pairs separately.
+    static const int NEIGHBORS[4][2] = { { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> rangePairs(JobSystem::GetRangeCount(cells.size(), 256));
+    JobSystem::ParallelFor("Compare cells", cells.size(), 256, [&](size_t range, size_t begin, size_t end) {
+        auto& pairs = rangePairs[range];
+        for (size_t c = begin; c < end; ++c) {
+            const Cell& cell = cells[c];
+            for (uint32_t i = cell.begin; i < cell.end; ++i) {
+                for (uint32_t j = i + 1; j < cell.end; ++j) {
+                    if (isDuplicate(keyed[i].index, keyed[j].index)) {
+                        pairs.push_back({ keyed[i].index, keyed[j].index });
+                    }
+                }
+            }
+            
+            uint64_t territory = cell.key >> (2 * CELL_BITS);
+            int64_t cellX = static_cast<int64_t>((cell.key >> CELL_BITS) & (CELL_LIMIT - 1));
+            int64_t cellZ = static_cast<int64_t>(cell.key & (CELL_LIMIT - 1));
+            for (const auto& offset : NEIGHBORS) {
+                int64_t nx = cellX + offset[0];
+                int64_t nz = cellZ + offset[1];
+                if (nx >= CELL_LIMIT || nz < 0 || nz >= CELL_LIMIT) continue;
+                uint64_t key = MakeKey(static_cast<uint32_t>(territory), nx, nz);
+                auto it = std::lower_bound(cells.begin() + c + 1, cells.end(), key,
+                                           [](const Cell& a, uint64_t k) { return a.key < k; });
+                if (it == cells.end() || it->key != key) continue;
+                for (uint32_t i = cell.begin; i < cell.end; ++i) {
+                    for (uint32_t j = it->begin; j < it->end; ++j) {
+                        if (isDuplicate(keyed[i].index, keyed[j].index)) {
+                            pairs.push_back({ keyed[i].index, keyed[j].index });
+                        }
+                    }
+                }
+            }
+        }
+    });
+    
+    std::vector<uint32_t> parent(count);
+    for (size_t i = 0; i < count; ++i) {
+        parent[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> touched;
+    for (const auto& pairs : rangePairs) {
+        for (const auto& pair : pairs) {
+            uint32_t a = FindRoot(parent, pair.first);
+            uint32_t b = FindRoot(parent, pair.second);
+            if (a != b) {
+                parent[std::max(a, b)] = std::min(a, b);
+            }
+            touched.push_back(pair.first);
+            touched.push_back(pair.second);
+        }
+    }
+    if (touched.empty()) {
+        return;
+    }
+    
+    // Sorting by (root, index) lists components by their first zone, members in document order
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    std::vector<std::pair<uint32_t, uint32_t>> grouped;
+    grouped.reserve(touched.size());
+    for (uint32_t i : touched) {
+        grouped.push_back({ FindRoot(parent, i), i });
+    }
+    std::sort(grouped.begin(), grouped.end());
+    
+    // A chain A~B~C can put C well outside the tolerance of A, the zone a merge keeps, so
+    // each component is split: its first zone takes every member that matches it, and the
+    // rest are split again the same way. Members left on their own aren't duplicates.
+    out.members.reserve(grouped.size());
+    std::vector<uint32_t> pending;
+    std::vector<uint32_t> rest;
+    for (size_t i = 0; i < grouped.size();) {
+        size_t end = i + 1;
+        while (end < grouped.size() && grouped[end].first == grouped[i].first) ++end;
+        pending.clear();
+        for (size_t m = i; m < end; ++m) {
+            pending.push_back(grouped[m].second);
+        }
+        i = end;
+        
+        while (pending.size() > 1) {
+            uint32_t kept = pending[0];
+            uint32_t groupBegin = static_cast<uint32_t>(out.members.size());
+            out.members.push_back(refs[kept]);
+            rest.clear();
+            for (size_t m = 1; m < pending.size(); ++m) {
+                if (isDuplicate(kept, pending[m])) {
+                    out.members.push_back(refs[pending[m]]);
+                } else {
+                    rest.push_back(pending[m]);
+                }
+            }
+            if (out.members.size() - groupBegin > 1) {
+                out.groupStart.push_back(groupBegin);
+            } else {
+                out.members.pop_back();
+            }
+            pending.swap(rest);
+        }
+    }
+    if (out.groupStart.empty()) {
+        return;
+    }
+    out.groupStart.push_back(static_cast<uint32_t>(out.members.size()));
+}
+
+size_t ZoneDeduplicator::RemoveDuplicates(TerritoryData& data, const DuplicateGroups& groups, std::vector<ZoneRef>* removed) {
+    std::vector<std::vector<uint8_t>> remove(data.territories.size());
+    for (size_t t = 0; t < data.territories.size(); ++t) {
+        remove[t].assign(data.territories[t].zones.size(), 0);
+    }
+    for (size_t g = 0; g < groups.GetGroupCount(); ++g) {
+        for (uint32_t m = groups.groupStart[g] + 1; m < groups.groupStart[g + 1]; ++m) {
+            const ZoneRef& ref = groups.members[m];
+            if (ref.territory < remove.size() && ref.zone < remove[ref.territory].size()) {
+                remove[ref.territory][ref.zone] = 1;
+            }
+        }
+    }
+    
+    size_t removedCount = 0;
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        auto& zones = data.territories[t].zones;
+        const std::vector<uint8_t>& flags = remove[t];
+        size_t kept = 0;
+        for (uint32_t z = 0; z < zones.size(); ++z) {
+            if (flags[z]) {
+                if (removed) removed->push_back({ t, z });
+                continue;
+            }
+            if (kept != z) {
+                zones[kept] = zones[z];
+            }
+            ++kept;
+        }
+        removedCount += zones.size() - kept;
+        zones.resize(kept);
+    }
+    return removedCount;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include <vector>
+#include <cstdint>
+
+struct DedupSettings {
+    float distance = 2.0f;         // Max distance between the centers of duplicates
+    float radiusTolerance = 1.0f;  // Max difference between their radii
+    bool matchCounts = false;      // Also require identical smin/smax/dmin/dmax
+};
+
+// Clusters of near-identical zones, flattened: group g is members[groupStart[g] .. groupStart[g + 1]).
+// Members are in document order, so the first of each group is the one a merge keeps;
+// every other member is within the settings' tolerance of it.
+struct DuplicateGroups {
+    std::vector<ZoneRef> members;
+    std::vector<uint32_t> groupStart;
+    
+    size_t GetGroupCount() const { return groupStart.empty() ? 0 : groupStart.size() - 1; }
+    size_t GetDuplicateCount() const { return members.size() - GetGroupCount(); }
+    void clear() {
+        members.clear();
+        groupStart.clear();
+    }
+};
+
+// Finds zones of the same territory that are duplicates of each other. Zones are bucketed
+// into a grid of distance-sized cells keyed by (territory, cell); after a parallel sort by
+// key, each cell is compared against itself and four forward neighbours in parallel, and
+// the matching pairs are joined with union-find. Chains of near matches are then split
+// so that no group holds a zone too far from the one it would be merged into.
+class ZoneDeduplicator {
+public:
+    static void FindDuplicates(const TerritoryData& data, const DedupSettings& settings, DuplicateGroups& out);
+    
+    // Keeps the first zone of every group and removes the others, which are appended to
+    // removed (indices before the removal, document order). Returns the number removed.
+    static size_t RemoveDuplicates(TerritoryData& data, const DuplicateGroups& groups, std::vector<ZoneRef>* removed = nullptr);
+};
@@ -0,0 +1,158 @@
+#include "ZoneGenerator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // SplitMix64, like the spawn simulator's; floats from the top 24 bits
+    struct FillRandom {
+        uint64_t state;
+        
+        explicit FillRandom(uint64_t seed) : state(seed) {}
+        
+        uint64_t Next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        
+        // Uniform in [0, 1)
+        float NextFloat() {
+            return static_cast<float>(Next() >> 40) * (1.0f / 16777216.0f);
+        }
+    };
+    
+    const float TWO_PI = 6.28318530718f;
+}
+
+std::vector<RegionPoint> ZoneGenerator::MakeRect(float minX, float minZ, float maxX, float maxZ) {
+    return { { minX, minZ }, { maxX, minZ }, { maxX, maxZ }, { minX, maxZ } };
+}
+
+bool ZoneGenerator::PoissonFill(const std::vector<RegionPoint>& outline, const ZoneFillSettings& settings,
+                                const ZoneIndex& existing,
+                                std::vector<RegionPoint>& out, std::string& error) {
+    out.clear();
+    error.clear();
+    
+    PolygonTester polygon(outline);
+    if (!polygon.IsValid()) {
+        error = "The outline needs at least three points";
+        return false;
+    }
+    if (!(settings.spacing > 0.0f) || !(settings.radius >= 0.0f)) {
+        error = "Spacing must be positive";
+        return false;
+    }
+    
+    // Cell diagonal == spacing, so a cell holds at most one sample
+    float cellSize = settings.spacing / std::sqrt(2.0f);
+    float width = polygon.maxX - polygon.minX;
+    float height = polygon.maxZ - polygon.minZ;
+    size_t columns = static_cast<size_t>(width / cellSize) + 1;
+    size_t rows = static_cast<size_t>(height / cellSize) + 1;
+    if (columns * rows > MAX_GRID_CELLS) {
+        error = "Spacing is too small for an area this large";
+        return false;
+    }
+    
+    std::vector<int32_t> grid(columns * rows, -1);  // Index into out, -1 for empty
+    auto cellOf = [&](float x, float z, size_t& column, size_t& row) {
+        column = std::min(static_cast<size_t>((x - polygon.minX) / cellSize), columns - 1);
+        row = std::min(static_cast<size_t>((z - polygon.minZ) / cellSize), rows - 1);
+    };
+    
+    float spacingSq = settings.spacing * settings.spacing;
+    float reach = settings.radius + settings.clearance;
+    float existingReach = reach + existing.GetMaxRadius();
+    const KdTree& tree = existing.GetTree();
+    
+    auto isFree = [&](float x, float z) {
+        if (x < polygon.minX || x > polygon.maxX || z < polygon.minZ || z > polygon.maxZ || !polygon.Contains(x, z)) {
+            return false;
+        }
+        
+        // Spacing from other samples: only the 5x5 block of cells around can be close enough
+        size_t column, row;
+        cellOf(x, z, column, row);
+        size_t c0 = column >= 2 ? column - 2 : 0;
+        size_t r0 = row >= 2 ? row - 2 : 0;
+        size_t c1 = std::min(column + 2, columns - 1);
+        size_t r1 = std::min(row + 2, rows - 1);
+        for (size_t r = r0; r <= r1; ++r) {
+            for (size_t c = c0; c <= c1; ++c) {
+                int32_t sample = grid[r * columns + c];
+                if (sample < 0) continue;
+                float dx = out[sample].x - x;
+                float dz = out[sample].z - z;
+                if (dx * dx + dz * dz < spacingSq) {
+                    return false;
+                }
+            }
+        }
+        
+        // Clearance from existing zones, radius-aware
+        bool blocked = false;
+        tree.QueryRadius(x, z, existingReach, [&](uint32_t id, float distSq) {
+            float limit = reach + existing.GetRadius(id);
+            if (distSq < limit * limit) {
+                blocked = true;
+            }
+        });
+        return !blocked;
+    };
+    
+    auto addSample = [&](float x, float z) {
+        size_t column, row;
+        cellOf(x, z, column, row);
+        grid[row * columns + column] = static_cast<int32_t>(out.size());
+        out.push_back({ x, z });
+    };
+    
+    FillRandom random(settings.seed);
+    std::vector<uint32_t> active;
+    int attempts = std::max(settings.attempts, 1);
+    size_t maxZones = static_cast<size_t>(std::max(settings.maxZones, 0));
+    
+    // Seeds are random points of the bounding box; after this many misses in a row the
+    // outline is considered full
+    const int MAX_SEED_MISSES = 200;
+    int seedMisses = 0;
+    while (out.size() < maxZones && seedMisses < MAX_SEED_MISSES) {
+        float seedX = polygon.minX + random.NextFloat() * width;
+        float seedZ = polygon.minZ + random.NextFloat() * height;
+        if (!isFree(seedX, seedZ)) {
+            seedMisses++;
+            continue;
+        }
+        seedMisses = 0;
+        active.push_back(static_cast<uint32_t>(out.size()));
+        addSample(seedX, seedZ);
+        
+        // Grow from the active list: candidates in the annulus [spacing, 2 * spacing)
+        while (!active.empty() && out.size() < maxZones) {
+            size_t pick = static_cast<size_t>(random.NextFloat() * active.size());
+            pick = std::min(pick, active.size() - 1);
+            RegionPoint center = out[active[pick]];
+            
+            bool placed = false;
+            for (int i = 0; i < attempts; ++i) {
+                float angle = random.NextFloat() * TWO_PI;
+                float distance = settings.spacing * (1.0f + random.NextFloat());
+                float x = center.x + std::cos(angle) * distance;
+                float z = center.z + std::sin(angle) * distance;
+                if (isFree(x, z)) {
+                    active.push_back(static_cast<uint32_t>(out.size()));
+                    addSample(x, z);
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed) {
+                active[pick] = active.back();
+                active.pop_back();
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "SelectionRegion.h"
+#include "ZoneIndex.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct ZoneFillSettings {
+    float spacing = 250.0f;    // Minimum distance between generated zone centers
+    float radius = 50.0f;      // Radius of generated zones
+    float clearance = 25.0f;   // Gap kept between generated and existing zone edges
+    int attempts = 30;         // Candidates tried around each sample before it is retired
+    int maxZones = 50000;
+    uint32_t seed = 1;
+};
+
+// Procedural zone placement
+class ZoneGenerator {
+public:
+    // Largest background grid a fill may allocate (cells); bounds spacing for huge outlines
+    static const size_t MAX_GRID_CELLS = 16 * 1024 * 1024;
+    
+    // Poisson-disk (Bridson) samples inside the outline, at least spacing apart and keeping
+    // clearance from every zone in 'existing'. A background grid with one sample per cell
+    // answers the spacing test; the outline is reseeded when growth stalls, so areas cut off
+    // by existing zones are filled too. Returns false with a reason if the fill can't run.
+    static bool PoissonFill(const std::vector<RegionPoint>& outline, const ZoneFillSettings& settings,
+                            const ZoneIndex& existing,
+                            std::vector<RegionPoint>& out, std::string& error);
+    
+    // Axis-aligned rectangle as an outline, for filling a rect instead of a polygon
+    static std::vector<RegionPoint> MakeRect(float minX, float minZ, float maxX, float maxZ);
+};
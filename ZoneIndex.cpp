@@ -0,0 +1,29 @@
+#include "ZoneIndex.h"
+#include <algorithm>
+
+void ZoneIndex::Update(const TerritoryData& data) {
+    if (!dirty_) {
+        return;
+    }
+    
+    std::vector<KdTree::Point> points;
+    points.reserve(data.getTotalZoneCount());
+    refs_.clear();
+    refs_.reserve(points.capacity());
+    radii_.clear();
+    radii_.reserve(points.capacity());
+    maxRadius_ = 0.0f;
+    
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        const auto& zones = data.territories[t].zones;
+        for (uint32_t z = 0; z < zones.size(); ++z) {
+            points.push_back({ zones[z].x, zones[z].z, static_cast<uint32_t>(refs_.size()) });
+            refs_.push_back({ t, z });
+            radii_.push_back(zones[z].r);
+            maxRadius_ = std::max(maxRadius_, zones[z].r);
+        }
+    }
+    
+    tree_.Build(std::move(points));
+    dirty_ = false;
+}
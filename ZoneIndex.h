@@ -0,0 +1,49 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include "KdTree.h"
+#include <vector>
+
+// Spatial index over every zone center of a document. Built lazily on the
+// first query after Invalidate(), so any number of edits cost one rebuild.
+class ZoneIndex {
+public:
+    void Invalidate() { dirty_ = true; }
+    bool IsDirty() const { return dirty_; }
+    
+    // Rebuilds the tree if the document changed since the last build
+    void Update(const TerritoryData& data);
+    
+    // Tree point ids are zone indices in document order (territory by territory)
+    const KdTree& GetTree() const { return tree_; }
+    ZoneRef GetRef(uint32_t id) const { return id < refs_.size() ? refs_[id] : ZoneRef(); }
+    float GetRadius(uint32_t id) const { return radii_[id]; }
+    float GetMaxRadius() const { return maxRadius_; }
+    size_t GetMemoryUsage() const {
+        return tree_.GetMemoryUsage() + refs_.capacity() * sizeof(ZoneRef) + radii_.capacity() * sizeof(float);
+    }
+    
+    // Calls visit(ZoneRef) for every zone whose center lies inside the rectangle
+    template<typename Visit>
+    void QueryRect(float minX, float minZ, float maxX, float maxZ, Visit visit) const {
+        tree_.QueryRect(minX, minZ, maxX, maxZ, [&](uint32_t id) { visit(refs_[id]); });
+    }
+    
+    // Calls visit(ZoneRef) for every zone whose center is inside the rectangle and passes
+    // filter(x, z); the filter sees indexed coordinates, so rejected zones are never touched
+    template<typename Filter, typename Visit>
+    void QueryRect(float minX, float minZ, float maxX, float maxZ, Filter filter, Visit visit) const {
+        tree_.QueryRectPoints(minX, minZ, maxX, maxZ, [&](const KdTree::Point& p) {
+            if (filter(p.x, p.z)) {
+                visit(refs_[p.id]);
+            }
+        });
+    }
+    
+private:
+    KdTree tree_;
+    std::vector<ZoneRef> refs_;  // Tree point id -> zone
+    std::vector<float> radii_;   // Tree point id -> zone radius, so hit tests don't touch zones
+    float maxRadius_ = 0.0f;
+    bool dirty_ = true;
+};
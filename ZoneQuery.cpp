@@ -0,0 +1,454 @@
+#include "ZoneQuery.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    enum class TokenType {
+        End,
+        Identifier,
+        Number,
+        String,
+        Operator,  // = == != < <= > >= ~ && || !
+        LeftParen,
+        RightParen,
+        Comma
+    };
+    
+    struct Token {
+        TokenType type = TokenType::End;
+        std::string text;
+        std::string keyword;  // Identifier text lower-cased; keywords, fields and functions ignore case, values don't
+        float number = 0.0f;
+        size_t column = 0;  // 1-based, for error messages
+    };
+    
+    std::string ToLower(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return text;
+    }
+    
+    bool Tokenize(const std::string& text, std::vector<Token>& tokens, std::string& error) {
+        size_t i = 0;
+        while (i < text.size()) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (std::isspace(c)) {
+                ++i;
+                continue;
+            }
+            
+            Token token;
+            token.column = i + 1;
+            if (std::isalpha(c) || c == '_') {
+                size_t start = i;
+                while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) ++i;
+                token.type = TokenType::Identifier;
+                token.text = text.substr(start, i - start);
+                token.keyword = ToLower(token.text);
+            } else if (std::isdigit(c) || c == '.' || (c == '-' && i + 1 < text.size() &&
+                       (std::isdigit(static_cast<unsigned char>(text[i + 1])) || text[i + 1] == '.'))) {
+                const char* begin = text.c_str() + i;
+                char* end = nullptr;
+                token.number = std::strtof(begin, &end);
+                if (end == begin) {
+                    error = "Invalid number at column " + std::to_string(token.column);
+                    return false;
+                }
+                i += end - begin;
+                token.type = TokenType::Number;
+            } else if (c == '"' || c == '\'') {
+                size_t close = text.find(static_cast<char>(c), i + 1);
+                if (close == std::string::npos) {
+                    error = "Unterminated string at column " + std::to_string(token.column);
+                    return false;
+                }
+                token.type = TokenType::String;
+                token.text = text.substr(i + 1, close - i - 1);
+                i = close + 1;
+            } else if (c == '(' || c == ')' || c == ',') {
+                token.type = c == '(' ? TokenType::LeftParen : c == ')' ? TokenType::RightParen : TokenType::Comma;
+                ++i;
+            } else {
+                static const char* const operators[] = { "==", "!=", "<=", ">=", "&&", "||", "=", "<", ">", "~", "!" };
+                for (const char* op : operators) {
+                    if (text.compare(i, std::char_traits<char>::length(op), op) == 0) {
+                        token.text = op;
+                        break;
+                    }
+                }
+                if (token.text.empty()) {
+                    error = std::string("Unexpected '") + text[i] + "' at column " + std::to_string(token.column);
+                    return false;
+                }
+                token.type = TokenType::Operator;
+                i += token.text.size();
+            }
+            tokens.push_back(std::move(token));
+        }
+        
+        Token end;
+        end.column = text.size() + 1;
+        tokens.push_back(end);
+        return true;
+    }
+    
+    bool ParseNumericField(const std::string& name, ZoneField& field) {
+        static const struct { const char* name; ZoneField field; } fields[] = {
+            { "smin", ZoneField::Smin }, { "smax", ZoneField::Smax },
+            { "dmin", ZoneField::Dmin }, { "dmax", ZoneField::Dmax },
+            { "x", ZoneField::X }, { "z", ZoneField::Z },
+            { "r", ZoneField::R }, { "h", ZoneField::H }
+        };
+        for (const auto& entry : fields) {
+            if (name == entry.name) {
+                field = entry.field;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void SetBit(std::vector<uint64_t>& bits, uint32_t index) {
+        bits[index >> 6] |= uint64_t(1) << (index & 63);
+    }
+}
+
+// Recursive descent over the token list:
+//     or      := and (("or" | "||") and)*
+//     and     := unary (("and" | "&&") unary)*
+//     unary   := ("not" | "!") unary | primary
+//     primary := "(" or ")" | function "(" args ")" | field operator value
+class ZoneQuery::Parser {
+public:
+    Parser(const std::vector<Token>& tokens, std::vector<Node>& nodes, const RegionLookup& regions, std::string& error)
+        : tokens_(tokens), nodes_(nodes), regions_(regions), error_(error) {}
+    
+    int ParseAll() {
+        int root = ParseOr();
+        if (root >= 0 && Peek().type != TokenType::End) {
+            return Fail("Unexpected '" + Describe(Peek()) + "'");
+        }
+        return root;
+    }
+    
+private:
+    const std::vector<Token>& tokens_;
+    std::vector<Node>& nodes_;
+    const RegionLookup& regions_;
+    std::string& error_;
+    size_t pos_ = 0;
+    
+    const Token& Peek() const { return tokens_[pos_]; }
+    const Token& Next() { return tokens_[pos_ < tokens_.size() - 1 ? pos_++ : pos_]; }
+    
+    static std::string Describe(const Token& token) {
+        switch (token.type) {
+            case TokenType::End: return "end of query";
+            case TokenType::LeftParen: return "(";
+            case TokenType::RightParen: return ")";
+            case TokenType::Comma: return ",";
+            case TokenType::Number: return "number";
+            case TokenType::String: return "\"" + token.text + "\"";
+            default: return token.text;
+        }
+    }
+    
+    int Fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at column " + std::to_string(Peek().column);
+        }
+        return -1;
+    }
+    
+    bool Accept(TokenType type, const char* text = nullptr) {
+        const std::string& tokenText = type == TokenType::Identifier ? Peek().keyword : Peek().text;
+        if (Peek().type == type && (!text || tokenText == text)) {
+            Next();
+            return true;
+        }
+        return false;
+    }
+    
+    int AddNode(Node node) {
+        nodes_.push_back(std::move(node));
+        return static_cast<int>(nodes_.size() - 1);
+    }
+    
+    int AddBinary(NodeKind kind, int left, int right) {
+        Node node;
+        node.kind = kind;
+        node.left = left;
+        node.right = right;
+        return AddNode(std::move(node));
+    }
+    
+    int ParseOr() {
+        int left = ParseAnd();
+        while (left >= 0 && (Accept(TokenType::Identifier, "or") || Accept(TokenType::Operator, "||"))) {
+            int right = ParseAnd();
+            if (right < 0) return -1;
+            left = AddBinary(NodeKind::Or, left, right);
+        }
+        return left;
+    }
+    
+    int ParseAnd() {
+        int left = ParseUnary();
+        while (left >= 0 && (Accept(TokenType::Identifier, "and") || Accept(TokenType::Operator, "&&"))) {
+            int right = ParseUnary();
+            if (right < 0) return -1;
+            left = AddBinary(NodeKind::And, left, right);
+        }
+        return left;
+    }
+    
+    int ParseUnary() {
+        if (Accept(TokenType::Identifier, "not") || Accept(TokenType::Operator, "!")) {
+            int operand = ParseUnary();
+            if (operand < 0) return -1;
+            return AddBinary(NodeKind::Not, operand, -1);
+        }
+        return ParsePrimary();
+    }
+    
+    int ParsePrimary() {
+        if (Accept(TokenType::LeftParen)) {
+            int inner = ParseOr();
+            if (inner < 0) return -1;
+            if (!Accept(TokenType::RightParen)) return Fail("Expected ')'");
+            return inner;
+        }
+        
+        if (Peek().type != TokenType::Identifier) {
+            return Fail("Expected a field or function, found '" + Describe(Peek()) + "'");
+        }
+        std::string name = Next().keyword;
+        
+        if (Accept(TokenType::LeftParen)) {
+            return ParseFunction(name);
+        }
+        
+        ZoneField field = ZoneField::Smin;
+        bool textField = name == "territory" || name == "name";
+        if (!textField && !ParseNumericField(name, field)) {
+            pos_--;
+            return Fail("Unknown field '" + name + "'");
+        }
+        
+        if (Peek().type != TokenType::Operator) {
+            return Fail("Expected a comparison after '" + name + "'");
+        }
+        static const struct { const char* text; CompareOp op; } operators[] = {
+            { "=", CompareOp::Equal }, { "==", CompareOp::Equal }, { "!=", CompareOp::NotEqual },
+            { "<", CompareOp::Less }, { "<=", CompareOp::LessEqual },
+            { ">", CompareOp::Greater }, { ">=", CompareOp::GreaterEqual }, { "~", CompareOp::Contains }
+        };
+        Node node;
+        bool found = false;
+        for (const auto& entry : operators) {
+            if (Peek().text == entry.text) {
+                node.op = entry.op;
+                found = true;
+            }
+        }
+        bool allowed = textField
+            ? (node.op == CompareOp::Equal || node.op == CompareOp::NotEqual || node.op == CompareOp::Contains)
+            : node.op != CompareOp::Contains;
+        if (!found || !allowed) {
+            return Fail("Operator '" + Peek().text + "' cannot be used with '" + name + "'");
+        }
+        Next();
+        
+        if (textField) {
+            if (Peek().type != TokenType::String && Peek().type != TokenType::Identifier) {
+                return Fail("Expected a quoted name");
+            }
+            node.kind = NodeKind::TextMatch;
+            node.territoryField = name == "territory";
+            node.text = Next().text;
+            if (node.op == CompareOp::Contains) {
+                node.text = ToLower(node.text);
+            }
+        } else {
+            if (Peek().type != TokenType::Number) {
+                return Fail("Expected a number");
+            }
+            node.kind = NodeKind::Compare;
+            node.field = field;
+            node.args[0] = Next().number;
+        }
+        return AddNode(std::move(node));
+    }
+    
+    int ParseFunction(const std::string& name) {
+        Node node;
+        if (name == "region") {
+            if (Peek().type != TokenType::String) return Fail("Expected a quoted region name");
+            std::string regionName = Next().text;
+            const SelectionRegion* region = regions_ ? regions_(regionName) : nullptr;
+            if (!region) {
+                pos_--;
+                return Fail("No saved region named '" + regionName + "'");
+            }
+            node.kind = NodeKind::Region;
+            node.polygon = std::make_shared<PolygonTester>(region->points);
+        } else {
+            int argCount = 0;
+            if (name == "within") {
+                node.kind = NodeKind::Within;
+                argCount = 3;
+            } else if (name == "rect") {
+                node.kind = NodeKind::Rect;
+                argCount = 4;
+            } else {
+                return Fail("Unknown function '" + name + "'");
+            }
+            for (int i = 0; i < argCount; ++i) {
+                if (i > 0 && !Accept(TokenType::Comma)) {
+                    return Fail(name + "() expects " + std::to_string(argCount) + " numbers");
+                }
+                if (Peek().type != TokenType::Number) return Fail("Expected a number");
+                node.args[i] = Next().number;
+            }
+        }
+        if (!Accept(TokenType::RightParen)) return Fail("Expected ')'");
+        return AddNode(std::move(node));
+    }
+};
+
+bool ZoneQuery::Compile(const std::string& text, std::string& error, const RegionLookup& regions) {
+    nodes_.clear();
+    root_ = -1;
+    error.clear();
+    
+    std::vector<Token> tokens;
+    if (!Tokenize(text, tokens, error)) {
+        return false;
+    }
+    if (tokens.size() == 1) {
+        return true;  // Blank query; not an error, just nothing to match
+    }
+    
+    Parser parser(tokens, nodes_, regions, error);
+    root_ = parser.ParseAll();
+    if (root_ < 0) {
+        nodes_.clear();
+        return false;
+    }
+    return true;
+}
+
+void ZoneQuery::Evaluate(ZoneAttributeIndex& attributes, const ZoneIndex& spatial, std::vector<uint32_t>& out) const {
+    out.clear();
+    if (root_ < 0 || attributes.Size() == 0) {
+        return;
+    }
+    
+    Bitset bits;
+    EvaluateNode(root_, attributes, spatial, bits);
+    for (size_t word = 0; word < bits.size(); ++word) {
+        if (!bits[word]) continue;
+        for (uint32_t bit = 0; bit < 64; ++bit) {
+            if ((bits[word] >> bit) & 1) {
+                out.push_back(static_cast<uint32_t>(word * 64 + bit));
+            }
+        }
+    }
+}
+
+void ZoneQuery::EvaluateNode(int index, ZoneAttributeIndex& attributes, const ZoneIndex& spatial, Bitset& bits) const {
+    const Node& node = nodes_[index];
+    size_t count = attributes.Size();
+    size_t words = (count + 63) / 64;
+    bits.assign(words, 0);
+    
+    switch (node.kind) {
+        case NodeKind::And:
+        case NodeKind::Or: {
+            EvaluateNode(node.left, attributes, spatial, bits);
+            Bitset right;
+            EvaluateNode(node.right, attributes, spatial, right);
+            for (size_t i = 0; i < words; ++i) {
+                bits[i] = node.kind == NodeKind::And ? (bits[i] & right[i]) : (bits[i] | right[i]);
+            }
+            break;
+        }
+        case NodeKind::Not: {
+            EvaluateNode(node.left, attributes, spatial, bits);
+            for (auto& word : bits) {
+                word = ~word;
+            }
+            if (count % 64) {
+                bits.back() &= (uint64_t(1) << (count % 64)) - 1;
+            }
+            break;
+        }
+        case NodeKind::Compare: {
+            float value = node.args[0];
+            float inf = INFINITY;
+            auto set = [&bits](uint32_t i) { SetBit(bits, i); };
+            switch (node.op) {
+                case CompareOp::Equal:        attributes.ForEachInRange(node.field, value, true, value, true, set); break;
+                case CompareOp::NotEqual:
+                    attributes.ForEachInRange(node.field, -inf, true, value, false, set);
+                    attributes.ForEachInRange(node.field, value, false, inf, true, set);
+                    break;
+                case CompareOp::Less:         attributes.ForEachInRange(node.field, -inf, true, value, false, set); break;
+                case CompareOp::LessEqual:    attributes.ForEachInRange(node.field, -inf, true, value, true, set); break;
+                case CompareOp::Greater:      attributes.ForEachInRange(node.field, value, false, inf, true, set); break;
+                case CompareOp::GreaterEqual: attributes.ForEachInRange(node.field, value, true, inf, true, set); break;
+                default: break;
+            }
+            break;
+        }
+        case NodeKind::TextMatch: {
+            // Decide each distinct name once; many zones share a name
+            std::vector<int8_t> nameMatches;
+            auto matches = [&](NameId name) {
+                if (name >= nameMatches.size()) {
+                    nameMatches.resize(NameTable::Size(), -1);
+                }
+                if (nameMatches[name] < 0) {
+                    const std::string& text = NameTable::Resolve(name);
+                    bool match = node.op == CompareOp::Contains
+                        ? ToLower(text).find(node.text) != std::string::npos
+                        : text == node.text;
+                    nameMatches[name] = match ? 1 : 0;
+                }
+                return nameMatches[name] == 1;
+            };
+            bool negate = node.op == CompareOp::NotEqual;
+            for (uint32_t i = 0; i < count; ++i) {
+                NameId name = node.territoryField ? attributes.GetTerritoryName(i) : attributes.GetZoneName(i);
+                if (matches(name) != negate) {
+                    SetBit(bits, i);
+                }
+            }
+            break;
+        }
+        case NodeKind::Within:
+            spatial.GetTree().QueryRadius(node.args[0], node.args[1], node.args[2], [&bits](uint32_t id, float) {
+                SetBit(bits, id);
+            });
+            break;
+        case NodeKind::Rect:
+            spatial.GetTree().QueryRect(std::min(node.args[0], node.args[2]), std::min(node.args[1], node.args[3]),
+                                        std::max(node.args[0], node.args[2]), std::max(node.args[1], node.args[3]),
+                                        [&bits](uint32_t id) { SetBit(bits, id); });
+            break;
+        case NodeKind::Region: {
+            const PolygonTester& polygon = *node.polygon;
+            if (!polygon.IsValid()) break;
+            spatial.GetTree().QueryRectPoints(polygon.minX, polygon.minZ, polygon.maxX, polygon.maxZ,
+                                              [&](const KdTree::Point& p) {
+                if (polygon.Contains(p.x, p.z)) {
+                    SetBit(bits, p.id);
+                }
+            });
+            break;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ZoneAttributeIndex.h"
+#include "ZoneIndex.h"
+#include "SelectionRegion.h"
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+// Compiled zone filter, for example
+//     territory ~ "Wolf" and smax > 4 and within(7500, 7500, 2000)
+// Fields: territory, name (=, != or ~ for case-insensitive contains) and
+// smin, smax, dmin, dmax, x, z, r, h (=, !=, <, <=, >, >=). Geometry:
+// within(x, z, radius), rect(minX, minZ, maxX, maxZ) and region("saved region").
+// Terms combine with and/or/not and parentheses.
+//
+// Text is parsed once by Compile(); Evaluate() answers every predicate from the
+// attribute and spatial indexes as a bitset over flat zone indices, so no zone
+// is visited unless some predicate selects it.
+class ZoneQuery {
+public:
+    // Resolves region("name") at compile time; returns nullptr if there is no such region
+    using RegionLookup = std::function<const SelectionRegion*(const std::string& name)>;
+    
+    // Replaces the compiled query; on failure the query is empty and error says why
+    bool Compile(const std::string& text, std::string& error, const RegionLookup& regions = RegionLookup());
+    bool IsEmpty() const { return root_ < 0; }
+    
+    // Flat indices (ascending) of matching zones. Both indexes must be up to date with the same document.
+    void Evaluate(ZoneAttributeIndex& attributes, const ZoneIndex& spatial, std::vector<uint32_t>& out) const;
+    
+private:
+    enum class NodeKind {
+        And,
+        Or,
+        Not,
+        Compare,      // Numeric field against a constant
+        TextMatch,    // territory / name against a string
+        Within,
+        Rect,
+        Region
+    };
+    
+    enum class CompareOp {
+        Equal,
+        NotEqual,
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Contains
+    };
+    
+    struct Node {
+        NodeKind kind = NodeKind::And;
+        int left = -1;
+        int right = -1;
+        CompareOp op = CompareOp::Equal;
+        ZoneField field = ZoneField::Smin;
+        bool territoryField = false;   // TextMatch: territory name rather than zone name
+        std::string text;              // TextMatch operand, lower-cased for Contains
+        float args[4] = {};
+        std::shared_ptr<PolygonTester> polygon;
+    };
+    
+    using Bitset = std::vector<uint64_t>;
+    
+    void EvaluateNode(int index, ZoneAttributeIndex& attributes, const ZoneIndex& spatial, Bitset& bits) const;
+    
+    class Parser;
+    
+    std::vector<Node> nodes_;
+    int root_ = -1;
+};
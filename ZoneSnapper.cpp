@@ -0,0 +1,89 @@
+#include "ZoneSnapper.h"
+#include <algorithm>
+#include <cmath>
+
+void ZoneSnapper::Begin(const TerritoryData& data) {
+    std::vector<KdTree::Point> points;
+    refs_.clear();
+    targetX_.clear();
+    targetZ_.clear();
+    radii_.clear();
+    maxRadius_ = 0.0f;
+    
+    for (uint32_t t = 0; t < data.territories.size(); ++t) {
+        const Territory& territory = data.territories[t];
+        if (!territory.visible) continue;
+        for (uint32_t z = 0; z < territory.zones.size(); ++z) {
+            const Zone& zone = territory.zones[z];
+            if (!zone.visible || zone.selected) continue;
+            points.push_back({ zone.x, zone.z, static_cast<uint32_t>(refs_.size()) });
+            refs_.push_back({ t, z });
+            targetX_.push_back(zone.x);
+            targetZ_.push_back(zone.z);
+            radii_.push_back(zone.r);
+            maxRadius_ = std::max(maxRadius_, zone.r);
+        }
+    }
+    tree_.Build(std::move(points));
+}
+
+void ZoneSnapper::End() {
+    tree_.Clear();
+    refs_.clear();
+    targetX_.clear();
+    targetZ_.clear();
+    radii_.clear();
+    maxRadius_ = 0.0f;
+}
+
+SnapResult ZoneSnapper::Snap(float x, float z, float radius, const SnapSettings& settings, float tolerance) const {
+    SnapResult result;
+    result.x = x;
+    result.z = z;
+    if (!settings.enabled) {
+        return result;
+    }
+    
+    float bestDistance = tolerance;
+    
+    if (settings.centers && !tree_.Empty()) {
+        KdTree::Hit hit;
+        if (tree_.Nearest(x, z, tolerance, hit)) {
+            bestDistance = std::sqrt(hit.distSq);
+            result.x = targetX_[hit.id];
+            result.z = targetZ_[hit.id];
+            result.kind = SnapKind::Center;
+            result.target = refs_[hit.id];
+        }
+    }
+    
+    if (settings.tangent && !tree_.Empty()) {
+        // A tangent neighbor's center is radius + its radius away, so candidates lie within
+        // radius + maxRadius_ (+ tolerance); the nearest few are checked exactly
+        std::vector<KdTree::Hit> hits;
+        tree_.KNearest(x, z, TANGENT_CANDIDATES, radius + maxRadius_ + tolerance, hits);
+        for (const auto& hit : hits) {
+            float distance = std::sqrt(hit.distSq);
+            float touching = radius + radii_[hit.id];
+            float gap = std::fabs(distance - touching);
+            if (distance <= 0.0f || gap >= bestDistance) continue;
+            
+            // Slide along the line between the centers until the circles touch
+            float targetX = targetX_[hit.id];
+            float targetZ = targetZ_[hit.id];
+            float scale = touching / distance;
+            bestDistance = gap;
+            result.x = targetX + (x - targetX) * scale;
+            result.z = targetZ + (z - targetZ) * scale;
+            result.kind = SnapKind::Tangent;
+            result.target = refs_[hit.id];
+        }
+    }
+    
+    if (result.kind == SnapKind::None && settings.grid && settings.gridSize > 0.0f) {
+        result.x = std::round(x / settings.gridSize) * settings.gridSize;
+        result.z = std::round(z / settings.gridSize) * settings.gridSize;
+        result.kind = SnapKind::Grid;
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "TerritoryData.h"
+#include "KdTree.h"
+#include <vector>
+
+struct SnapSettings {
+    bool enabled = false;
+    bool grid = true;
+    float gridSize = 50.0f;   // World units
+    bool centers = true;      // Onto another zone's center
+    bool tangent = true;      // Edge to edge with a neighboring circle
+    float tolerance = 10.0f;  // Screen pixels for center / tangent snaps
+};
+
+enum class SnapKind {
+    None,
+    Grid,
+    Center,
+    Tangent
+};
+
+struct SnapResult {
+    float x = 0.0f;
+    float z = 0.0f;
+    SnapKind kind = SnapKind::None;
+    ZoneRef target;  // Zone snapped to, for Center and Tangent
+};
+
+// Snap targets for a zone drag. Begin() indexes every visible zone that isn't
+// selected (the ones being dragged) in a k-d tree that stays fixed for the
+// whole drag, so each frame costs a couple of nearest-neighbor queries no
+// matter how many zones move or how dense the map is.
+class ZoneSnapper {
+public:
+    void Begin(const TerritoryData& data);
+    void End();
+    
+    // Snapped position for a zone of the given radius proposed at (x, z). Center and tangent
+    // snaps within tolerance (world units) win over the grid; returns the input if nothing applies.
+    SnapResult Snap(float x, float z, float radius, const SnapSettings& settings, float tolerance) const;
+    
+private:
+    static const size_t TANGENT_CANDIDATES = 16;
+    
+    KdTree tree_;
+    // Tree point id -> zone and its center and radius at the start of the drag
+    std::vector<ZoneRef> refs_;
+    std::vector<float> targetX_;
+    std::vector<float> targetZ_;
+    std::vector<float> radii_;
+    float maxRadius_ = 0.0f;
+};
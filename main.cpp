@@ -1,7 +1,17 @@
 #include "Application.h"
+#include "CommandLineTool.h"
+#include "JobSystem.h"
 #include <iostream>
+#include <cstring>
 
 int main(int argc, char* argv[]) {
+    // Headless commands run without creating a window
+    if (CommandLineTool::IsHeadlessCommand(argc, argv)) {
+        int result = CommandLineTool::Run(argc, argv);
+        JobSystem::Stop();
+        return result;
+    }
+    
     Application app;
     
     if (!app.Initialize()) {
@@ -9,8 +19,17 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Load file from command line if provided
-    if (argc > 1) {
+    // "--record <session.rec> [file.xml]" records the input stream for --replay, starting
+    // from the given file so the replay can load the same one
+    if (argc >= 3 && std::strcmp(argv[1], "--record") == 0) {
+        if (argc >= 4 && !app.LoadFileBlocking(argv[3])) {
+            return 1;
+        }
+        if (!app.StartRecording(argv[2])) {
+            return 1;
+        }
+    } else if (argc > 1) {
+        // Load file from command line if provided
         std::string filePath = argv[1];
         // Note: In a real implementation, you'd call a method on app to load the file
         // For now, the user can use File > Open in the UI